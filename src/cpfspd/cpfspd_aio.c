@@ -0,0 +1,598 @@
+/*
+ *  All rights reserved.
+ *  For licensing and warranty information, see the file COPYING.LGPLv21.txt
+ *  in the root directory of this package.
+ *
+ *  Name        :  cpfspd_aio.c
+ *
+ *  Function    :  Asynchronous block I/O engines for the fio layer.
+ *                 -            -
+ *
+ *  Description :  The POSIX file implementation in cpfspd_fio.c can read
+ *                 ahead and write behind in large blocks. This module
+ *                 performs the actual block transfers. The following
+ *                 engines are available:
+ *
+ *                 FIO_AIO_SYNC   The transfer is performed immediately
+ *                                at submission (pread/pwrite). Always
+ *                                available; used as fallback.
+ *
+ *                 FIO_AIO_THREAD A background I/O thread per file
+ *                                performs the transfers in submission
+ *                                order, while the application converts
+ *                                data (like the win32 double buffering).
+ *
+ *                 FIO_AIO_URING  Linux io_uring (kernel 5.1 and later).
+ *                                Blocks are queued in the submission ring
+ *                                and handed to the kernel with a single
+ *                                system call, so multiple blocks are in
+ *                                flight while the application converts
+ *                                data. Only compiled if FIO_IO_URING is
+ *                                defined. We use the system calls directly
+ *                                (no liburing dependency).
+ *
+ *                 The engine does not allocate nor own the blocks; it only
+ *                 administrates which blocks are in flight. The state and
+ *                 result of a block are only changed by the thread that
+ *                 uses the engine (in p_aio_submit and p_aio_wait), so the
+ *                 user may inspect them without locking.
+ *
+ *                 These functions are only used internally in cpfspd.
+ */
+
+/*
+ * We use functions that are not part of ANSI-C (e.g. pread()).
+ * This must precede all includes.
+ */
+#ifdef FIO_POSIX_FILE
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#ifdef FIO_POSIX_FILE
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+
+#ifdef FIO_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#include "cpfspd_aio.h"
+
+
+/******************************************************************************/
+
+/* Completed transfer, passed from the I/O thread */
+typedef struct {
+    fio_block_t   *blk;
+    long          result;
+} fio_aio_done_t;
+
+struct fio_aio_s {
+    int           fd;              /* File descriptor of the file */
+    int           engine;          /* FIO_AIO_* */
+    int           depth;           /* Maximum number of blocks in flight */
+    /* FIO_AIO_THREAD */
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond_work;     /* Signals the I/O thread: block queued or stop */
+    pthread_cond_t  cond_done;     /* Signals the user: transfer completed */
+    int             stop;          /* Request to terminate the I/O thread */
+    fio_block_t     **work;        /* Queue of blocks to transfer (depth entries) */
+    int             work_head;
+    int             work_count;
+    fio_aio_done_t  *done;         /* Queue of completed blocks (depth entries) */
+    int             done_head;
+    int             done_count;
+#ifdef FIO_IO_URING
+    int           ring_fd;         /* io_uring file descriptor */
+    unsigned      queued;          /* Number of sqes not yet submitted to the kernel */
+    void          *sq_ptr;         /* Mapping of submission queue ring */
+    size_t        sq_size;
+    void          *cq_ptr;         /* Mapping of completion queue ring */
+    size_t        cq_size;
+    struct io_uring_sqe *sqes;     /* Mapping of submission queue entries */
+    size_t        sqes_size;
+    unsigned      *sq_head;
+    unsigned      *sq_tail;
+    unsigned      *sq_mask;
+    unsigned      *sq_array;
+    unsigned      *cq_head;
+    unsigned      *cq_tail;
+    unsigned      *cq_mask;
+    struct io_uring_cqe *cqes;
+#endif
+};
+
+
+/*
+ * Synchronous transfer of a block; handles short transfers and EINTR.
+ * Returns the number of bytes transferred, or -errno.
+ */
+static long
+p_aio_transfer (int fd, const fio_block_t *blk)
+{
+    size_t   done = 0;
+    ssize_t  ret;
+
+    while (done < blk->size) {
+        if (blk->write) {
+            ret = pwrite(fd, blk->buf + done, blk->size - done,
+                         (off_t)(blk->offset + (fio_offset_t)done));
+        } else {
+            ret = pread(fd, blk->buf + done, blk->size - done,
+                        (off_t)(blk->offset + (fio_offset_t)done));
+        }
+        if (ret > 0) {
+            done += ret;
+        } else if (ret == 0) {
+            break;  /* end of file */
+        } else if (errno != EINTR) {
+            return(-errno);
+        }
+    }
+
+    return((long)done);
+} /* end of p_aio_transfer */
+
+
+/******************************************************************************/
+/* Background thread engine                                                   */
+
+static void *
+p_thread_main (void *arg)
+{
+    fio_aio_t      *aio = (fio_aio_t *)arg;
+    fio_block_t    *blk;
+    long           result;
+    int            idx;
+
+    pthread_mutex_lock(&aio->lock);
+    for (;;) {
+        while ((aio->work_count == 0) && !aio->stop) {
+            pthread_cond_wait(&aio->cond_work, &aio->lock);
+        }
+        if (aio->work_count == 0) {
+            break;  /* stop requested, and all work done */
+        }
+        blk = aio->work[aio->work_head];
+        aio->work_head = (aio->work_head + 1) % aio->depth;
+        aio->work_count--;
+
+        pthread_mutex_unlock(&aio->lock);
+        result = p_aio_transfer(aio->fd, blk);
+        pthread_mutex_lock(&aio->lock);
+
+        idx = (aio->done_head + aio->done_count) % aio->depth;
+        aio->done[idx].blk    = blk;
+        aio->done[idx].result = result;
+        aio->done_count++;
+        pthread_cond_signal(&aio->cond_done);
+    }
+    pthread_mutex_unlock(&aio->lock);
+
+    return(NULL);
+} /* end of p_thread_main */
+
+
+static int
+p_thread_open (fio_aio_t *aio)
+{
+    aio->work = (fio_block_t **)calloc((size_t)aio->depth, sizeof(fio_block_t *));
+    aio->done = (fio_aio_done_t *)calloc((size_t)aio->depth, sizeof(fio_aio_done_t));
+    if ((aio->work == NULL) || (aio->done == NULL)) {
+        free(aio->work);
+        free(aio->done);
+        return(1);
+    }
+    pthread_mutex_init(&aio->lock, NULL);
+    pthread_cond_init(&aio->cond_work, NULL);
+    pthread_cond_init(&aio->cond_done, NULL);
+    if (pthread_create(&aio->thread, NULL, p_thread_main, aio) != 0) {
+        pthread_cond_destroy(&aio->cond_done);
+        pthread_cond_destroy(&aio->cond_work);
+        pthread_mutex_destroy(&aio->lock);
+        free(aio->work);
+        free(aio->done);
+        return(1);
+    }
+
+    return(0);
+} /* end of p_thread_open */
+
+
+static void
+p_thread_submit (fio_aio_t *aio, fio_block_t *blk)
+{
+    pthread_mutex_lock(&aio->lock);
+    /* No more than depth blocks are in flight, so the queue can never be full */
+    assert(aio->work_count < aio->depth);
+    aio->work[(aio->work_head + aio->work_count) % aio->depth] = blk;
+    aio->work_count++;
+    pthread_cond_signal(&aio->cond_work);
+    pthread_mutex_unlock(&aio->lock);
+} /* end of p_thread_submit */
+
+
+/* Process all available completions; lock shall be held */
+static void
+p_thread_reap (fio_aio_t *aio)
+{
+    fio_aio_done_t *done;
+
+    while (aio->done_count > 0) {
+        done = &aio->done[aio->done_head];
+        done->blk->result = done->result;
+        done->blk->state  = FIO_BLK_DONE;
+        aio->done_head = (aio->done_head + 1) % aio->depth;
+        aio->done_count--;
+    }
+} /* end of p_thread_reap */
+
+
+static void
+p_thread_wait (fio_aio_t *aio, fio_block_t *blk)
+{
+    pthread_mutex_lock(&aio->lock);
+    p_thread_reap(aio);
+    while (blk->state == FIO_BLK_BUSY) {
+        pthread_cond_wait(&aio->cond_done, &aio->lock);
+        p_thread_reap(aio);
+    }
+    pthread_mutex_unlock(&aio->lock);
+} /* end of p_thread_wait */
+
+
+static void
+p_thread_close (fio_aio_t *aio)
+{
+    pthread_mutex_lock(&aio->lock);
+    aio->stop = 1;
+    pthread_cond_signal(&aio->cond_work);
+    pthread_mutex_unlock(&aio->lock);
+    pthread_join(aio->thread, NULL);
+
+    pthread_cond_destroy(&aio->cond_done);
+    pthread_cond_destroy(&aio->cond_work);
+    pthread_mutex_destroy(&aio->lock);
+    free(aio->work);
+    free(aio->done);
+} /* end of p_thread_close */
+
+
+#ifdef FIO_IO_URING
+
+/******************************************************************************/
+/* io_uring engine                                                            */
+
+static int
+p_uring_setup (unsigned entries, struct io_uring_params *p)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+} /* end of p_uring_setup */
+
+
+static int
+p_uring_enter (int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return (int)syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, NULL, 0);
+} /* end of p_uring_enter */
+
+
+static void
+p_uring_unmap (fio_aio_t *aio)
+{
+    if ((aio->sqes != NULL) && (aio->sqes != MAP_FAILED)) {
+        munmap(aio->sqes, aio->sqes_size);
+    }
+    if ((aio->cq_ptr != NULL) && (aio->cq_ptr != MAP_FAILED) && (aio->cq_ptr != aio->sq_ptr)) {
+        munmap(aio->cq_ptr, aio->cq_size);
+    }
+    if ((aio->sq_ptr != NULL) && (aio->sq_ptr != MAP_FAILED)) {
+        munmap(aio->sq_ptr, aio->sq_size);
+    }
+    if (aio->ring_fd >= 0) {
+        close(aio->ring_fd);
+    }
+} /* end of p_uring_unmap */
+
+
+static int
+p_uring_open (fio_aio_t *aio, int depth)
+{
+    struct io_uring_params p;
+    unsigned char          *sq;
+    unsigned char          *cq;
+
+    memset(&p, 0, sizeof(p));
+    aio->ring_fd = p_uring_setup((unsigned)depth, &p);
+    if (aio->ring_fd < 0) {
+        return(1);  /* e.g. old kernel or blocked by security policy */
+    }
+
+    aio->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    aio->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (aio->cq_size > aio->sq_size) {
+            aio->sq_size = aio->cq_size;
+        }
+        aio->cq_size = aio->sq_size;
+    }
+    aio->sq_ptr = mmap(NULL, aio->sq_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, aio->ring_fd, IORING_OFF_SQ_RING);
+    if (aio->sq_ptr == MAP_FAILED) {
+        return(1);
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        aio->cq_ptr = aio->sq_ptr;
+    } else {
+        aio->cq_ptr = mmap(NULL, aio->cq_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, aio->ring_fd, IORING_OFF_CQ_RING);
+        if (aio->cq_ptr == MAP_FAILED) {
+            return(1);
+        }
+    }
+    aio->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    aio->sqes = (struct io_uring_sqe *)mmap(NULL, aio->sqes_size, PROT_READ | PROT_WRITE,
+                                            MAP_SHARED | MAP_POPULATE, aio->ring_fd, IORING_OFF_SQES);
+    if (aio->sqes == MAP_FAILED) {
+        return(1);
+    }
+
+    sq = (unsigned char *)aio->sq_ptr;
+    cq = (unsigned char *)aio->cq_ptr;
+    aio->sq_head  = (unsigned *)(sq + p.sq_off.head);
+    aio->sq_tail  = (unsigned *)(sq + p.sq_off.tail);
+    aio->sq_mask  = (unsigned *)(sq + p.sq_off.ring_mask);
+    aio->sq_array = (unsigned *)(sq + p.sq_off.array);
+    aio->cq_head  = (unsigned *)(cq + p.cq_off.head);
+    aio->cq_tail  = (unsigned *)(cq + p.cq_off.tail);
+    aio->cq_mask  = (unsigned *)(cq + p.cq_off.ring_mask);
+    aio->cqes     = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+    return(0);
+} /* end of p_uring_open */
+
+
+static void
+p_uring_submit (fio_aio_t *aio, fio_block_t *blk)
+{
+    struct io_uring_sqe *sqe;
+    unsigned            tail;
+    unsigned            idx;
+
+    /* The ring has room for depth entries, and no more than depth
+     * blocks are in flight, so the ring can never be full here. */
+    tail = *aio->sq_tail;
+    idx  = tail & *aio->sq_mask;
+    sqe  = &aio->sqes[idx];
+
+    /* blk->result is the number of bytes already transferred */
+    blk->iov.iov_base = blk->buf + blk->result;
+    blk->iov.iov_len  = blk->size - (size_t)blk->result;
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = blk->write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd        = aio->fd;
+    sqe->addr      = (unsigned long long)(uintptr_t)&blk->iov;
+    sqe->len       = 1;
+    sqe->off       = (unsigned long long)(blk->offset + (fio_offset_t)blk->result);
+    sqe->user_data = (unsigned long long)(uintptr_t)blk;
+
+    aio->sq_array[idx] = idx;
+    __atomic_store_n(aio->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    aio->queued++;
+} /* end of p_uring_submit */
+
+
+static int
+p_uring_start (fio_aio_t *aio, unsigned min_complete)
+{
+    int ret;
+
+    while ((aio->queued > 0) || (min_complete > 0)) {
+        ret = p_uring_enter(aio->ring_fd, aio->queued, min_complete,
+                            (min_complete > 0) ? IORING_ENTER_GETEVENTS : 0);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return(-errno);
+        }
+        aio->queued -= (unsigned)ret;
+        if ((min_complete > 0) || (ret == 0)) {
+            break;
+        }
+    }
+
+    return(0);
+} /* end of p_uring_start */
+
+
+/*
+ * Process all available completions. As p_aio_transfer(), a short
+ * transfer or EINTR/EAGAIN resubmits the remainder of the block; the
+ * block completes at its end, at end of file, or at an error.
+ */
+static void
+p_uring_reap (fio_aio_t *aio)
+{
+    struct io_uring_cqe *cqe;
+    fio_block_t         *blk;
+    unsigned            head;
+    unsigned            tail;
+    int                 res;
+
+    head = *aio->cq_head;
+    tail = __atomic_load_n(aio->cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        cqe = &aio->cqes[head & *aio->cq_mask];
+        blk = (fio_block_t *)(uintptr_t)cqe->user_data;
+        res = cqe->res;
+        head++;
+        if (res > 0) {
+            blk->result += res;
+            if ((size_t)blk->result < blk->size) {
+                p_uring_submit(aio, blk);   /* short transfer */
+                continue;
+            }
+        } else if ((res == -EINTR) || (res == -EAGAIN)) {
+            p_uring_submit(aio, blk);
+            continue;
+        } else if (res < 0) {
+            blk->result = res;
+        }
+        /* else: end of file */
+        blk->state = FIO_BLK_DONE;
+    }
+    __atomic_store_n(aio->cq_head, head, __ATOMIC_RELEASE);
+} /* end of p_uring_reap */
+
+#endif /* FIO_IO_URING */
+
+
+/******************************************************************************/
+/* Engine interface                                                           */
+
+fio_aio_t *
+p_aio_open (int fd, int engine, int depth)
+{
+    fio_aio_t *aio;
+
+    aio = (fio_aio_t *)calloc(1, sizeof(fio_aio_t));
+    if (aio == NULL) {
+        return(NULL);
+    }
+    aio->fd     = fd;
+    aio->engine = engine;
+    aio->depth  = depth;
+
+    switch (engine) {
+    case FIO_AIO_SYNC:
+        break;
+    case FIO_AIO_THREAD:
+        if (p_thread_open(aio)) {
+            free(aio);
+            aio = NULL;
+        }
+        break;
+#ifdef FIO_IO_URING
+    case FIO_AIO_URING:
+        aio->ring_fd = -1;
+        if (p_uring_open(aio, depth)) {
+            p_uring_unmap(aio);
+            free(aio);
+            aio = NULL;
+        }
+        break;
+#endif
+    default:
+        /* Engine not available on this platform */
+        free(aio);
+        aio = NULL;
+        break;
+    }
+
+    return(aio);
+} /* end of p_aio_open */
+
+
+void
+p_aio_submit (fio_aio_t *aio, fio_block_t *blk)
+{
+    blk->state  = FIO_BLK_BUSY;
+    blk->result = 0;
+
+    switch (aio->engine) {
+    case FIO_AIO_THREAD:
+        p_thread_submit(aio, blk);
+        break;
+#ifdef FIO_IO_URING
+    case FIO_AIO_URING:
+        p_uring_submit(aio, blk);
+        break;
+#endif
+    default:
+        blk->result = p_aio_transfer(aio->fd, blk);
+        blk->state  = FIO_BLK_DONE;
+        break;
+    }
+} /* end of p_aio_submit */
+
+
+void
+p_aio_start (fio_aio_t *aio)
+{
+#ifdef FIO_IO_URING
+    if (aio->engine == FIO_AIO_URING) {
+        p_uring_start(aio, 0);
+    }
+#endif
+} /* end of p_aio_start */
+
+
+long
+p_aio_wait (fio_aio_t *aio, fio_block_t *blk)
+{
+#ifdef FIO_IO_URING
+    int err;
+#endif
+
+    if (aio->engine == FIO_AIO_THREAD) {
+        p_thread_wait(aio, blk);
+    }
+#ifdef FIO_IO_URING
+
+    if (aio->engine == FIO_AIO_URING) {
+        p_uring_reap(aio);
+        while (blk->state == FIO_BLK_BUSY) {
+            err = p_uring_start(aio, 1);
+            p_uring_reap(aio);
+            if ((err != 0) && (blk->state == FIO_BLK_BUSY)) {
+                /* The ring is unusable; report the failure at this block */
+                blk->result = err;
+                blk->state  = FIO_BLK_DONE;
+            }
+        }
+        /* hand resubmitted remainders of other blocks to the kernel */
+        p_uring_start(aio, 0);
+    }
+#endif
+    assert(blk->state != FIO_BLK_BUSY);
+
+    return(blk->result);
+} /* end of p_aio_wait */
+
+
+void
+p_aio_close (fio_aio_t *aio)
+{
+    if (aio == NULL) {
+        return;
+    }
+    if (aio->engine == FIO_AIO_THREAD) {
+        p_thread_close(aio);
+    }
+#ifdef FIO_IO_URING
+    if (aio->engine == FIO_AIO_URING) {
+        p_uring_unmap(aio);
+    }
+#endif
+    free(aio);
+} /* end of p_aio_close */
+
+#endif /* FIO_POSIX_FILE */
+
+/******************************************************************************/
@@ -0,0 +1,71 @@
+/*
+ *  All rights reserved.
+ *  For licensing and warranty information, see the file COPYING.LGPLv21.txt
+ *  in the root directory of this package.
+ *
+ *  Name        :  cpfspd_aio.h
+ *
+ *  Function    :  Header file for cpfspd_aio.c
+ *
+ *  Description :  Asynchronous block I/O engines, used by the fio layer.
+ *                 Only available with FIO_POSIX_FILE.
+ */
+
+/******************************************************************************/
+
+#ifndef CPFSPD_AIO_H
+#define CPFSPD_AIO_H
+
+/* mandatory include of sys/uio.h; because of use of (struct iovec) */
+#include <sys/uio.h>
+/* mandatory include of cpfspd_fio.h; because of use of fio_offset_t */
+#include "cpfspd_fio.h"
+
+/* Engine types */
+#define FIO_AIO_SYNC        0   /* Synchronous transfers (always available) */
+#define FIO_AIO_URING       1   /* Linux io_uring */
+#define FIO_AIO_THREAD      2   /* Background I/O thread */
+
+/* State of an I/O block */
+typedef enum {
+    FIO_BLK_FREE = 0,           /* Not in use */
+    FIO_BLK_FILL,               /* Being filled with data to write */
+    FIO_BLK_BUSY,               /* Transfer submitted, not yet completed */
+    FIO_BLK_DONE                /* Transfer completed, see result */
+} fio_blk_state;
+
+/* An I/O block: one transfer between a buffer and a file range */
+typedef struct {
+    unsigned char *buf;         /* Data buffer */
+    size_t        size;         /* Number of bytes to transfer */
+    fio_offset_t  offset;       /* File offset of the data */
+    int           write;        /* Transfer direction */
+    fio_blk_state state;        /* Current state */
+    long          result;       /* Bytes transferred, or -errno on failure */
+    unsigned long seq;          /* Submission order (administrated by the user) */
+    struct iovec  iov;          /* Used by the engine */
+} fio_block_t;
+
+typedef struct fio_aio_s fio_aio_t;
+
+/*
+ * Create an engine for file descriptor fd, with at most depth
+ * blocks in flight. Returns NULL if the engine type is not available.
+ */
+extern fio_aio_t *p_aio_open(int fd, int engine, int depth);
+
+/* Queue a block for transfer; the block becomes FIO_BLK_BUSY. */
+extern void p_aio_submit(fio_aio_t *aio, fio_block_t *blk);
+
+/* Hand all queued blocks to the system. */
+extern void p_aio_start(fio_aio_t *aio);
+
+/* Wait until the transfer of blk completed; returns blk->result. */
+extern long p_aio_wait(fio_aio_t *aio, fio_block_t *blk);
+
+/* Release the engine; all blocks shall have completed. */
+extern void p_aio_close(fio_aio_t *aio);
+
+#endif /* end of #ifndef CPFSPD_AIO_H */
+
+/******************************************************************************/
@@ -0,0 +1,893 @@
+/*
+ *  All rights reserved.
+ *  For licensing and warranty information, see the file COPYING.LGPLv21.txt
+ *  in the root directory of this package.
+ *
+ *  Name        :  cpfspd_cnv.c
+ *
+ *  Function    :  CoNVersion kernels of cpfspd.
+ *                   --
+ *
+ *  Description :  Vectorized versions of the sample conversion loops
+ *                 of p_read_image() and p_write_image(). A sample is
+ *                 masked, shifted and
+ *                 masked again in 16 bit lanes; the bits that the
+ *                 scalar code drops by its final mask or store are
+ *                 dropped by the lane width, so the results are bit
+ *                 exact.
+ *
+ *                 A kernel converts the part of a line that fills whole
+ *                 vectors; the scalar code in cpfspd_low.c converts the
+ *                 remaining samples.
+ *
+ *                 The kernels of each instruction set are generated by
+ *                 P_CNV_KERNELS() from a few primitives (load, shift,
+ *                 byte swap, store), one kernel per shift of the
+ *                 samples (-8 .. 8 bits), so the shift is an immediate
+ *                 operand and shifts by zero disappear. On x86, the
+ *                 kernels of SSE2, SSSE3, AVX2 and AVX-512 are all
+ *                 compiled in (gcc and clang compile each function for
+ *                 its own target), and the best one that the processor
+ *                 supports is selected at the first conversion. NEON is
+ *                 compiled in on little endian ARM when the compiler
+ *                 targets it (always on 64 bit ARM).
+ *                 p_set_conversion_isa() overrides the selection.
+ *
+ *                 Exported functions:
+ *                 - p_set_conversion_isa()
+ *                 - p_get_conversion_isa()
+ *
+ *                 Besides, each combination of file and memory format
+ *                 has its own scalar conversion with constant masks and
+ *                 shifts, found in a table by p_convert_line(). It
+ *                 converts the remaining samples.
+ *
+ *                 Functions only used internally in cpfspd:
+ *                 - p_convert_in_vector()
+ *                 - p_convert_out_vector()
+ *                 - p_convert_line()
+ */
+
+/******************************************************************************/
+
+#include <stddef.h>
+
+#include "cpfspd.h"
+#include "cpfspd_low.h"
+#include "cpfspd_thr.h"
+#include "cpfspd_cnv.h"
+
+#if (defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))) || \
+    (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#define P_CNV_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !defined(__ARM_BIG_ENDIAN)
+#define P_CNV_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* Compile a function for an instruction set; msvc needs no attribute */
+#ifdef __GNUC__
+#define P_TARGET(isa)   __attribute__((target(isa)))
+#else
+#define P_TARGET(isa)
+#endif
+
+/******************************************************************************/
+
+/*
+ * The kernels of an instruction set for one shift of the samples,
+ * p_<isa>_convert_in_<sfx>() and p_<isa>_convert_out_<sfx>(). shift
+ * is a constant: positive shifts left, negative shifts right, so the
+ * compiler emits a single shift by an immediate (or none at all).
+ * A vector (vec_t) holds n samples; the loops convert 2*n samples at
+ * a time. The primitives of the base instruction set are:
+ *   p_<base>_par()       masks in vector registers
+ *   p_<base>_shift()     mask, shift and mask n samples
+ *   p_<base>_load_8()    load n samples of 1 byte
+ *   p_<base>_load_16()   load n samples of 2 bytes
+ *   p_<base>_store_8()   store 2*n samples as 1 byte (the low byte)
+ *   p_<base>_store_16()  store n samples of 2 bytes
+ * and p_<isa>_swap() swaps the bytes of n samples.
+ * One loop per combination: no if statements in the inner loop.
+ */
+#define P_CNV_KERNELS(isa, base, vec_t, n, target, sfx, shift)                \
+                                                                              \
+target static int                                                             \
+p_##isa##_convert_in_##sfx (const p_convert_t *cnv,                           \
+                            const unsigned char *src, unsigned char *dst)     \
+{                                                                             \
+    const int         width = cnv->width - cnv->width % (2*(n));              \
+    p_##base##_par_t  par;                                                    \
+    vec_t             lo, hi;                                                 \
+    int               x;                                                      \
+                                                                              \
+    p_##base##_par(cnv, cnv->post_mask, &par);                                \
+                                                                              \
+    if (cnv->file_type == P_UNSIGNED_CHAR) {                                  \
+        if (cnv->mem_type == P_UNSIGNED_CHAR) {                               \
+            return(0);                                                        \
+        }                                                                     \
+        for (x = 0; x < width; x += 2*(n)) {                                  \
+            lo = p_##base##_load_8(src + x);                                  \
+            hi = p_##base##_load_8(src + x + (n));                            \
+            p_##base##_store_16(dst + 2*x, p_##base##_shift(lo, &par, shift)); \
+            p_##base##_store_16(dst + 2*(x + (n)), p_##base##_shift(hi, &par, shift)); \
+        }                                                                     \
+    } else if (cnv->little_endian) {                                          \
+        if (cnv->mem_type == P_UNSIGNED_CHAR) {                               \
+            for (x = 0; x < width; x += 2*(n)) {                              \
+                lo = p_##base##_load_16(src + 2*x);                           \
+                hi = p_##base##_load_16(src + 2*(x + (n)));                   \
+                p_##base##_store_8(dst + x, p_##base##_shift(lo, &par, shift), \
+                                            p_##base##_shift(hi, &par, shift)); \
+            }                                                                 \
+        } else {                                                              \
+            for (x = 0; x < width; x += 2*(n)) {                              \
+                lo = p_##base##_load_16(src + 2*x);                           \
+                hi = p_##base##_load_16(src + 2*(x + (n)));                   \
+                p_##base##_store_16(dst + 2*x, p_##base##_shift(lo, &par, shift)); \
+                p_##base##_store_16(dst + 2*(x + (n)), p_##base##_shift(hi, &par, shift)); \
+            }                                                                 \
+        }                                                                     \
+    } else {                                                                  \
+        if (cnv->mem_type == P_UNSIGNED_CHAR) {                               \
+            for (x = 0; x < width; x += 2*(n)) {                              \
+                lo = p_##isa##_swap(p_##base##_load_16(src + 2*x));           \
+                hi = p_##isa##_swap(p_##base##_load_16(src + 2*(x + (n))));   \
+                p_##base##_store_8(dst + x, p_##base##_shift(lo, &par, shift), \
+                                            p_##base##_shift(hi, &par, shift)); \
+            }                                                                 \
+        } else {                                                              \
+            for (x = 0; x < width; x += 2*(n)) {                              \
+                lo = p_##isa##_swap(p_##base##_load_16(src + 2*x));           \
+                hi = p_##isa##_swap(p_##base##_load_16(src + 2*(x + (n))));   \
+                p_##base##_store_16(dst + 2*x, p_##base##_shift(lo, &par, shift)); \
+                p_##base##_store_16(dst + 2*(x + (n)), p_##base##_shift(hi, &par, shift)); \
+            }                                                                 \
+        }                                                                     \
+    }                                                                         \
+    return(width);                                                            \
+}                                                                             \
+                                                                              \
+target static int                                                             \
+p_##isa##_convert_out_##sfx (const p_convert_t *cnv,                          \
+                             const unsigned char *src, unsigned char *dst)    \
+{                                                                             \
+    const int         width = cnv->width - cnv->width % (2*(n));              \
+    p_##base##_par_t  par;                                                    \
+    vec_t             lo, hi;                                                 \
+    int               x;                                                      \
+                                                                              \
+    p_##base##_par(cnv, 0xffffu, &par);                                       \
+                                                                              \
+    if (cnv->file_type == P_UNSIGNED_CHAR) {                                  \
+        if (cnv->mem_type == P_UNSIGNED_CHAR) {                               \
+            return(0);                                                        \
+        }                                                                     \
+        for (x = 0; x < width; x += 2*(n)) {                                  \
+            lo = p_##base##_load_16(src + 2*x);                               \
+            hi = p_##base##_load_16(src + 2*(x + (n)));                       \
+            p_##base##_store_8(dst + x, p_##base##_shift(lo, &par, shift),    \
+                                        p_##base##_shift(hi, &par, shift));   \
+        }                                                                     \
+    } else if (cnv->little_endian) {                                          \
+        if (cnv->mem_type == P_UNSIGNED_CHAR) {                               \
+            for (x = 0; x < width; x += 2*(n)) {                              \
+                lo = p_##base##_load_8(src + x);                              \
+                hi = p_##base##_load_8(src + x + (n));                        \
+                p_##base##_store_16(dst + 2*x, p_##base##_shift(lo, &par, shift)); \
+                p_##base##_store_16(dst + 2*(x + (n)), p_##base##_shift(hi, &par, shift)); \
+            }                                                                 \
+        } else {                                                              \
+            for (x = 0; x < width; x += 2*(n)) {                              \
+                lo = p_##base##_load_16(src + 2*x);                           \
+                hi = p_##base##_load_16(src + 2*(x + (n)));                   \
+                p_##base##_store_16(dst + 2*x, p_##base##_shift(lo, &par, shift)); \
+                p_##base##_store_16(dst + 2*(x + (n)), p_##base##_shift(hi, &par, shift)); \
+            }                                                                 \
+        }                                                                     \
+    } else {                                                                  \
+        if (cnv->mem_type == P_UNSIGNED_CHAR) {                               \
+            for (x = 0; x < width; x += 2*(n)) {                              \
+                lo = p_##base##_shift(p_##base##_load_8(src + x), &par, shift); \
+                hi = p_##base##_shift(p_##base##_load_8(src + x + (n)), &par, shift); \
+                p_##base##_store_16(dst + 2*x, p_##isa##_swap(lo));           \
+                p_##base##_store_16(dst + 2*(x + (n)), p_##isa##_swap(hi));   \
+            }                                                                 \
+        } else {                                                              \
+            for (x = 0; x < width; x += 2*(n)) {                              \
+                lo = p_##base##_shift(p_##base##_load_16(src + 2*x), &par, shift); \
+                hi = p_##base##_shift(p_##base##_load_16(src + 2*(x + (n))), &par, shift); \
+                p_##base##_store_16(dst + 2*x, p_##isa##_swap(lo));           \
+                p_##base##_store_16(dst + 2*(x + (n)), p_##isa##_swap(hi));   \
+            }                                                                 \
+        }                                                                     \
+    }                                                                         \
+    return(width);                                                            \
+}
+
+/* The kernels of an instruction set for all shifts: -8 .. 8 bits */
+#define P_CNV_SHIFTS(isa, base, vec_t, n, target)                             \
+    P_CNV_KERNELS(isa, base, vec_t, n, target, r8, -8)                        \
+    P_CNV_KERNELS(isa, base, vec_t, n, target, r6, -6)                        \
+    P_CNV_KERNELS(isa, base, vec_t, n, target, r4, -4)                        \
+    P_CNV_KERNELS(isa, base, vec_t, n, target, r2, -2)                        \
+    P_CNV_KERNELS(isa, base, vec_t, n, target, 0,   0)                        \
+    P_CNV_KERNELS(isa, base, vec_t, n, target, l2,  2)                        \
+    P_CNV_KERNELS(isa, base, vec_t, n, target, l4,  4)                        \
+    P_CNV_KERNELS(isa, base, vec_t, n, target, l6,  6)                        \
+    P_CNV_KERNELS(isa, base, vec_t, n, target, l8,  8)
+
+/* Number of shifts, and the table of the kernels of an instruction set */
+#define P_CNV_NUM_SHIFTS    9
+#define P_CNV_SHIFT_ROW(isa, dir)                                             \
+    { p_##isa##_convert_##dir##_r8, p_##isa##_convert_##dir##_r6,             \
+      p_##isa##_convert_##dir##_r4, p_##isa##_convert_##dir##_r2,             \
+      p_##isa##_convert_##dir##_0,  p_##isa##_convert_##dir##_l2,             \
+      p_##isa##_convert_##dir##_l4, p_##isa##_convert_##dir##_l6,             \
+      p_##isa##_convert_##dir##_l8 }
+
+/******************************************************************************/
+
+#ifdef P_CNV_X86
+
+/* SSE2: 8 samples per vector */
+typedef struct {
+    __m128i pre_mask;
+    __m128i post_mask;
+} p_sse2_par_t;
+
+P_TARGET("sse2") static void
+p_sse2_par (const p_convert_t *cnv, unsigned int post_mask, p_sse2_par_t *par)
+{
+    par->pre_mask    = _mm_set1_epi16((short)cnv->pre_mask);
+    par->post_mask   = _mm_set1_epi16((short)post_mask);
+} /* p_sse2_par () */
+
+
+P_TARGET("sse2") static __m128i
+p_sse2_shift (__m128i v, const p_sse2_par_t *par, const int shift)
+{
+    v = _mm_and_si128(v, par->pre_mask);
+    if (shift > 0) {
+        v = _mm_slli_epi16(v, shift);
+    } else if (shift < 0) {
+        v = _mm_srli_epi16(v, -shift);
+    }
+    return(_mm_and_si128(v, par->post_mask));
+} /* p_sse2_shift () */
+
+
+P_TARGET("sse2") static __m128i
+p_sse2_load_8 (const unsigned char *src)
+{
+    return(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)src),
+                             _mm_setzero_si128()));
+} /* p_sse2_load_8 () */
+
+
+P_TARGET("sse2") static __m128i
+p_sse2_load_16 (const unsigned char *src)
+{
+    return(_mm_loadu_si128((const __m128i *)src));
+} /* p_sse2_load_16 () */
+
+
+P_TARGET("sse2") static void
+p_sse2_store_8 (unsigned char *dst, __m128i lo, __m128i hi)
+{
+    const __m128i low_byte = _mm_set1_epi16(0x00ff);
+
+    /* packus saturates: drop the high bytes first */
+    _mm_storeu_si128((__m128i *)dst,
+                     _mm_packus_epi16(_mm_and_si128(lo, low_byte),
+                                      _mm_and_si128(hi, low_byte)));
+} /* p_sse2_store_8 () */
+
+
+P_TARGET("sse2") static void
+p_sse2_store_16 (unsigned char *dst, __m128i v)
+{
+    _mm_storeu_si128((__m128i *)dst, v);
+} /* p_sse2_store_16 () */
+
+
+P_TARGET("sse2") static __m128i
+p_sse2_swap (__m128i v)
+{
+    return(_mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+} /* p_sse2_swap () */
+
+
+/* SSSE3: the SSE2 primitives, with a byte shuffle to swap */
+P_TARGET("ssse3") static __m128i
+p_ssse3_swap (__m128i v)
+{
+    return(_mm_shuffle_epi8(v, _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6,
+                                             9, 8, 11, 10, 13, 12, 15, 14)));
+} /* p_ssse3_swap () */
+
+
+/* AVX2: 16 samples per vector */
+typedef struct {
+    __m256i pre_mask;
+    __m256i post_mask;
+} p_avx2_par_t;
+
+P_TARGET("avx2") static void
+p_avx2_par (const p_convert_t *cnv, unsigned int post_mask, p_avx2_par_t *par)
+{
+    par->pre_mask    = _mm256_set1_epi16((short)cnv->pre_mask);
+    par->post_mask   = _mm256_set1_epi16((short)post_mask);
+} /* p_avx2_par () */
+
+
+P_TARGET("avx2") static __m256i
+p_avx2_shift (__m256i v, const p_avx2_par_t *par, const int shift)
+{
+    v = _mm256_and_si256(v, par->pre_mask);
+    if (shift > 0) {
+        v = _mm256_slli_epi16(v, shift);
+    } else if (shift < 0) {
+        v = _mm256_srli_epi16(v, -shift);
+    }
+    return(_mm256_and_si256(v, par->post_mask));
+} /* p_avx2_shift () */
+
+
+P_TARGET("avx2") static __m256i
+p_avx2_load_8 (const unsigned char *src)
+{
+    return(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)src)));
+} /* p_avx2_load_8 () */
+
+
+P_TARGET("avx2") static __m256i
+p_avx2_load_16 (const unsigned char *src)
+{
+    return(_mm256_loadu_si256((const __m256i *)src));
+} /* p_avx2_load_16 () */
+
+
+P_TARGET("avx2") static void
+p_avx2_store_8 (unsigned char *dst, __m256i lo, __m256i hi)
+{
+    const __m256i low_byte = _mm256_set1_epi16(0x00ff);
+    __m256i       packed;
+
+    packed = _mm256_packus_epi16(_mm256_and_si256(lo, low_byte),
+                                 _mm256_and_si256(hi, low_byte));
+    /* packus works per 128 bit lane: restore the sample order */
+    _mm256_storeu_si256((__m256i *)dst, _mm256_permute4x64_epi64(packed, 0xd8));
+} /* p_avx2_store_8 () */
+
+
+P_TARGET("avx2") static void
+p_avx2_store_16 (unsigned char *dst, __m256i v)
+{
+    _mm256_storeu_si256((__m256i *)dst, v);
+} /* p_avx2_store_16 () */
+
+
+P_TARGET("avx2") static __m256i
+p_avx2_swap (__m256i v)
+{
+    return(_mm256_shuffle_epi8(v, _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6,
+                                                   9, 8, 11, 10, 13, 12, 15, 14,
+                                                   1, 0, 3, 2, 5, 4, 7, 6,
+                                                   9, 8, 11, 10, 13, 12, 15, 14)));
+} /* p_avx2_swap () */
+
+
+/* AVX-512 (with byte and word instructions): 32 samples per vector */
+typedef struct {
+    __m512i pre_mask;
+    __m512i post_mask;
+} p_avx512_par_t;
+
+P_TARGET("avx512bw") static void
+p_avx512_par (const p_convert_t *cnv, unsigned int post_mask, p_avx512_par_t *par)
+{
+    par->pre_mask    = _mm512_set1_epi16((short)cnv->pre_mask);
+    par->post_mask   = _mm512_set1_epi16((short)post_mask);
+} /* p_avx512_par () */
+
+
+P_TARGET("avx512bw") static __m512i
+p_avx512_shift (__m512i v, const p_avx512_par_t *par, const int shift)
+{
+    v = _mm512_and_si512(v, par->pre_mask);
+    if (shift > 0) {
+        v = _mm512_slli_epi16(v, (unsigned int)shift);
+    } else if (shift < 0) {
+        v = _mm512_srli_epi16(v, (unsigned int)-shift);
+    }
+    return(_mm512_and_si512(v, par->post_mask));
+} /* p_avx512_shift () */
+
+
+P_TARGET("avx512bw") static __m512i
+p_avx512_load_8 (const unsigned char *src)
+{
+    return(_mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)src)));
+} /* p_avx512_load_8 () */
+
+
+P_TARGET("avx512bw") static __m512i
+p_avx512_load_16 (const unsigned char *src)
+{
+    return(_mm512_loadu_si512((const void *)src));
+} /* p_avx512_load_16 () */
+
+
+P_TARGET("avx512bw") static void
+p_avx512_store_8 (unsigned char *dst, __m512i lo, __m512i hi)
+{
+    /* truncating narrowing, in sample order */
+    _mm256_storeu_si256((__m256i *)dst,        _mm512_cvtepi16_epi8(lo));
+    _mm256_storeu_si256((__m256i *)(dst + 32), _mm512_cvtepi16_epi8(hi));
+} /* p_avx512_store_8 () */
+
+
+P_TARGET("avx512bw") static void
+p_avx512_store_16 (unsigned char *dst, __m512i v)
+{
+    _mm512_storeu_si512((void *)dst, v);
+} /* p_avx512_store_16 () */
+
+
+P_TARGET("avx512bw") static __m512i
+p_avx512_swap (__m512i v)
+{
+    const __m128i order = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6,
+                                        9, 8, 11, 10, 13, 12, 15, 14);
+
+    return(_mm512_shuffle_epi8(v, _mm512_broadcast_i32x4(order)));
+} /* p_avx512_swap () */
+
+
+P_CNV_SHIFTS(sse2,   sse2,   __m128i, 8,  P_TARGET("sse2"))
+P_CNV_SHIFTS(ssse3,  sse2,   __m128i, 8,  P_TARGET("ssse3"))
+P_CNV_SHIFTS(avx2,   avx2,   __m256i, 16, P_TARGET("avx2"))
+P_CNV_SHIFTS(avx512, avx512, __m512i, 32, P_TARGET("avx512bw"))
+
+#endif /* P_CNV_X86 */
+
+/******************************************************************************/
+
+#ifdef P_CNV_NEON
+
+/* NEON: 8 samples per vector */
+typedef struct {
+    uint16x8_t pre_mask;
+    uint16x8_t post_mask;
+} p_neon_par_t;
+
+static void
+p_neon_par (const p_convert_t *cnv, unsigned int post_mask, p_neon_par_t *par)
+{
+    par->pre_mask    = vdupq_n_u16((uint16_t)cnv->pre_mask);
+    par->post_mask   = vdupq_n_u16((uint16_t)post_mask);
+} /* p_neon_par () */
+
+
+static uint16x8_t
+p_neon_shift (uint16x8_t v, const p_neon_par_t *par, const int shift)
+{
+    v = vandq_u16(v, par->pre_mask);
+    if (shift != 0) {
+        /* a constant count: a shift by an immediate; negative shifts right */
+        v = vshlq_u16(v, vdupq_n_s16((int16_t)shift));
+    }
+    return(vandq_u16(v, par->post_mask));
+} /* p_neon_shift () */
+
+
+static uint16x8_t
+p_neon_load_8 (const unsigned char *src)
+{
+    return(vmovl_u8(vld1_u8(src)));
+} /* p_neon_load_8 () */
+
+
+static uint16x8_t
+p_neon_load_16 (const unsigned char *src)
+{
+    return(vreinterpretq_u16_u8(vld1q_u8(src)));
+} /* p_neon_load_16 () */
+
+
+static void
+p_neon_store_8 (unsigned char *dst, uint16x8_t lo, uint16x8_t hi)
+{
+    vst1q_u8(dst, vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+} /* p_neon_store_8 () */
+
+
+static void
+p_neon_store_16 (unsigned char *dst, uint16x8_t v)
+{
+    vst1q_u8(dst, vreinterpretq_u8_u16(v));
+} /* p_neon_store_16 () */
+
+
+static uint16x8_t
+p_neon_swap (uint16x8_t v)
+{
+    return(vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(v))));
+} /* p_neon_swap () */
+
+
+P_CNV_SHIFTS(neon, neon, uint16x8_t, 8, )
+
+#endif /* P_CNV_NEON */
+
+/******************************************************************************/
+
+/*
+ * Specialized conversion of a line, one function per combination of
+ * file format (bits and byte order) and memory format. Each is
+ * generated from the scalar conversion with constant masks and shifts,
+ * so shifts by zero disappear and the compiler can unroll and
+ * vectorize the loop. They convert the samples that the vector kernels
+ * leave, or all samples when there are no vector kernels.
+ */
+
+#define P_MASK(bits)        ((1u << (bits)) - 1u)
+#define P_SHIFT(from, to)   (((from) > (to)) ? (from) - (to) : 0)
+
+/* file samples: 8 bits, 16 bits little or big endian */
+#define P_LOAD_B(p, x)      ((unsigned int)(p)[x])
+#define P_LOAD_LE(p, x)     ((unsigned int)(p)[2*(x)] | ((unsigned int)(p)[2*(x)+1] << 8))
+#define P_LOAD_BE(p, x)     (((unsigned int)(p)[2*(x)] << 8) | (unsigned int)(p)[2*(x)+1])
+#define P_STORE_B(p, x, s)  ((p)[x] = (unsigned char)(s))
+#define P_STORE_LE(p, x, s) ((p)[2*(x)] = (unsigned char)(s), (p)[2*(x)+1] = (unsigned char)((s) >> 8))
+#define P_STORE_BE(p, x, s) ((p)[2*(x)] = (unsigned char)((s) >> 8), (p)[2*(x)+1] = (unsigned char)(s))
+
+/* memory samples: unsigned char or unsigned short */
+typedef unsigned char   p_mem_u8_t;
+typedef unsigned short  p_mem_u16_t;
+
+/* file samples of f bits (file) into memory samples of m bits (mem) */
+#define P_CNV_IN(file, f, load, mem, type, m, post_mask)                      \
+static void                                                                   \
+p_cnv_in_##file##_##mem (const void *src, void *dst, int first, int width)    \
+{                                                                             \
+    const unsigned char *file_buffer = (const unsigned char *)src;            \
+    p_mem_##type##_t    *mem_buffer  = (p_mem_##type##_t *)dst;               \
+    unsigned int        sample;                                               \
+    int                 x;                                                    \
+                                                                              \
+    for (x = first; x < width; x++) {                                         \
+        sample = load(file_buffer, x) & P_MASK(f);                            \
+        sample = (sample >> P_SHIFT(f, m)) << P_SHIFT(m, f);                  \
+        mem_buffer[x] = (p_mem_##type##_t)(sample & (post_mask));             \
+    }                                                                         \
+}
+
+/* memory samples of m bits (mem) into file samples of f bits (file) */
+#define P_CNV_OUT(file, f, store, mem, type, m)                               \
+static void                                                                   \
+p_cnv_out_##file##_##mem (const void *src, void *dst, int first, int width)   \
+{                                                                             \
+    const p_mem_##type##_t *mem_buffer  = (const p_mem_##type##_t *)src;      \
+    unsigned char          *file_buffer = (unsigned char *)dst;               \
+    unsigned int           sample;                                            \
+    int                    x;                                                 \
+                                                                              \
+    for (x = first; x < width; x++) {                                         \
+        sample = (unsigned int)mem_buffer[x] & P_MASK(m);                     \
+        sample = (sample >> P_SHIFT(m, f)) << P_SHIFT(f, m);                  \
+        store(file_buffer, x, sample);                                        \
+    }                                                                         \
+}
+
+/* all memory formats of one file format */
+#define P_CNV_FILE(file, f, load, store)                                      \
+    P_CNV_IN(file, f, load, c8,  u8,  8,  0xffffu)                            \
+    P_CNV_IN(file, f, load, c10, u8,  10, 0xffffu)                            \
+    P_CNV_IN(file, f, load, c12, u8,  12, 0xffffu)                            \
+    P_CNV_IN(file, f, load, c14, u8,  14, 0xffffu)                            \
+    P_CNV_IN(file, f, load, c16, u8,  16, 0xffffu)                            \
+    P_CNV_IN(file, f, load, s8,  u16, 8,  0xffffu)                            \
+    P_CNV_IN(file, f, load, s10, u16, 10, 0xffffu)                            \
+    P_CNV_IN(file, f, load, s12, u16, 12, 0xffffu)                            \
+    P_CNV_IN(file, f, load, s14, u16, 14, 0xffffu)                            \
+    P_CNV_IN(file, f, load, s16, u16, 16, 0xffffu)                            \
+    P_CNV_IN(file, f, load, lsb, u16, 16, 0x00ffu)                            \
+    P_CNV_OUT(file, f, store, c8,  u8,  8)                                    \
+    P_CNV_OUT(file, f, store, c10, u8,  10)                                   \
+    P_CNV_OUT(file, f, store, c12, u8,  12)                                   \
+    P_CNV_OUT(file, f, store, c14, u8,  14)                                   \
+    P_CNV_OUT(file, f, store, c16, u8,  16)                                   \
+    P_CNV_OUT(file, f, store, s8,  u16, 8)                                    \
+    P_CNV_OUT(file, f, store, s10, u16, 10)                                   \
+    P_CNV_OUT(file, f, store, s12, u16, 12)                                   \
+    P_CNV_OUT(file, f, store, s14, u16, 14)                                   \
+    P_CNV_OUT(file, f, store, s16, u16, 16)
+
+P_CNV_FILE(8,    8,  P_LOAD_B,  P_STORE_B)
+P_CNV_FILE(10le, 10, P_LOAD_LE, P_STORE_LE)
+P_CNV_FILE(10be, 10, P_LOAD_BE, P_STORE_BE)
+P_CNV_FILE(12le, 12, P_LOAD_LE, P_STORE_LE)
+P_CNV_FILE(12be, 12, P_LOAD_BE, P_STORE_BE)
+P_CNV_FILE(14le, 14, P_LOAD_LE, P_STORE_LE)
+P_CNV_FILE(14be, 14, P_LOAD_BE, P_STORE_BE)
+P_CNV_FILE(16le, 16, P_LOAD_LE, P_STORE_LE)
+P_CNV_FILE(16be, 16, P_LOAD_BE, P_STORE_BE)
+
+/* Number of file formats (rows) and memory formats (columns) */
+#define P_CNV_FILE_FMTS     9
+#define P_CNV_MEM_FMTS      11
+
+/* Specialized conversions, indexed by file format and memory format */
+#define P_CNV_IN_ROW(file)                                                    \
+    { p_cnv_in_##file##_c8,  p_cnv_in_##file##_c10, p_cnv_in_##file##_c12,    \
+      p_cnv_in_##file##_c14, p_cnv_in_##file##_c16,                           \
+      p_cnv_in_##file##_s8,  p_cnv_in_##file##_s10, p_cnv_in_##file##_s12,    \
+      p_cnv_in_##file##_s14, p_cnv_in_##file##_s16,                           \
+      p_cnv_in_##file##_lsb }
+#define P_CNV_OUT_ROW(file)                                                   \
+    { p_cnv_out_##file##_c8,  p_cnv_out_##file##_c10, p_cnv_out_##file##_c12, \
+      p_cnv_out_##file##_c14, p_cnv_out_##file##_c16,                         \
+      p_cnv_out_##file##_s8,  p_cnv_out_##file##_s10, p_cnv_out_##file##_s12, \
+      p_cnv_out_##file##_s14, p_cnv_out_##file##_s16,                         \
+      NULL }
+
+static const p_convert_line_t p_cnv_in_table[P_CNV_FILE_FMTS][P_CNV_MEM_FMTS] = {
+    P_CNV_IN_ROW(8),
+    P_CNV_IN_ROW(10le), P_CNV_IN_ROW(10be),
+    P_CNV_IN_ROW(12le), P_CNV_IN_ROW(12be),
+    P_CNV_IN_ROW(14le), P_CNV_IN_ROW(14be),
+    P_CNV_IN_ROW(16le), P_CNV_IN_ROW(16be)
+};
+
+static const p_convert_line_t p_cnv_out_table[P_CNV_FILE_FMTS][P_CNV_MEM_FMTS] = {
+    P_CNV_OUT_ROW(8),
+    P_CNV_OUT_ROW(10le), P_CNV_OUT_ROW(10be),
+    P_CNV_OUT_ROW(12le), P_CNV_OUT_ROW(12be),
+    P_CNV_OUT_ROW(14le), P_CNV_OUT_ROW(14be),
+    P_CNV_OUT_ROW(16le), P_CNV_OUT_ROW(16be)
+};
+
+/******************************************************************************/
+
+/* Kernels of an instruction set, indexed by pT_isa and by shift */
+typedef int (*p_cnv_func)(const p_convert_t *cnv,
+                          const unsigned char *src, unsigned char *dst);
+
+typedef struct {
+    p_cnv_func  in[P_CNV_NUM_SHIFTS];
+    p_cnv_func  out[P_CNV_NUM_SHIFTS];
+} p_cnv_kernels_t;
+
+static const p_cnv_kernels_t p_cnv_kernels[] = {
+    { { NULL }, { NULL } },                                             /* P_ISA_NONE   */
+#ifdef P_CNV_X86
+    { P_CNV_SHIFT_ROW(sse2, in),   P_CNV_SHIFT_ROW(sse2, out)   },      /* P_ISA_SSE2   */
+    { P_CNV_SHIFT_ROW(ssse3, in),  P_CNV_SHIFT_ROW(ssse3, out)  },      /* P_ISA_SSSE3  */
+    { P_CNV_SHIFT_ROW(avx2, in),   P_CNV_SHIFT_ROW(avx2, out)   },      /* P_ISA_AVX2   */
+    { P_CNV_SHIFT_ROW(avx512, in), P_CNV_SHIFT_ROW(avx512, out) },      /* P_ISA_AVX512 */
+#else
+    { { NULL }, { NULL } }, { { NULL }, { NULL } },
+    { { NULL }, { NULL } }, { { NULL }, { NULL } },
+#endif
+#ifdef P_CNV_NEON
+    { P_CNV_SHIFT_ROW(neon, in),   P_CNV_SHIFT_ROW(neon, out)   }       /* P_ISA_NEON   */
+#else
+    { { NULL }, { NULL } }
+#endif
+};
+
+/*
+ * Instruction set in use; P_ISA_AUTO until detected. Detection gives
+ * the same result in every thread, so it needs no lock.
+ */
+static p_atomic_t p_cnv_isa = P_ISA_AUTO;
+
+
+/* Does the processor (and OS) support the kernels of an instruction set? */
+static int
+p_cpu_supports (pT_isa isa)
+{
+    if ((isa <= P_ISA_NONE) || (isa > P_ISA_NEON) ||
+        (p_cnv_kernels[isa].in[0] == NULL)) {
+        return(0);
+    }
+#if defined(P_CNV_X86) && defined(_MSC_VER)
+    {
+        int          info[4];
+        int          ecx1 = 0;
+        int          edx1 = 0;
+        int          ebx7 = 0;
+        unsigned int xcr0 = 0;
+
+        __cpuid(info, 0);
+        if (info[0] >= 7) {
+            __cpuidex(info, 7, 0);
+            ebx7 = info[1];
+        }
+        __cpuid(info, 1);
+        ecx1 = info[2];
+        edx1 = info[3];
+        if (ecx1 & (1 << 27)) {
+            /* OSXSAVE: the OS reports which registers it saves */
+            xcr0 = (unsigned int)_xgetbv(0);
+        }
+        switch (isa) {
+        case P_ISA_SSE2:
+            return((edx1 >> 26) & 1);
+        case P_ISA_SSSE3:
+            return((ecx1 >> 9) & 1);
+        case P_ISA_AVX2:
+            return(((ebx7 >> 5) & 1) && ((xcr0 & 0x06) == 0x06));
+        case P_ISA_AVX512:
+            return(((ebx7 >> 16) & 1) && ((ebx7 >> 30) & 1) &&
+                   ((xcr0 & 0xe6) == 0xe6));
+        default:
+            return(0);
+        }
+    }
+#elif defined(P_CNV_X86)
+    /* includes the check that the OS saves the registers */
+    switch (isa) {
+    case P_ISA_SSE2:
+        return(__builtin_cpu_supports("sse2"));
+    case P_ISA_SSSE3:
+        return(__builtin_cpu_supports("ssse3"));
+    case P_ISA_AVX2:
+        return(__builtin_cpu_supports("avx2"));
+    case P_ISA_AVX512:
+        return(__builtin_cpu_supports("avx512bw"));
+    default:
+        return(0);
+    }
+#else
+    /* NEON is only compiled in when the compiler targets it */
+    return(1);
+#endif
+} /* p_cpu_supports () */
+
+
+/* Instruction set in use; detected at the first call */
+static pT_isa
+p_cnv_isa_get (void)
+{
+    long isa = p_atomic_get(&p_cnv_isa);
+
+    if (isa == P_ISA_AUTO) {
+        /* the best one the processor supports */
+        isa = P_ISA_NEON;
+        while ((isa > P_ISA_NONE) && !p_cpu_supports((pT_isa)isa)) {
+            isa--;
+        }
+        p_atomic_set(&p_cnv_isa, isa);
+    }
+    return((pT_isa)isa);
+} /* p_cnv_isa_get () */
+
+/******************************************************************************/
+
+/* Index of the kernels for the shift of a conversion; -1 if none */
+static int
+p_cnv_shift_index (const p_convert_t *cnv)
+{
+    const int shift = cnv->shift_left_factor - cnv->shift_right_factor;
+
+    if ((shift < -8) || (shift > 8) || (shift % 2 != 0)) {
+        return(-1);
+    }
+    return((shift + 8) / 2);
+} /* p_cnv_shift_index () */
+
+
+int
+p_convert_in_vector (const p_convert_t *cnv,
+                     const void *file_buffer, void *mem_buffer)
+{
+    const int  shift = p_cnv_shift_index(cnv);
+    p_cnv_func func;
+
+    if ((shift < 0) ||
+        ((cnv->file_type != P_UNSIGNED_CHAR) &&
+         (cnv->file_type != P_UNSIGNED_SHORT))) {
+        return(0);
+    }
+    func = p_cnv_kernels[p_cnv_isa_get()].in[shift];
+    if (func == NULL) {
+        return(0);
+    }
+    return(func(cnv, (const unsigned char *)file_buffer,
+                (unsigned char *)mem_buffer));
+} /* end of p_convert_in_vector */
+
+
+int
+p_convert_out_vector (const p_convert_t *cnv,
+                      const void *mem_buffer, void *file_buffer)
+{
+    const int  shift = p_cnv_shift_index(cnv);
+    p_cnv_func func;
+
+    if ((shift < 0) ||
+        ((cnv->file_type != P_UNSIGNED_CHAR) &&
+         (cnv->file_type != P_UNSIGNED_SHORT))) {
+        return(0);
+    }
+    func = p_cnv_kernels[p_cnv_isa_get()].out[shift];
+    if (func == NULL) {
+        return(0);
+    }
+    return(func(cnv, (const unsigned char *)mem_buffer,
+                (unsigned char *)file_buffer));
+} /* end of p_convert_out_vector */
+
+
+p_convert_line_t
+p_convert_line (int out, int file_bits, int little_endian,
+                int mem_type, int mem_bits, int lsb)
+{
+    int file_fmt;
+    int mem_fmt;
+
+    /* row: 8 bits, then little and big endian of 10 .. 16 bits */
+    if (file_bits == 8) {
+        file_fmt = 0;
+    } else if ((file_bits >= 10) && (file_bits <= 16) && !(file_bits & 1)) {
+        file_fmt = file_bits - 9 + !little_endian;
+    } else {
+        return(NULL);
+    }
+    /* column: unsigned char of 8 .. 16 bits, unsigned short of 8 .. 16
+       bits, then the 8 least significant bits in unsigned short */
+    if ((mem_bits < 8) || (mem_bits > 16) || (mem_bits & 1)) {
+        return(NULL);
+    }
+    switch (mem_type) {
+    case P_UNSIGNED_CHAR:
+        /* bytes are copied into bytes; the 8 least significant bits
+           are the only ones stored anyway */
+        mem_fmt = (file_bits == 8) ? 0 : (mem_bits - 8) / 2;
+        break;
+    case P_UNSIGNED_SHORT:
+        if (lsb) {
+            mem_fmt = (mem_bits == 16) ? 10 : -1;
+        } else {
+            mem_fmt = (mem_bits - 8) / 2 + 5;
+        }
+        break;
+    default:
+        mem_fmt = -1;
+        break;
+    }
+    if (mem_fmt < 0) {
+        return(NULL);
+    }
+    return(out ? p_cnv_out_table[file_fmt][mem_fmt] : p_cnv_in_table[file_fmt][mem_fmt]);
+} /* end of p_convert_line */
+
+
+pT_status
+p_set_conversion_isa (const pT_isa isa)
+{
+    if ((isa != P_ISA_AUTO) && (isa != P_ISA_NONE) && !p_cpu_supports(isa)) {
+        return(P_ISA_NOT_SUPPORTED);
+    }
+    p_atomic_set(&p_cnv_isa, isa);
+    return(P_OK);
+} /* end of p_set_conversion_isa */
+
+
+pT_isa
+p_get_conversion_isa (void)
+{
+    return(p_cnv_isa_get());
+} /* end of p_get_conversion_isa */
+
+/******************************************************************************/
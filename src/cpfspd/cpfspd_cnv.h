@@ -0,0 +1,63 @@
+/*
+ *  All rights reserved.
+ *  For licensing and warranty information, see the file COPYING.LGPLv21.txt
+ *  in the root directory of this package.
+ *
+ *  Name        :  cpfspd_cnv.h
+ *
+ *  Function    :  Header file for cpfspd_cnv.c
+ *
+ *  Description :  Vectorized conversion of samples between file and
+ *                 memory format.
+ */
+
+/******************************************************************************/
+
+#ifndef CPFSPD_CNV_H
+#define CPFSPD_CNV_H
+
+/*
+ * Conversion of the samples first .. width-1 of a line, specialized
+ * for one combination of file and memory format (see p_convert_line())
+ */
+typedef void (*p_convert_line_t)(const void *src, void *dst, int first, int width);
+
+/* Conversion of samples between file and memory format */
+typedef struct {
+    int           file_type;            /* unsigned char=8, unsigned short=16 */
+    int           mem_type;             /* unsigned char=8, unsigned short=16 */
+    int           little_endian;        /* byte order of 16 bit file samples  */
+    unsigned int  pre_mask;             /* mask before shifting               */
+    unsigned int  post_mask;            /* mask after shifting                */
+    int           shift_left_factor;    /* either shift left or               */
+    int           shift_right_factor;   /* shift right is zero                */
+    int           width;                /* number of samples per line         */
+    p_convert_line_t line;              /* specialized conversion             */
+} p_convert_t;
+
+/*
+ * Convert the first samples of a line of file samples into memory
+ * samples, as many as fit in whole vectors. Returns the number of
+ * samples converted; the caller converts the remaining samples.
+ * The result is bit exact with the scalar conversion.
+ */
+extern int p_convert_in_vector(const p_convert_t *cnv,
+                               const void *file_buffer, void *mem_buffer);
+
+/* Idem, memory samples into file samples */
+extern int p_convert_out_vector(const p_convert_t *cnv,
+                                const void *mem_buffer, void *file_buffer);
+
+/*
+ * Specialized conversion of file samples of file_bits into memory
+ * samples of mem_bits (lsb: only the 8 least significant bits, see
+ * P_16_BIT_MEM_LSB), or of memory samples into file samples (out).
+ * All masks and shifts are constants. Returns NULL for combinations
+ * that are not supported.
+ */
+extern p_convert_line_t p_convert_line(int out, int file_bits, int little_endian,
+                                       int mem_type, int mem_bits, int lsb);
+
+#endif /* end of #ifndef CPFSPD_CNV_H */
+
+/******************************************************************************/
@@ -63,6 +63,22 @@
         "No rewrite on stdout possible"
 #define P_REWRITE_MODIFIED_HEADER_STR       \
         "Rewrite header that is inconsistent with data in file"
+#define P_MAP_FAILED_STR                    \
+        "Memory mapping of file failed"
+#define P_MAP_NOT_SUPPORTED_STR             \
+        "Memory mapped access not supported for this file or format"
+#define P_ILLEGAL_MAX_OPEN_FILES_STR        \
+        "Illegal maximum number of open files"
+#define P_FILE_HANDLE_CLOSED_STR            \
+        "File of the handle has been closed"
+#define P_ILLEGAL_NUM_THREADS_STR           \
+        "Illegal number of threads"
+#define P_THREAD_CREATE_FAILED_STR          \
+        "Unable to start a thread"
+#define P_RECORDER_OVERFLOW_STR             \
+        "Recorder full, frame dropped"
+#define P_ISA_NOT_SUPPORTED_STR             \
+        "Instruction set not supported"
 #define P_TOO_MANY_IMAGES_STR               \
         "Too many images"
 #define P_TOO_MANY_COMPONENTS_STR           \
@@ -240,6 +256,22 @@ p_get_error_string (pT_status status)
         return P_REWRITE_ON_STDOUT_STR;
     case P_REWRITE_MODIFIED_HEADER:
         return P_REWRITE_MODIFIED_HEADER_STR;
+    case P_MAP_FAILED:
+        return P_MAP_FAILED_STR;
+    case P_MAP_NOT_SUPPORTED:
+        return P_MAP_NOT_SUPPORTED_STR;
+    case P_ILLEGAL_MAX_OPEN_FILES:
+        return P_ILLEGAL_MAX_OPEN_FILES_STR;
+    case P_FILE_HANDLE_CLOSED:
+        return P_FILE_HANDLE_CLOSED_STR;
+    case P_ILLEGAL_NUM_THREADS:
+        return P_ILLEGAL_NUM_THREADS_STR;
+    case P_THREAD_CREATE_FAILED:
+        return P_THREAD_CREATE_FAILED_STR;
+    case P_RECORDER_OVERFLOW:
+        return P_RECORDER_OVERFLOW_STR;
+    case P_ISA_NOT_SUPPORTED:
+        return P_ISA_NOT_SUPPORTED_STR;
     case P_TOO_MANY_IMAGES:
         return P_TOO_MANY_IMAGES_STR;
     case P_TOO_MANY_COMPONENTS:
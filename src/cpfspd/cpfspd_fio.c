@@ -94,11 +94,41 @@
  *      FIO_WIN32_FILE   Selects between Windows32 native file system
  *                       and UNIX/POSIX file systems.
  *
+ *      FIO_POSIX_FILE   Selects the POSIX file descriptor based implementation
+ *                       (only used if FIO_WIN32_FILE is not set).
+ *
  *  If FIO_WIN32_FILE is set, the following applies:
  *      FIO_CYGWIN       If defined calls the cygwin function to perform
  *                       the posix to windows path name conversion.
  *
- *  If FIO_WIN32_FILE is not set, the following applies:
+ *  If FIO_POSIX_FILE is set, the file is accessed via a file descriptor
+ *  with positional I/O: pread() and pwrite(). The current file position
+ *  is administrated in our own FIO_FILE structure, so a fseek is only
+ *  a change of the administration and does not require a system call.
+ *  Small transfers are collected in an aligned buffer of the size set with
+ *  p_fio_bufsize() (default 256 Kbyte); larger transfers are done directly
+ *  between the disk cache and the application buffer.
+ *  Also, the file may be memory mapped with p_fio_mmap() to access the
+ *  disk cache without any copy at all.
+ *  A file opened for reading can be read with p_fio_pread() from several
+ *  threads simultaneously, directly via the file descriptor.
+ *  On Linux (glibc), this is enabled by default in the build system.
+ *      FIO_IO_URING     Allows asynchronous I/O via Linux io_uring, when
+ *                       requested with p_fio_access(). Sequential reads
+ *                       are read ahead and writes are written behind in
+ *                       blocks of the p_fio_bufsize() size, several blocks
+ *                       in flight (see cpfspd_aio.c). If the kernel does
+ *                       not support io_uring, the synchronous positional
+ *                       I/O is used. Defined by the build system if
+ *                       linux/io_uring.h is available.
+ *  Disk space for a file of known size is allocated at open with
+ *  fallocate(), and released by p_fio_set_end_of_file() when not used.
+ *  Also on request with p_fio_access(), the file is accessed with O_DIRECT
+ *  in aligned blocks, bypassing the page cache (FIO_ACCESS_DIRECT).
+ *  Or the file remains buffered, but the page cache behind the current
+ *  position is released while streaming through the file (FIO_ACCESS_STREAM).
+ *
+ *  If both FIO_WIN32_FILE and FIO_POSIX_FILE are not set, the following applies:
  *      Following macros (if defined) specify which function to call.
  *      Macro                                    ANSI-C default if not defined
  *      FIO_FUNC_FOPEN(filename,mode)            fopen(filename,mode)
@@ -174,6 +204,17 @@
  *      behaviour.
  */
 
+/*
+ * The POSIX implementation uses functions that are not part of ANSI-C
+ * (e.g. pread() and pwrite()). Request their declarations from the
+ * system header files; this must precede all includes.
+ */
+#ifdef FIO_POSIX_FILE
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+#endif
+
 /* Standard include files. */
 #include <stdlib.h>
 #include <stdio.h>
@@ -183,6 +224,9 @@
 /* Aplication include files. */
 #include "cpfspd_fio.h"
 
+/* Size of the file buffer (p_fio_bufsize()) unless set by the application */
+#define FIO_DEFAULT_BUFFER_SIZE (256*1024)
+
 
 #ifdef FIO_WIN32_FILE
 
@@ -424,7 +468,6 @@ static int CPUsupport(const long set)
 #define FIO_TRC_EVT(ffp) (QueryPerformanceCounter(&((ffp)->evt[(ffp)->trc_cnt])))
 #endif
 
-#define FIO_DEFAULT_BUFFER_SIZE (256*1024)
 typedef enum {FIO_NONE, FIO_WRITE, FIO_READ} fio_action;
 typedef struct {
     char          win32_path[MAX_PATH]; /* Path name of open file */
@@ -1582,6 +1625,33 @@ int p_fio_bufsize(FILE *stream, size_t size)
 } /* end of p_fio_bufsize */
 
 
+int p_fio_access(FILE *stream, int flags)
+{
+    /* Win32 uses its own buffering; no other access modes */
+    return((stream == NULL) || (flags == 0));      /* Dummy operation to get rid of compiler warnings on unused parameters */
+} /* end of p_fio_access */
+
+
+long p_fio_pread(FILE *stream, void *ptr, size_t size, fio_offset_t offset)
+{
+    /* Win32 transfers via the (aligned) file buffer only */
+    if ((stream == NULL) || (ptr == NULL) || (size == 0) || (offset < 0)) {
+        return(-1);        /* Dummy operation to get rid of compiler warnings on unused parameters */
+    }
+    return(-1);
+} /* end of p_fio_pread */
+
+
+void *p_fio_mmap(FILE *stream, fio_offset_t offset, size_t size, int write)
+{
+    /* Memory mapped access is not supported on top of our own buffering */
+    if ((stream == NULL) || (offset < 0) || (size == 0) || (write != 0)) {
+        return(NULL);      /* Dummy operation to get rid of compiler warnings on unused parameters */
+    }
+    return(NULL);
+} /* end of p_fio_mmap */
+
+
 int p_fio_set_end_of_file(const char* filename, fio_offset_t offset)
 {
     FILE          *stream;
@@ -1607,7 +1677,874 @@ int p_fio_set_end_of_file(const char* filename, fio_offset_t offset)
     return(err);
 } /* end of p_fio_set_end_of_file */
 
-#else  /* not FIO_WIN32_FILE */
+#elif defined(FIO_POSIX_FILE)
+
+/* Platform specific include files. */
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "cpfspd_aio.h"
+
+/*
+ * By default, data is buffered in blocks of buf_size bytes (p_fio_bufsize(),
+ * default FIO_DEFAULT_BUFFER_SIZE): small transfers are collected in a
+ * block, so they do not each require a system call. Transfers of at least
+ * a block are done directly between the file and the application buffer.
+ *
+ * Asynchronous I/O (FIO_ACCESS_URING): sequential reads are read ahead
+ * and writes are written behind in blocks of buf_size bytes.
+ * At most FIO_AIO_DEPTH blocks are in flight.
+ * With FIO_ACCESS_THREAD the same is done by a background I/O thread,
+ * with FIO_THREAD_DEPTH blocks (also used if io_uring is not available).
+ *
+ * Without asynchronous I/O, a file has FIO_SYNC_DEPTH blocks. The blocks
+ * are allocated at the first fread/fwrite, so files that are only read
+ * with p_fio_pread() or p_fio_mmap() have none; they are freed at close.
+ *
+ * Unbuffered I/O (FIO_ACCESS_DIRECT): the file is accessed with O_DIRECT,
+ * bypassing the page cache. All transfers use the same blocks, which are
+ * aligned in memory and in the file to FIO_AIO_ALIGN. A block that is only
+ * partially written is completed with the file data first (read-modify-write),
+ * which takes a second block (FIO_DIRECT_DEPTH).
+ * Since whole blocks are written, the file is truncated to its actual
+ * length when all data is flushed.
+ */
+#define FIO_AIO_DEPTH             16
+#define FIO_THREAD_DEPTH          4
+#define FIO_SYNC_DEPTH            1
+#define FIO_DIRECT_DEPTH          2
+#define FIO_AIO_ALIGN             4096
+
+/*
+ * Streaming (FIO_ACCESS_STREAM): the page cache is released behind the
+ * current position in ranges of at least FIO_STREAM_CHUNK bytes. Written
+ * data is first handed to the disk; a range is released when the write
+ * back of the next range is started.
+ */
+#define FIO_STREAM_CHUNK          (8*1024*1024)
+
+/*
+ * Own administration of an open file.
+ * A pointer to this structure is returned as FILE pointer.
+ */
+typedef struct {
+    int           fd;              /* System file descriptor */
+    int           writable;        /* File is opened for writing */
+    fio_offset_t  file_offset;     /* Current file position */
+    int           file_eof;        /* File read eof detected */
+    unsigned char *map_base;       /* Memory mapping of the whole file (NULL if not mapped) */
+    size_t        map_size;        /* Size of the memory mapping */
+    int           access;          /* Requested access flags, FIO_ACCESS_* */
+    size_t        buf_req;         /* Requested buffer size (may be set by application) */
+    size_t        buf_size;        /* Size of allocated block buffers (set once at allocation) */
+    int           aio_init;        /* Set once the asynchronous I/O initialization is done */
+    int           aio_err;         /* Set if a write behind failed */
+    int           direct;          /* File is accessed with O_DIRECT */
+    fio_offset_t  file_size;       /* Actual file length (direct only) */
+    int           file_padded;     /* File is longer than file_size (direct only) */
+    fio_aio_t     *aio;            /* Block I/O engine (NULL: no blocks; direct transfers) */
+    int           async;           /* Engine transfers in the background */
+    int           blk_count;       /* Number of I/O blocks in use */
+    fio_block_t   blk[FIO_AIO_DEPTH]; /* I/O blocks */
+    fio_block_t   *blk_fill;       /* Block being filled with write data (NULL if none) */
+    size_t        fill_start;      /* Start of the write data in blk_fill (direct only) */
+    int           stream;          /* Streaming: release the cache behind the file position */
+    fio_offset_t  stream_pos;      /* Start of the range not yet released */
+    fio_offset_t  stream_prev;     /* Start of the range under write back (-1 if none) */
+    fio_offset_t  stream_prev_end; /* End of the range under write back */
+    unsigned long blk_seq;         /* Sequence number of last submitted block */
+    fio_offset_t  ra_next;         /* File offset of next block to read ahead */
+} FIO_FILE;
+
+/* Note: keep these lists of open mode strings en related enum value consistent! */
+static char   *fio_mode_str[] = {"rb", "wb", "ab", "r+b", "rb+", "w+b", "wb+", "a+b", "ab+", NULL};
+typedef enum {MODE_RB_STD,MODE_WB_STD,MODE_AB_STD,MODE_RB_UPD1,MODE_RB_UPD2,MODE_WB_UPD1,MODE_WB_UPD2,MODE_AB_UPD1,MODE_AB_UPD2,MODE_NULL} fio_mode_val_t;
+
+
+/* Allocate the blocks and open an engine; returns 0 on success */
+static int fio_fp_blk_alloc(FIO_FILE *ffp, int engine, int depth)
+{
+    int i;
+
+    ffp->blk_count = depth;
+    for (i=0; i<ffp->blk_count; i++) {
+        memset(&ffp->blk[i], 0, sizeof(fio_block_t));
+        if (posix_memalign((void **)&ffp->blk[i].buf, FIO_AIO_ALIGN, ffp->buf_size) != 0) {
+            ffp->blk[i].buf = NULL;
+            break;
+        }
+    }
+    if (i == ffp->blk_count) {
+        ffp->aio = p_aio_open(ffp->fd, engine, ffp->blk_count);
+    }
+    if (ffp->aio == NULL) {
+        for (i=0; i<ffp->blk_count; i++) {
+            free(ffp->blk[i].buf);
+            ffp->blk[i].buf = NULL;
+        }
+        ffp->blk_count = 0;
+        return(1);
+    }
+
+    return(0);
+} /* end of fio_fp_blk_alloc */
+
+
+/*
+ * Start block I/O at the first data access.
+ * This allows the application to set the buffer size after the open.
+ * If io_uring is not available, the thread engine is used if requested,
+ * else the synchronous engine (plain buffering), else no blocks at all.
+ * If O_DIRECT is not supported (e.g. tmpfs), the file remains buffered.
+ */
+static void fio_fp_aio_init(FIO_FILE *ffp)
+{
+    struct stat st;
+    int         flags;
+
+    ffp->aio_init = 1;
+
+    ffp->buf_size = (ffp->buf_req != 0) ? ffp->buf_req : FIO_DEFAULT_BUFFER_SIZE;
+    ffp->buf_size = (ffp->buf_size + FIO_AIO_ALIGN - 1) & ~((size_t)FIO_AIO_ALIGN - 1);
+
+    if (ffp->access & FIO_ACCESS_URING) {
+        fio_fp_blk_alloc(ffp, FIO_AIO_URING, FIO_AIO_DEPTH);
+    }
+    if ((ffp->aio == NULL) && (ffp->access & FIO_ACCESS_THREAD)) {
+        fio_fp_blk_alloc(ffp, FIO_AIO_THREAD, FIO_THREAD_DEPTH);
+    }
+    if (ffp->aio != NULL) {
+        ffp->async = 1;
+    } else if (fio_fp_blk_alloc(ffp, FIO_AIO_SYNC,
+                                (ffp->access & FIO_ACCESS_DIRECT) ? FIO_DIRECT_DEPTH : FIO_SYNC_DEPTH)) {
+        return;
+    }
+    if (!(ffp->access & FIO_ACCESS_DIRECT)) {
+        return;
+    }
+    if (fstat(ffp->fd, &st) != 0) {
+        return;
+    }
+    flags = fcntl(ffp->fd, F_GETFL);
+    if ((flags != -1) && (fcntl(ffp->fd, F_SETFL, flags | O_DIRECT) == 0)) {
+        ffp->direct    = 1;
+        ffp->file_size = (fio_offset_t)st.st_size;
+    }
+} /* end of fio_fp_aio_init */
+
+
+/* Wait for completion of a block */
+static long fio_fp_wait(FIO_FILE *ffp, fio_block_t *blk)
+{
+    long result;
+
+    result = p_aio_wait(ffp->aio, blk);
+    if (blk->write) {
+        if (result != (long)blk->size) {
+            ffp->aio_err = 1;
+        }
+        blk->state = FIO_BLK_FREE;
+    }
+
+    return(result);
+} /* end of fio_fp_wait */
+
+
+static fio_block_t *fio_fp_get_free(FIO_FILE *ffp);
+
+
+/* Complete a partially filled block with the file data around it (direct only) */
+static void fio_fp_complete(FIO_FILE *ffp, fio_block_t *blk, size_t start)
+{
+    fio_block_t *tmp;
+    size_t      end = blk->size;
+    long        result;
+
+    if (blk->offset + (fio_offset_t)end > ffp->file_size) {
+        ffp->file_size = blk->offset + (fio_offset_t)end;
+    }
+    if ((start == 0) && (end == ffp->buf_size)) {
+        return;
+    }
+
+    tmp = fio_fp_get_free(ffp);
+    tmp->offset = blk->offset;
+    tmp->size   = ffp->buf_size;
+    tmp->write  = 0;
+    tmp->seq    = ++ffp->blk_seq;
+    p_aio_submit(ffp->aio, tmp);
+    p_aio_start(ffp->aio);
+    result = p_aio_wait(ffp->aio, tmp);
+    if (result < 0) {
+        ffp->aio_err = 1;
+        result = 0;
+    }
+    memset(tmp->buf + result, 0, ffp->buf_size - (size_t)result);
+    memcpy(blk->buf, tmp->buf, start);
+    memcpy(blk->buf + end, tmp->buf + end, ffp->buf_size - end);
+    tmp->state = FIO_BLK_FREE;
+
+    blk->size = ffp->buf_size;
+    if (blk->offset + (fio_offset_t)blk->size > ffp->file_size) {
+        ffp->file_padded = 1;
+    }
+} /* end of fio_fp_complete */
+
+
+/* Submit a block for writing */
+static void fio_fp_start_write(FIO_FILE *ffp, fio_block_t *blk)
+{
+    fio_block_t *other;
+    int         i;
+
+    /* Writes in flight may complete in any order: first wait for overlapping ones */
+    for (i=0; i<ffp->blk_count; i++) {
+        other = &ffp->blk[i];
+        if ((other != blk) && (other->state == FIO_BLK_BUSY) && other->write &&
+            (other->offset < blk->offset + (fio_offset_t)ffp->buf_size) &&
+            (blk->offset < other->offset + (fio_offset_t)other->size)) {
+            fio_fp_wait(ffp, other);
+        }
+    }
+    if (ffp->blk_fill == blk) {
+        ffp->blk_fill = NULL;
+    }
+    if (ffp->direct) {
+        fio_fp_complete(ffp, blk, ffp->fill_start);
+    }
+    blk->write = 1;
+    blk->seq   = ++ffp->blk_seq;
+    p_aio_submit(ffp->aio, blk);
+} /* end of fio_fp_start_write */
+
+
+/* Get a free block; waits for the oldest transfer if required */
+static fio_block_t *fio_fp_get_free(FIO_FILE *ffp)
+{
+    fio_block_t *oldest = NULL;
+    fio_block_t *blk;
+    int         i;
+
+    for (i=0; i<ffp->blk_count; i++) {
+        blk = &ffp->blk[i];
+        if ((blk->state == FIO_BLK_FREE) || (blk->state == FIO_BLK_DONE)) {
+            blk->state = FIO_BLK_FREE;
+            return(blk);
+        }
+        if ((blk->state == FIO_BLK_BUSY) && ((oldest == NULL) || (blk->seq < oldest->seq))) {
+            oldest = blk;
+        }
+    }
+    assert(oldest != NULL);
+    fio_fp_wait(ffp, oldest);
+    oldest->state = FIO_BLK_FREE;
+
+    return(oldest);
+} /* end of fio_fp_get_free */
+
+
+/* Write pending data and wait for all transfers; drops read ahead data */
+static int fio_fp_flush(FIO_FILE *ffp)
+{
+    int i;
+
+    if (ffp->blk_fill != NULL) {
+        fio_fp_start_write(ffp, ffp->blk_fill);
+    }
+    p_aio_start(ffp->aio);
+    for (i=0; i<ffp->blk_count; i++) {
+        if (ffp->blk[i].state == FIO_BLK_BUSY) {
+            fio_fp_wait(ffp, &ffp->blk[i]);
+        }
+        ffp->blk[i].state = FIO_BLK_FREE;
+    }
+
+    /* Chop off the padding of the last written block */
+    if (ffp->file_padded) {
+        ffp->file_padded = 0;
+        if (ftruncate(ffp->fd, (off_t)ffp->file_size) != 0) {
+            ffp->aio_err = 1;
+        }
+    }
+
+    return(ffp->aio_err);
+} /* end of fio_fp_flush */
+
+
+/* (Re)start reading ahead at the block that contains offset */
+static void fio_fp_start_read(FIO_FILE *ffp, fio_offset_t offset)
+{
+    fio_block_t *blk;
+    int         i;
+
+    fio_fp_flush(ffp);
+
+    /* Reading ahead only makes sense if it is asynchronous */
+    ffp->ra_next = offset - (offset % (fio_offset_t)ffp->buf_size);
+    for (i=0; i<(ffp->async ? ffp->blk_count : 1); i++) {
+        blk = &ffp->blk[i];
+        blk->offset = ffp->ra_next;
+        blk->size   = ffp->buf_size;
+        blk->write  = 0;
+        blk->seq    = ++ffp->blk_seq;
+        p_aio_submit(ffp->aio, blk);
+        ffp->ra_next += ffp->buf_size;
+    }
+} /* end of fio_fp_start_read */
+
+
+/* Read using the read ahead blocks; returns number of bytes read */
+static size_t fio_fp_read(FIO_FILE *ffp, unsigned char *buf, size_t amount)
+{
+    fio_block_t   *blk;
+    fio_offset_t  pos;
+    size_t        done = 0;
+    size_t        n;
+    long          result;
+    int           i;
+
+    while (done < amount) {
+        pos = ffp->file_offset + (fio_offset_t)done;
+
+        /* Blocks entirely before the current position are used to read further ahead */
+        if (pos < ffp->ra_next) {
+            for (i=0; i<ffp->blk_count; i++) {
+                blk = &ffp->blk[i];
+                if ((blk->state != FIO_BLK_FREE) &&
+                    (blk->offset + (fio_offset_t)blk->size <= pos)) {
+                    if (blk->state == FIO_BLK_BUSY) {
+                        fio_fp_wait(ffp, blk);
+                    }
+                    blk->offset = ffp->ra_next;
+                    blk->seq    = ++ffp->blk_seq;
+                    p_aio_submit(ffp->aio, blk);
+                    ffp->ra_next += ffp->buf_size;
+                }
+            }
+        }
+
+        /* Find the block containing the current position */
+        blk = NULL;
+        for (i=0; i<ffp->blk_count; i++) {
+            if ((ffp->blk[i].state != FIO_BLK_FREE) &&
+                (ffp->blk[i].offset <= pos) &&
+                (pos < ffp->blk[i].offset + (fio_offset_t)ffp->blk[i].size)) {
+                blk = &ffp->blk[i];
+            }
+        }
+        if (blk == NULL) {
+            /* Not sequential: restart the read ahead here */
+            fio_fp_start_read(ffp, pos);
+            blk = &ffp->blk[0];
+        }
+
+        p_aio_start(ffp->aio);
+        result = fio_fp_wait(ffp, blk);
+        if (result < 0) {
+            /* Read error; the block is read again on a next attempt */
+            blk->state = FIO_BLK_FREE;
+            errno = (int)-result;
+            break;
+        }
+        if (pos >= blk->offset + result) {
+            ffp->file_eof = 1;
+            break;
+        }
+        n = (size_t)(blk->offset + result - pos);
+        if (n > amount - done) {
+            n = amount - done;
+        }
+        memcpy(buf + done, blk->buf + (size_t)(pos - blk->offset), n);
+        done += n;
+    }
+    p_aio_start(ffp->aio);
+
+    return(done);
+} /* end of fio_fp_read */
+
+
+/* Write using the write behind blocks; returns number of bytes written */
+static size_t fio_fp_write(FIO_FILE *ffp, const unsigned char *buf, size_t amount)
+{
+    fio_block_t   *blk;
+    fio_offset_t  pos;
+    size_t        done = 0;
+    size_t        n;
+
+    if (ffp->aio_err) {
+        return(0);
+    }
+    while (done < amount) {
+        pos = ffp->file_offset + (fio_offset_t)done;
+        blk = ffp->blk_fill;
+
+        /* Not contiguous with the data in the fill block: write that first */
+        if ((blk != NULL) && (blk->offset + (fio_offset_t)blk->size != pos)) {
+            fio_fp_start_write(ffp, blk);
+            blk = NULL;
+        }
+        if (blk == NULL) {
+            blk = fio_fp_get_free(ffp);
+            blk->offset = pos;
+            blk->size   = 0;
+            blk->write  = 1;
+            blk->state  = FIO_BLK_FILL;
+            if (ffp->direct) {
+                /* Keep the block aligned in the file */
+                blk->offset = pos - (pos % (fio_offset_t)ffp->buf_size);
+                blk->size   = (size_t)(pos - blk->offset);
+            }
+            ffp->fill_start = blk->size;
+            ffp->blk_fill = blk;
+        }
+
+        n = ffp->buf_size - blk->size;
+        if (n > amount - done) {
+            n = amount - done;
+        }
+        memcpy(blk->buf + blk->size, buf + done, n);
+        blk->size += n;
+        done += n;
+
+        if (blk->size == ffp->buf_size) {
+            fio_fp_start_write(ffp, blk);
+        }
+    }
+    p_aio_start(ffp->aio);
+
+    return(done);
+} /* end of fio_fp_write */
+
+
+/* Release the page cache behind a transfer of amount bytes at offset (streaming) */
+static void fio_fp_stream(FIO_FILE *ffp, fio_offset_t offset, size_t amount)
+{
+    fio_offset_t  end;
+
+    if (!ffp->stream || ffp->direct) {
+        return;
+    }
+    if (offset < ffp->stream_pos) {
+        /* Access behind the released range: restart from here */
+        ffp->stream_pos = offset - (offset % FIO_AIO_ALIGN);
+    }
+    end  = offset + (fio_offset_t)amount;
+    end -= end % FIO_AIO_ALIGN;
+    if (end - ffp->stream_pos < FIO_STREAM_CHUNK) {
+        return;
+    }
+
+    if (ffp->writable) {
+        /* Dirty pages cannot be dropped: start the write back first */
+        sync_file_range(ffp->fd, (off_t)ffp->stream_pos, (off_t)(end - ffp->stream_pos),
+                        SYNC_FILE_RANGE_WRITE);
+        if (ffp->stream_prev >= 0) {
+            sync_file_range(ffp->fd, (off_t)ffp->stream_prev,
+                            (off_t)(ffp->stream_prev_end - ffp->stream_prev),
+                            SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+            posix_fadvise(ffp->fd, (off_t)ffp->stream_prev,
+                          (off_t)(ffp->stream_prev_end - ffp->stream_prev), POSIX_FADV_DONTNEED);
+        }
+        ffp->stream_prev     = ffp->stream_pos;
+        ffp->stream_prev_end = end;
+    } else {
+        posix_fadvise(ffp->fd, (off_t)ffp->stream_pos, (off_t)(end - ffp->stream_pos),
+                      POSIX_FADV_DONTNEED);
+    }
+    ffp->stream_pos = end;
+} /* end of fio_fp_stream */
+
+
+FILE * p_fio_fopen(const char *filename, const char *mode, fio_offset_t size)
+{
+    FIO_FILE      *ffp;
+    struct stat   st;
+    char          buf = 0;
+    int           flags;
+    int           append;
+    int           i;
+    int           err;
+
+    /* Avoid compiler warnings - assure all are assigned. */
+    flags  = O_RDWR | O_CREAT;
+    append = 0;
+
+    err = 1;
+    for (i=0; i<MODE_NULL; i++) {
+        if (strcmp(mode, fio_mode_str[i]) == 0) {
+            err = 0; /* Found a valid open mode */
+            switch (i) {
+            case MODE_RB_STD:
+                flags = O_RDONLY;
+                break;
+            case MODE_WB_STD:
+            case MODE_WB_UPD1:
+            case MODE_WB_UPD2:
+                /* Also open for reading (like win32), since the
+                 * written file may be read back by the application. */
+                flags = O_RDWR | O_CREAT | O_TRUNC;
+                break;
+            case MODE_AB_STD:
+            case MODE_AB_UPD1:
+            case MODE_AB_UPD2:
+                /* No O_APPEND: it would ignore the positional writes. */
+                flags = O_RDWR | O_CREAT;
+                append = 1;
+                break;
+            case MODE_RB_UPD1:
+            case MODE_RB_UPD2:
+                flags = O_RDWR;
+                break;
+            default:
+                /* We have some restrictions - only cpfspd support, not full ansi-C */
+                assert((i>=MODE_RB_STD) && (i<MODE_NULL));
+                break;
+            }
+        }
+    }
+    if (err) {
+        errno = EINVAL;
+        return(NULL);
+    }
+
+    ffp = (FIO_FILE *)calloc(1, sizeof(FIO_FILE));
+    if (ffp == NULL) {
+        return(NULL);
+    }
+    ffp->writable = (flags != O_RDONLY);
+
+    do {
+        ffp->fd = open(filename, flags, 0666);
+    } while ((ffp->fd < 0) && (errno == EINTR));
+    if (ffp->fd < 0) {
+        free(ffp);
+        return(NULL);
+    }
+
+    if (append) {
+        if (fstat(ffp->fd, &st) == 0) {
+            ffp->file_offset = (fio_offset_t)st.st_size;
+        }
+    }
+
+    if (size > 0) {
+        /* allocate disk space (not a sparse file) */
+        err = fallocate(ffp->fd, 0, 0, (off_t)size);
+        if (err && (errno == ENOSPC)) {
+            /* it makes no sense to start: the file does not fit */
+            close(ffp->fd);
+            free(ffp);
+            errno = ENOSPC;
+            return(NULL);
+        }
+        if (err) {
+            /* not supported by the file system: set the file size only, by
+             * writing the last byte of the file; written directly, since
+             * the access mode is not yet known */
+            while ((pwrite(ffp->fd, &buf, 1, (off_t)(size-1)) < 0) && (errno == EINTR)) {
+                ;
+            }
+        }
+    }
+
+    return((FILE *)ffp);
+} /* end of p_fio_fopen */
+
+
+int p_fio_fclose(FILE *stream)
+{
+    FIO_FILE *ffp = (FIO_FILE *)stream;
+    int      err = 0;
+    int      i;
+
+    if (ffp == NULL) {
+        return(EOF);
+    }
+    if (ffp->aio != NULL) {
+        err = fio_fp_flush(ffp);
+        p_aio_close(ffp->aio);
+        for (i=0; i<ffp->blk_count; i++) {
+            free(ffp->blk[i].buf);
+        }
+    }
+    if (ffp->map_base != NULL) {
+        munmap(ffp->map_base, ffp->map_size);
+    }
+    /* Do not retry on EINTR: the descriptor is released anyway */
+    if (close(ffp->fd) != 0) {
+        err = 1;
+    }
+    free(ffp);
+
+    return(err ? EOF : 0);
+} /* end of p_fio_fclose */
+
+
+size_t p_fio_fread(void *ptr, size_t size, size_t nobj, FILE *stream)
+{
+    FIO_FILE      *ffp = (FIO_FILE *)stream;
+    unsigned char *buf = (unsigned char *)ptr;
+    size_t        amount = size * nobj;
+    size_t        done = 0;
+    ssize_t       ret;
+
+    if (amount == 0) {
+        return(0);
+    }
+    if (!ffp->aio_init) {
+        fio_fp_aio_init(ffp);
+    }
+
+    if (ffp->aio != NULL) {
+        /* Reading a file that is written: written data first */
+        if (ffp->writable && fio_fp_flush(ffp)) {
+            return(0);
+        }
+        /* Direct I/O requires aligned transfers: always via the blocks.
+         * Large synchronous transfers are done directly. */
+        if ((!ffp->writable || ffp->direct) &&
+            (ffp->async || ffp->direct || (amount < ffp->buf_size))) {
+            done = fio_fp_read(ffp, buf, amount);
+            fio_fp_stream(ffp, ffp->file_offset, done);
+            ffp->file_offset += (fio_offset_t)done;
+            return(done / size);
+        }
+    }
+
+    /* Loop to handle short reads and interrupted system calls */
+    while (done < amount) {
+        ret = pread(ffp->fd, buf + done, amount - done,
+                    (off_t)(ffp->file_offset + (fio_offset_t)done));
+        if (ret > 0) {
+            done += ret;
+        } else if (ret == 0) {
+            ffp->file_eof = 1;
+            break;
+        } else if (errno != EINTR) {
+            break;
+        }
+    }
+    fio_fp_stream(ffp, ffp->file_offset, done);
+    ffp->file_offset += (fio_offset_t)done;
+
+    return(done / size);
+} /* end of p_fio_fread */
+
+
+size_t p_fio_fwrite(void *ptr, size_t size, size_t nobj, FILE *stream)
+{
+    FIO_FILE      *ffp = (FIO_FILE *)stream;
+    unsigned char *buf = (unsigned char *)ptr;
+    size_t        amount = size * nobj;
+    size_t        done = 0;
+    ssize_t       ret;
+
+    if (amount == 0) {
+        return(0);
+    }
+    if (!ffp->aio_init) {
+        fio_fp_aio_init(ffp);
+    }
+
+    if (ffp->aio != NULL) {
+        /* Large synchronous transfers are done directly */
+        if (ffp->async || ffp->direct || (amount < ffp->buf_size)) {
+            done = fio_fp_write(ffp, buf, amount);
+            fio_fp_stream(ffp, ffp->file_offset, done);
+            ffp->file_offset += (fio_offset_t)done;
+            return(done / size);
+        }
+        /* Pending data first */
+        if (fio_fp_flush(ffp)) {
+            return(0);
+        }
+    }
+
+    /* Loop to handle short writes and interrupted system calls */
+    while (done < amount) {
+        ret = pwrite(ffp->fd, buf + done, amount - done,
+                     (off_t)(ffp->file_offset + (fio_offset_t)done));
+        if (ret > 0) {
+            done += ret;
+        } else if ((ret == 0) || (errno != EINTR)) {
+            break;
+        }
+    }
+    fio_fp_stream(ffp, ffp->file_offset, done);
+    ffp->file_offset += (fio_offset_t)done;
+
+    return(done / size);
+} /* end of p_fio_fwrite */
+
+
+int p_fio_fseek(FILE *stream, fio_offset_t offset, int origin)
+{
+    FIO_FILE      *ffp = (FIO_FILE *)stream;
+    struct stat   st;
+    fio_offset_t  new_offset;
+
+    /* Only the administration is updated, no system call (except SEEK_END) */
+    switch (origin) {
+    case SEEK_SET:
+        new_offset = offset;
+        break;
+    case SEEK_CUR:
+        new_offset = ffp->file_offset + offset;
+        break;
+    case SEEK_END:
+        if ((ffp->aio != NULL) && fio_fp_flush(ffp)) {
+            return(-1);
+        }
+        if (fstat(ffp->fd, &st) != 0) {
+            return(-1);
+        }
+        new_offset = (fio_offset_t)st.st_size + offset;
+        break;
+    default:
+        errno = EINVAL;
+        return(-1);
+    }
+    if (new_offset < 0) {
+        errno = EINVAL;
+        return(-1);
+    }
+    ffp->file_offset = new_offset;
+    ffp->file_eof = 0;
+
+    return(0);
+} /* end of p_fio_fseek */
+
+
+int p_fio_feof(FILE *stream)
+{
+    return(((FIO_FILE *)stream)->file_eof);
+} /* end of p_fio_feof */
+
+
+int p_fio_bufsize(FILE *stream, size_t size)
+{
+    FIO_FILE *ffp = (FIO_FILE *)stream;
+
+    /* Effective until the first data access */
+    ffp->buf_req = size;
+
+    return(0);
+} /* end of p_fio_bufsize */
+
+
+int p_fio_access(FILE *stream, int flags)
+{
+    FIO_FILE *ffp = (FIO_FILE *)stream;
+
+    /* Effective until the first data access */
+    ffp->access = flags;
+
+    /* Streaming is effective immediately */
+    if ((flags & FIO_ACCESS_STREAM) && !ffp->stream) {
+        ffp->stream      = 1;
+        ffp->stream_pos  = ffp->file_offset - (ffp->file_offset % FIO_AIO_ALIGN);
+        ffp->stream_prev = -1;
+        posix_fadvise(ffp->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    return(0);
+} /* end of p_fio_access */
+
+
+long p_fio_pread(FILE *stream, void *ptr, size_t size, fio_offset_t offset)
+{
+    FIO_FILE      *ffp = (FIO_FILE *)stream;
+    unsigned char *dst = (unsigned char *)ptr;
+    size_t        done = 0;
+    ssize_t       ret;
+
+    /* Written data may still be in the blocks; O_DIRECT requires aligned transfers */
+    if (ffp->writable || (ffp->access & FIO_ACCESS_DIRECT)) {
+        return(-1);
+    }
+    while (done < size) {
+        ret = pread(ffp->fd, dst + done, size - done, (off_t)(offset + (fio_offset_t)done));
+        if ((ret < 0) && (errno == EINTR)) {
+            continue;
+        }
+        if (ret <= 0) {
+            break;
+        }
+        done += (size_t)ret;
+    }
+
+    return((long)done);
+} /* end of p_fio_pread */
+
+
+void *p_fio_mmap(FILE *stream, fio_offset_t offset, size_t size, int write)
+{
+    FIO_FILE      *ffp = (FIO_FILE *)stream;
+    struct stat   st;
+    void          *base;
+
+    if ((offset < 0) || (write && !ffp->writable)) {
+        return(NULL);
+    }
+
+    /* Data written behind must be in the file before we map it */
+    if ((ffp->aio != NULL) && ffp->writable && fio_fp_flush(ffp)) {
+        return(NULL);
+    }
+
+    /*
+     * The whole file is mapped at the first request and remains mapped
+     * until the file is closed. So all pointers handed out for this file
+     * stay valid, and subsequent requests do not require a system call.
+     */
+    if (ffp->map_base == NULL) {
+        if ((fstat(ffp->fd, &st) != 0) || (st.st_size <= 0)) {
+            return(NULL);
+        }
+        if ((unsigned long long)st.st_size > (unsigned long long)(size_t)-1) {
+            /* Does not fit in the address space */
+            return(NULL);
+        }
+        base = mmap(NULL, (size_t)st.st_size,
+                    ffp->writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+                    MAP_SHARED, ffp->fd, 0);
+        if (base == MAP_FAILED) {
+            return(NULL);
+        }
+        ffp->map_base = (unsigned char *)base;
+        ffp->map_size = (size_t)st.st_size;
+    }
+
+    /* Requested range shall be inside the mapping */
+    if ((offset > (fio_offset_t)ffp->map_size) ||
+        (size > ffp->map_size - (size_t)offset)) {
+        return(NULL);
+    }
+
+    return(ffp->map_base + offset);
+} /* end of p_fio_mmap */
+
+
+int p_fio_set_end_of_file(const char* filename, fio_offset_t offset)
+{
+    struct stat   st;
+
+    /* Only shorten the file, e.g. to release space allocated at open */
+    if (stat(filename, &st) != 0) {
+        return(1);
+    }
+    if ((fio_offset_t)st.st_size <= offset) {
+        return(0);
+    }
+
+    return(truncate(filename, (off_t)offset) != 0);
+} /* end of p_fio_set_end_of_file */
+
+#else  /* not FIO_WIN32_FILE, not FIO_POSIX_FILE */
 
 /*
  * Functions that can be overwritten by compile time options.
@@ -1685,6 +2622,30 @@ int p_fio_bufsize(FILE *stream, size_t size)
     return((stream == NULL) || (size == 0));      /* Dummy operation to get rid of sgi compiler warnings on unused parameters */
 } /* end of p_fio_bufsize */
 
+int p_fio_access(FILE *stream, int flags)
+{
+    /* Function only available in posix system */
+    return((stream == NULL) || (flags == 0));      /* Dummy operation to get rid of compiler warnings on unused parameters */
+} /* end of p_fio_access */
+
+long p_fio_pread(FILE *stream, void *ptr, size_t size, fio_offset_t offset)
+{
+    /* Not available via the standard C library */
+    if ((stream == NULL) || (ptr == NULL) || (size == 0) || (offset < 0)) {
+        return(-1);        /* Dummy operation to get rid of compiler warnings on unused parameters */
+    }
+    return(-1);
+} /* end of p_fio_pread */
+
+void *p_fio_mmap(FILE *stream, fio_offset_t offset, size_t size, int write)
+{
+    /* Memory mapped access is not available via the standard C library */
+    if ((stream == NULL) || (offset < 0) || (size == 0) || (write != 0)) {
+        return(NULL);      /* Dummy operation to get rid of compiler warnings on unused parameters */
+    }
+    return(NULL);
+} /* end of p_fio_mmap */
+
 int p_fio_set_end_of_file(const char* filename, fio_offset_t offset)
 {
     /* Function only available in win32 system.
@@ -1697,4 +2658,4 @@ int p_fio_set_end_of_file(const char* filename, fio_offset_t offset)
     return((filename == NULL) || (offset == 0));  /* Dummy operation to get rid of sgi compiler warnings on unused parameters */
 } /* end of p_fio_set_end_of_file */
 
-#endif  /* not FIO_WIN32_FILE */
+#endif  /* not FIO_WIN32_FILE, not FIO_POSIX_FILE */
@@ -24,6 +24,9 @@
  *                 e.g. to handle large offset values.
  */
 
+#ifndef CPFSPD_FIO_H
+#define CPFSPD_FIO_H
+
 #define FIO_LARGE_FILE_SUPPORTED 1
 #ifndef FIO_OFFSET_T
     #define FIO_OFFSET_T long long
@@ -47,3 +50,33 @@ extern int p_fio_feof(FILE *stream);
 extern int p_fio_bufsize(FILE *stream, size_t size);
 
 extern int p_fio_set_end_of_file(const char* filename, fio_offset_t offset);
+
+/*
+ * No standard C counterpart: map the file in memory and return a pointer
+ * to the data at offset, valid for size bytes and until p_fio_fclose().
+ * Returns NULL if memory mapping is not supported or failed.
+ */
+extern void *p_fio_mmap(FILE *stream, fio_offset_t offset, size_t size, int write);
+
+/*
+ * No standard C counterpart: set access flags (FIO_ACCESS_*) for the
+ * subsequent data transfers. Must be called before the first transfer.
+ * Flags that are not supported on the platform are ignored.
+ */
+#define FIO_ACCESS_URING  0x0001    /* Asynchronous read ahead / write behind */
+#define FIO_ACCESS_DIRECT 0x0002    /* Unbuffered (O_DIRECT), aligned blocks */
+#define FIO_ACCESS_THREAD 0x0004    /* Read ahead / write behind by an I/O thread */
+#define FIO_ACCESS_STREAM 0x0008    /* Sequential; release the cache behind the position */
+
+extern int p_fio_access(FILE *stream, int flags);
+
+/*
+ * No standard C counterpart: read size bytes at offset, without using
+ * or changing the current file position. Several threads may read from
+ * the same stream simultaneously. Only for files opened for reading.
+ * Returns the number of bytes read, or -1 if this is not supported for
+ * the stream (then use fseek/fread). A call with size 0 tests this.
+ */
+extern long p_fio_pread(FILE *stream, void *ptr, size_t size, fio_offset_t offset);
+
+#endif /* end of #ifndef CPFSPD_FIO_H */
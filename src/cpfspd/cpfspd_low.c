@@ -27,9 +27,9 @@
  *                 These functions are only used internally in
  *                 cpfspd.
  *
- *                 The following external variables are defined
- *                 (required in exceptional cases, see cpfspd.h)
- *                 - p_file_buffer_size_kb
+ *                 The file administration and the settings (file
+ *                 buffer size, file access mode, ...) are kept in a
+ *                 context (pT_context), see p_context_create().
  *
  *                 The following external functions are defined
  *                 ( required in exceptional cases, see cpfspd.h)
@@ -37,6 +37,19 @@
  *                 - p_close_file()
  *                 - p_set_file_buf_size()
  *                 - p_get_file_buf_size()
+ *                 - p_set_file_access_mode()
+ *                 - p_get_file_access_mode()
+ *                 - p_set_max_open_files()
+ *                 - p_get_max_open_files()
+ *                 - p_file_open()
+ *                 - p_file_close()
+ *                 - p_file_get_header()
+ *                 - p_context_create()
+ *                 - p_context_destroy()
+ *                 - p_context_select()
+ *                 - p_context_current()
+ *                 - p_set_parallel_conversion()
+ *                 - p_get_parallel_conversion()
  *
  */
 
@@ -71,6 +84,9 @@
 #include "cpfspd_low.h"
 #include "cpfspd_hdr.h"
 #include "cpfspd_fio.h"
+#include "cpfspd_thr.h"
+#include "cpfspd_wrk.h"
+#include "cpfspd_cnv.h"
 
 
 /******************************************************************************/
@@ -85,7 +101,7 @@
 #define MIN(x,y)             ( ((x) < (y)) ? (x) : (y) )
 #define MAX(x,y)             ( ((x) > (y)) ? (x) : (y) )
 
-/* number of files that can be opened simultaneously */
+/* default number of files that can be opened simultaneously */
 #define P_MAX_OPEN_FILES           10
 
 /* range of number of bytes per record */
@@ -116,16 +132,74 @@ typedef struct {
     long          size_header;            /* Cached value derived from header to calculate file positions */
     long          size_image;             /* (image = aux data + all components */
     long          hdr_nr_images;          /* Number of images in file header */
+    int           access_mode;            /* File access mode flags at open */
+    int           name_next;              /* Next record in name hash bucket, or in free list (-1: none) */
+    int           lru_prev;               /* Less recently used open file (-1: none) */
+    int           lru_next;               /* More recently used open file (-1: none) */
+    pT_file       *handle;                /* Handle that keeps the file open, or NULL */
+    int           users;                  /* Number of threads accessing the file */
+    p_mutex_t     *lock;                  /* Held by the thread accessing the file (unless shared) */
 } p_file_admin_t;
 
+/*
+ * The open files are found via a hash table on name with chaining
+ * through the admin records. The open files are also kept in a list
+ * in order of access, so the least recently used file is found
+ * immediately when all records are occupied.
+ * Files opened by p_file_open() are not in this list: they are only
+ * closed explicitly.
+ * The tables are allocated at the first open.
+ *
+ * The administration is guarded by the table lock. To access a file,
+ * a thread registers as user of its record and then takes the lock of
+ * the record, so distinct files are accessed in parallel. Threads that
+ * read with positional I/O from a file opened for reading do not take
+ * the lock, so they also read the same file in parallel. A file is
+ * only closed (and the tables only reallocated) while it has no users;
+ * when required, the closing thread waits on the table condition, which
+ * is signalled whenever the last user leaves a file. A record lock is
+ * never waited for while the table lock is held.
+ *
+ * The administration and the file settings are part of a context.
+ * Each thread uses its current context (see p_context_select()),
+ * by default p_default_context; a handle uses the context in which
+ * it was opened. The contexts are kept in a list for the cleanup at
+ * exit. Standard i/o is shared by all contexts.
+ */
+struct pT_context_s {
+    p_file_admin_t *files;
+    int            max_open_files;
+    int            file_count;          /* Number of records used up till now */
+    int            file_free;           /* List of closed records */
+    int            *name_hash;
+    unsigned int   hash_mask;           /* Hash table size - 1 */
+    int            lru_first;           /* Least recently used open file */
+    int            lru_last;            /* Most recently used open file */
+    unsigned long  event_count;
+    p_mutex_t      table_lock;
+    p_cond_t       table_cond;
+    int            file_buffer_size_kb;
+    int            file_access_mode;
+    pT_context     *next;               /* Next context in the list */
+};
+
 static char           *p_mode_str[] = {"rb", "wb", "rb+"};
-static p_file_admin_t p_files[P_MAX_OPEN_FILES];
-static int            p_file_count = 0;
-static unsigned long  p_event_count = 0;
+static pT_context     p_default_context = {
+    NULL, P_MAX_OPEN_FILES, 0, -1, NULL, 0, -1, -1, 0,
+    P_MUTEX_INITIALIZER, P_COND_INITIALIZER, 0, P_FILE_ACCESS_DEFAULT, NULL
+};
+static pT_context     *p_contexts = &p_default_context;  /* List of all contexts */
+static p_mutex_t      p_contexts_lock = P_MUTEX_INITIALIZER;
+static P_THREAD_LOCAL pT_context *p_current_context = NULL; /* NULL: the default context */
 static int            p_atexit_done = 0;
-static int            p_file_buffer_size_kb = 0;
+static p_mutex_t      p_atexit_lock = P_MUTEX_INITIALIZER;  /* Guards p_atexit_done */
+static p_mutex_t      p_stdio_lock = P_MUTEX_INITIALIZER;   /* Held by the thread accessing stdin/stdout */
+static int            p_parallel_conversion = 0;
 static int            p_stdin_used = 0;
 
+/* Record index denoting stdin/stdout */
+#define P_STDIO_IDX                (-2)
+
 
 #ifdef _ONLY_FOR_DEBUG
 /* Debug convenience routine
@@ -133,19 +207,19 @@ static int            p_stdin_used = 0;
  * in future debugging. It is conditional compiled
  * to avoid compiler warnings.
  */
-static void p_dump_file_admin(void)
+static void p_dump_file_admin(pT_context *ctx)
 {
     int i;
     printf("FILE_ADMIN Fp Tstamp Mode NoImgs SzHead SzImag Name\n");
-    for (i=0; i<p_file_count; i++) {
+    for (i=0; i<ctx->file_count; i++) {
         printf("%2d", i);
-        printf(" 0x%08lx", (unsigned long)p_files[i].fp);
-        printf(" %6ld",  p_files[i].timestamp);
-        printf(" %4d",   p_files[i].mode);
-        printf(" %6ld",  p_files[i].no_of_images);
-        printf(" %6ld",  p_files[i].size_header);
-        printf(" %6ld",  p_files[i].size_image);
-        printf(" %s",    p_files[i].name);
+        printf(" 0x%08lx", (unsigned long)ctx->files[i].fp);
+        printf(" %6ld",  ctx->files[i].timestamp);
+        printf(" %4d",   ctx->files[i].mode);
+        printf(" %6ld",  ctx->files[i].no_of_images);
+        printf(" %6ld",  ctx->files[i].size_header);
+        printf(" %6ld",  ctx->files[i].size_image);
+        printf(" %s",    ctx->files[i].name);
         printf("\n");
     }
 }
@@ -176,8 +250,8 @@ p_get_size_comp (int width, int height, char *data_fmt)
 } /* end of p_get_size_comp () */
 
 
-/* internal function to determine the size of an image (all components) in the file */
-static long
+/* function to determine the size of an image (all components) in the file */
+long
 p_get_size_image (pT_header *header)
 {
     long size;
@@ -210,45 +284,245 @@ p_get_size_header (pT_header *header)
 } /* end of p_get_size_header */
 
 
+/* internal function to determine the file offset of a component of an image */
+static fio_offset_t
+p_get_offset_comp (pT_header *header, int nr, int comp_nr)
+{
+    fio_offset_t offset;
+    int          i;
+
+    /* skip header and previous images */
+    offset  = p_get_size_header(header);
+    offset += (nr - 1) * (fio_offset_t)p_get_size_image(header);
+    /* skip current image aux data */
+    offset += header->nr_aux_data_recs * header->bytes_rec;
+    /* skip previous components of current image */
+    for (i = 0; i < comp_nr; i++) {
+        offset += p_get_size_comp (header->comp[i].pix_line,
+                                   header->comp[i].lin_image,
+                                   header->comp[i].data_fmt);
+    }
+
+    return(offset);
+} /* end of p_get_offset_comp */
+
+
+/* Current context of the calling thread */
+static pT_context *
+p_context_get (void)
+{
+    return((p_current_context != NULL) ? p_current_context : &p_default_context);
+} /* p_context_get () */
+
+
+/* Hash bucket of a file name */
+static unsigned int
+p_hash_name (pT_context *ctx, const char *name)
+{
+    unsigned int hash = 2166136261u;   /* FNV-1a */
+
+    while (*name != '\0') {
+        hash ^= (unsigned char)*name++;
+        hash *= 16777619u;
+    }
+
+    return(hash & ctx->hash_mask);
+} /* p_hash_name () */
+
+
+/* Find the open file with this name; returns the index or -1 */
+static int
+p_find_name (pT_context *ctx, const char *name)
+{
+    int  idx;
+
+    for (idx = ctx->name_hash[p_hash_name(ctx, name)]; idx != -1; idx = ctx->files[idx].name_next) {
+        if (strcmp(name, ctx->files[idx].name) == 0) {
+            break;
+        }
+    }
+
+    return(idx);
+} /* p_find_name () */
+
+
+/* Enter an open file in the hash table */
+static void
+p_hash_insert (pT_context *ctx, const int idx)
+{
+    const unsigned int bucket = p_hash_name(ctx, ctx->files[idx].name);
+
+    ctx->files[idx].name_next = ctx->name_hash[bucket];
+    ctx->name_hash[bucket] = idx;
+} /* p_hash_insert () */
+
+
+/* Remove an open file from the hash table */
+static void
+p_hash_unlink (pT_context *ctx, const int idx)
+{
+    int  *link = &ctx->name_hash[p_hash_name(ctx, ctx->files[idx].name)];
+
+    while (*link != idx) {
+        assert(*link != -1);
+        link = &ctx->files[*link].name_next;
+    }
+    *link = ctx->files[idx].name_next;
+} /* p_hash_unlink () */
+
+
+/* Remove an open file from the access order list */
+static void
+p_lru_unlink (pT_context *ctx, const int idx)
+{
+    if (ctx->files[idx].lru_prev != -1) {
+        ctx->files[ctx->files[idx].lru_prev].lru_next = ctx->files[idx].lru_next;
+    } else {
+        ctx->lru_first = ctx->files[idx].lru_next;
+    }
+    if (ctx->files[idx].lru_next != -1) {
+        ctx->files[ctx->files[idx].lru_next].lru_prev = ctx->files[idx].lru_prev;
+    } else {
+        ctx->lru_last = ctx->files[idx].lru_prev;
+    }
+} /* p_lru_unlink () */
+
+
+/* Append an open file to the access order list (most recently used) */
+static void
+p_lru_append (pT_context *ctx, const int idx)
+{
+    ctx->files[idx].lru_prev = ctx->lru_last;
+    ctx->files[idx].lru_next = -1;
+    if (ctx->lru_last != -1) {
+        ctx->files[ctx->lru_last].lru_next = idx;
+    } else {
+        ctx->lru_first = idx;
+    }
+    ctx->lru_last = idx;
+} /* p_lru_append () */
+
+
+/*
+ * (Re)allocate the file administration for max_files records.
+ * Open files keep their index. On failure, the old administration
+ * remains valid.
+ * The table lock shall be held and no file shall be in use.
+ */
+static pT_status
+p_alloc_file_admin (pT_context *ctx, const int max_files)
+{
+    p_file_admin_t *files;
+    int            *name_hash;
+    unsigned int   size;
+    unsigned int   i;
+
+    assert(max_files >= ctx->file_count);
+
+    /* Hash table of at least twice the number of records */
+    for (size = 16; size < 2 * (unsigned int)max_files; size *= 2) {
+        ;
+    }
+    name_hash = (int *)malloc(size * sizeof(int));
+    files     = NULL;
+    if (name_hash != NULL) {
+        files = (p_file_admin_t *)realloc(ctx->files, (size_t)max_files * sizeof(p_file_admin_t));
+    }
+    if (files == NULL) {
+        free(name_hash);
+        return(P_MALLOC_FAILED);
+    }
+
+    ctx->files = files;
+    free(ctx->name_hash);
+    ctx->name_hash = name_hash;
+    ctx->hash_mask = size - 1;
+    for (i=0; i<size; i++) {
+        ctx->name_hash[i] = -1;
+    }
+    for (i=0; i<(unsigned int)ctx->file_count; i++) {
+        if (ctx->files[i].fp != NULL) {
+            p_hash_insert(ctx, (int)i);
+        }
+    }
+
+    return(P_OK);
+} /* p_alloc_file_admin () */
+
+
+/* Wait until no file is in use; the table lock shall be held */
+static void
+p_wait_no_users (pT_context *ctx)
+{
+    int  i = 0;
+
+    while (i < ctx->file_count) {
+        if (ctx->files[i].users > 0) {
+            p_cond_wait(&ctx->table_cond, &ctx->table_lock);
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+} /* p_wait_no_users () */
+
+
 /*
  * Close the file identified by the index.
  * In case original length in the header is not correct,
  * write it at the beginning of the file.
+ * The record is removed from the hash table and access order list,
+ * but not added to the free list. A handle to the file becomes invalid.
+ * The table lock shall be held and the file shall not be in use.
  */
 static pT_status
-p_close_idx (const int idx)
+p_close_idx (pT_context *ctx, const int idx)
 {
     pT_status status;
     char temp[P_SAPPL_TYPE + 1]; /* largest possible character string */
 
     status = P_OK;
+    assert(ctx->files[idx].users == 0);
 
     /* Still need to write the amount of images? */
-    if (p_files[idx].no_of_images > p_files[idx].hdr_nr_images) {
-        p_fio_fseek(p_files[idx].fp, 0, SEEK_SET);
-        sprintf(temp, "%7ld", p_files[idx].no_of_images);
-        if (p_fio_fwrite(temp, (size_t)sizeof(char), (size_t)P_SNR_IMAGES, p_files[idx].fp) != P_SNR_IMAGES) {
+    if (ctx->files[idx].no_of_images > ctx->files[idx].hdr_nr_images) {
+        p_fio_fseek(ctx->files[idx].fp, 0, SEEK_SET);
+        sprintf(temp, "%7ld", ctx->files[idx].no_of_images);
+        if (p_fio_fwrite(temp, (size_t)sizeof(char), (size_t)P_SNR_IMAGES, ctx->files[idx].fp) != P_SNR_IMAGES) {
             status = P_WRITE_FAILED;
         }
     }
 
-    p_fio_fclose(p_files[idx].fp);
-    p_files[idx].fp = NULL;
+    p_hash_unlink(ctx, idx);
+    if (ctx->files[idx].handle != NULL) {
+        ctx->files[idx].handle->idx = -1;
+        ctx->files[idx].handle = NULL;
+    } else {
+        p_lru_unlink(ctx, idx);
+    }
+
+    /* Data written behind may only fail at close */
+    if ((p_fio_fclose(ctx->files[idx].fp) != 0) && (ctx->files[idx].mode != p_mode_read)) {
+        status = P_WRITE_FAILED;
+    }
+    ctx->files[idx].fp = NULL;
 
-#ifdef FIO_WIN32_FILE
+#if defined(FIO_WIN32_FILE) || defined(FIO_POSIX_FILE)
     {
         fio_offset_t offset;
 
         /* Truncate file if it was opened for writing.
-         * Only required with win32 file system, because there we
-         * used unbuffered asynchronous I/O. Therefore the file size
-         * is a multiple of the block size.
+         * With win32 file system, because there we used unbuffered
+         * asynchronous I/O. Therefore the file size is a multiple of
+         * the block size.
+         * With both, the disk space for all images in the header was
+         * allocated at open; release the part that was not written.
          */
-        if ((status == P_OK) && (p_files[idx].mode == p_mode_write)) {
-            offset  = p_files[idx].size_header;
-            offset += (fio_offset_t)p_files[idx].no_of_images * p_files[idx].size_image;
+        if ((status == P_OK) && (ctx->files[idx].mode == p_mode_write)) {
+            offset  = ctx->files[idx].size_header;
+            offset += (fio_offset_t)ctx->files[idx].no_of_images * ctx->files[idx].size_image;
             /* truncate file to size offset */
-            if (p_fio_set_end_of_file(p_files[idx].name, offset)) {
+            if (p_fio_set_end_of_file(ctx->files[idx].name, offset)) {
                 status = P_WRITE_FAILED;
             }
         }
@@ -259,6 +533,31 @@ p_close_idx (const int idx)
 } /* p_close_idx () */
 
 
+/*
+ * Close all files and release all records, once no file is in use.
+ * The table lock shall be held.
+ */
+static pT_status
+p_close_all (pT_context *ctx)
+{
+    pT_status status = P_OK;
+    int       i;
+
+    p_wait_no_users(ctx);
+    for (i=0; i<ctx->file_count; i++) {
+        if ((ctx->files[i].fp != NULL) && (p_close_idx(ctx, i) != P_OK)) {
+            status = P_WRITE_FAILED;
+        }
+        p_mutex_destroy(ctx->files[i].lock);
+        free(ctx->files[i].lock);
+    }
+    ctx->file_count = 0;
+    ctx->file_free  = -1;
+
+    return(status);
+} /* p_close_all () */
+
+
 /*
  * Close open files.
  * For a single file, specify its name.
@@ -267,32 +566,67 @@ p_close_idx (const int idx)
 pT_status
 p_close_file (const char *filename)
 {
+    pT_context *ctx = p_context_get();
     int  i;
     pT_status status;
 
     status = P_OK;
-    for (i=0; i<p_file_count; i++) {
-        /* file is open && file needs to be closed? */
-        if ((p_files[i].fp != NULL) && ((filename == NULL) || (strcmp(filename, p_files[i].name) == 0))) {
-            status = p_close_idx(i);
+    p_mutex_lock(&ctx->table_lock);
+    if (ctx->files != NULL) {
+        if (filename != NULL) {
+            /* Wait until the file is not in use */
+            while (((i = p_find_name(ctx, filename)) != -1) && (ctx->files[i].users > 0)) {
+                p_cond_wait(&ctx->table_cond, &ctx->table_lock);
+            }
+            if (i != -1) {
+                status = p_close_idx(ctx, i);
+                ctx->files[i].name_next = ctx->file_free;
+                ctx->file_free = i;
+            }
+        } else {
+            status = p_close_all(ctx);
         }
     }
+    p_mutex_unlock(&ctx->table_lock);
+
+    return(status);
+} /* p_close_file () */
+
 
-    if (filename == NULL) {
-        p_file_count = 0;
+/*
+ * Close all files of a context and release its administration.
+ */
+static pT_status
+p_close_context (pT_context *ctx)
+{
+    pT_status status = P_OK;
+
+    p_mutex_lock(&ctx->table_lock);
+    if (ctx->files != NULL) {
+        status = p_close_all(ctx);
     }
+    free(ctx->files);
+    free(ctx->name_hash);
+    ctx->files     = NULL;
+    ctx->name_hash = NULL;
+    p_mutex_unlock(&ctx->table_lock);
 
     return(status);
-} /* p_close_file () */
+} /* p_close_context () */
 
 
 static void
 p_atexit_close (void)
 {
-    char      temp[P_BIG_BUFFER_SIZE];
+    char       temp[P_BIG_BUFFER_SIZE];
+    pT_context *ctx;
 
-    /* Close all regular files */
-    p_close_file(NULL);
+    /* Close all regular files of all contexts */
+    p_mutex_lock(&p_contexts_lock);
+    for (ctx = p_contexts; ctx != NULL; ctx = ctx->next) {
+        p_close_context(ctx);
+    }
+    p_mutex_unlock(&p_contexts_lock);
 
     /* If stdin was used, then flush it to avoid a "broken pipe" error */
     if (p_stdin_used) {
@@ -303,31 +637,88 @@ p_atexit_close (void)
 } /* p_atexit_close () */
 
 
+/*
+ * Start the access to an open file: register as user and take the
+ * lock of the record. Enters with the table lock held, which is released.
+ * Shared access (without the lock) is granted to positional reads
+ * of a file opened for reading; returns whether it was granted.
+ */
+static int
+p_acquire_idx (pT_context *ctx, const int idx, const int shared)
+{
+    p_mutex_t *lock = ctx->files[idx].lock;
+    const int granted = shared &&
+                        (ctx->files[idx].mode == p_mode_read) &&
+                        (p_fio_pread(ctx->files[idx].fp, NULL, 0, 0) == 0);
+
+    /* Keep track of events on this file */
+    ctx->event_count++;
+    ctx->files[idx].timestamp = ctx->event_count;
+    if ((ctx->files[idx].handle == NULL) && (ctx->lru_last != idx)) {
+        p_lru_unlink(ctx, idx);
+        p_lru_append(ctx, idx);
+    }
+    ctx->files[idx].users++;
+    p_mutex_unlock(&ctx->table_lock);
+
+    if (!granted) {
+        p_mutex_lock(lock);
+    }
+
+    return(granted);
+} /* p_acquire_idx () */
+
+
+/*
+ * End the access to a file, started by p_get_file_pointer()
+ * or p_get_handle_pointer().
+ */
+static void
+p_release_file (pT_context *ctx, const int idx, const int shared)
+{
+    if (idx == P_STDIO_IDX) {
+        p_mutex_unlock(&p_stdio_lock);
+        return;
+    }
+    if (!shared) {
+        p_mutex_unlock(ctx->files[idx].lock);
+    }
+
+    p_mutex_lock(&ctx->table_lock);
+    ctx->files[idx].users--;
+    if (ctx->files[idx].users == 0) {
+        p_cond_broadcast(&ctx->table_cond);
+    }
+    p_mutex_unlock(&ctx->table_lock);
+} /* p_release_file () */
+
+
+/*
+ * Get the file pointer for the access required, opening the file
+ * when necessary. On success, the calling thread has exclusive access
+ * to the file until p_release_file(ctx, *file_idx, *shared).
+ * If shared is not NULL and *shared is set, shared access for positional
+ * reads is requested; *shared returns whether it was granted.
+ */
 static FILE *
-p_get_file_pointer (const char  *name,      /* file name */
+p_get_file_pointer (pT_context  *ctx,      /* context of the file */
+                    const char  *name,      /* file name */
                     int          stdio,     /* bool: stdio or a file */
                     p_file_mode  mode,      /* file open mode */
-                    fio_offset_t size)      /* allocation size (ony used when mode==write) */
+                    fio_offset_t size,      /* allocation size (ony used when mode==write) */
+                    int         *file_idx,  /* returns the index to release the file */
+                    int         *shared)    /* shared access requested/granted, or NULL */
 {
-    FILE *fp;
-    int  i;
-    int  idx;    /* index of found/used file admin record */
-    int  lru;    /* index of least recently used (open) file */
-    int  ept;    /* index of empty slot */
+    FILE      *fp;
+    p_mutex_t *lock;
+    int       idx;    /* index of found/used file admin record */
 
 
     /* Check file name length limit */
     assert(strlen(name) < P_FILENAME_MAX);
 
-    /* Make sure the exit cleanup function is registered once. */
-    if (!p_atexit_done) {
-        p_atexit_done = 1;
-        if (atexit(p_atexit_close) != 0) {
-            assert(0);
-        }
-    }
-
     if (stdio) {
+        p_mutex_lock(&p_stdio_lock);
         if (mode == p_mode_read) {
             fp = stdin;
 #ifdef STDIO_SET_BIN
@@ -340,138 +731,221 @@ p_get_file_pointer (const char  *name,      /* file name */
             _setmode(_fileno(stdout),_O_BINARY);
 #endif
         }
-    } else {
-        idx = -1;
-        lru = -1;
-        ept = -1;
-        for (i=0; i<p_file_count; i++) {
-            if (p_files[i].fp == NULL) {
-                /* Empty slot; register first empty slot in ept */
-                if (ept == -1) {
-                    ept = i;
-                }
-            } else {
-                /* Is this the least recently used file up till now? */
-                if (lru == -1) {
-                    lru = i;
-                } else {
-                    if (p_files[i].timestamp < p_files[lru].timestamp) {
-                        lru = i;
-                    }
-                }
-            }
+        *file_idx = P_STDIO_IDX;
+        if (shared != NULL) {
+            *shared = 0;
+        }
+        return(fp);
+    }
 
-            /* Is this the file we need? */
-            if (strcmp(name, p_files[i].name) == 0) {
-                idx = i;
+    p_mutex_lock(&ctx->table_lock);
+
+    if (ctx->files == NULL) {
+        /* Make sure the exit cleanup function is registered once. */
+        p_mutex_lock(&p_atexit_lock);
+        if (!p_atexit_done) {
+            p_atexit_done = 1;
+            if (atexit(p_atexit_close) != 0) {
+                assert(0);
             }
         }
+        p_mutex_unlock(&p_atexit_lock);
+
+        if (p_alloc_file_admin(ctx, ctx->max_open_files) != P_OK) {
+            p_mutex_unlock(&ctx->table_lock);
+            return(NULL);
+        }
+    }
 
-        /* If open file found */
-        if ((idx != -1) && (p_files[idx].fp != NULL)) {
+    /* Find the file or a record for it; restart after each wait */
+    idx = -1;
+    while (idx == -1) {
+        idx = p_find_name(ctx, name);
+
+        if ((idx != -1) && (ctx->files[idx].handle != NULL)) {
+            /* Kept open by a handle: its open mode shall suffice */
+            if ((mode != p_mode_read) && (ctx->files[idx].mode == p_mode_read)) {
+                p_mutex_unlock(&ctx->table_lock);
+                return(NULL);
+            }
+        } else if (idx != -1) {
             /* Opened as read, write access required? Close it */
             /* Opened as write, read access required? Close it */
-            if ( ((mode != p_mode_read) && (p_files[idx].mode == p_mode_read)) ||
-                 ((mode == p_mode_read) && (p_files[idx].mode == p_mode_write)) ) {
-                p_close_idx(idx); /* Ignore status - we'll access the same file later */
+            if ( ((mode != p_mode_read) && (ctx->files[idx].mode == p_mode_read)) ||
+                 ((mode == p_mode_read) && (ctx->files[idx].mode == p_mode_write)) ) {
+                if (ctx->files[idx].users > 0) {
+                    /* Not while other threads access it */
+                    p_cond_wait(&ctx->table_cond, &ctx->table_lock);
+                    idx = -1;
+                    continue;
+                }
+                p_close_idx(ctx, idx); /* Ignore status - we'll access the same file later */
             }
-        }
-
-        /* Not found yet or closed? then open */
-        if ((idx == -1) || (p_files[idx].fp == NULL)) {
-            /* Get an index */
-            if (idx == -1) {
-                /* No index yet: get an empty slot, a new slot or close the lru file */
-                if (ept != -1) {
-                    /* Empty slot available: use it */
-                    idx = ept;
+        } else {
+            /* Not found: get an empty slot, a new slot or close the lru file */
+            if (ctx->file_free != -1) {
+                /* Empty slot available: use it */
+                idx = ctx->file_free;
+                ctx->file_free = ctx->files[idx].name_next;
+            } else if (ctx->file_count < ctx->max_open_files) {
+                /* Room for new open file available: use it */
+                lock = (p_mutex_t *)malloc(sizeof(p_mutex_t));
+                if (lock == NULL) {
+                    p_mutex_unlock(&ctx->table_lock);
+                    return(NULL);
+                }
+                p_mutex_init(lock);
+                idx = ctx->file_count;
+                ctx->file_count++;
+                ctx->files[idx].fp    = NULL;
+                ctx->files[idx].users = 0;
+                ctx->files[idx].lock  = lock;
+            } else {
+                /* All slots occupied: close least recently used file that is not in use */
+                for (idx = ctx->lru_first; (idx != -1) && (ctx->files[idx].users > 0); idx = ctx->files[idx].lru_next) {
+                    ;
+                }
+                if (idx != -1) {
+                    p_close_idx(ctx, idx); /* Ignore status -- close error is a different file... */
+                } else if (ctx->lru_first != -1) {
+                    /* All files in use by other threads */
+                    p_cond_wait(&ctx->table_cond, &ctx->table_lock);
                 } else {
-                    /* No empty slot available */
-                    if (p_file_count < P_MAX_OPEN_FILES) {
-                        /* Room for new open file available: use it */
-                        idx = p_file_count;
-                        p_file_count++;
-                    } else {
-                        /* All slots occupied: close least recently used file and use its admin record */
-                        idx = lru;
-                        p_close_idx(idx); /* Ignore status -- close error is a different file... */
-                    }
+                    /* All files are kept open by a handle */
+                    p_mutex_unlock(&ctx->table_lock);
+                    return(NULL);
                 }
             }
+        }
+    }
 
-            p_files[idx].fp = p_fio_fopen(name, p_mode_str[mode], (mode==p_mode_write)?size:-1);
-
-            /* only if the fopen succeeds register the result! */
-            /* this will prevent a crash if the same file is
-               later opened again! */
-            if (p_files[idx].fp != NULL) {
-                strcpy(p_files[idx].name, name);
-                p_files[idx].mode = mode;
-                p_files[idx].timestamp = 0;
-                p_files[idx].no_of_images = 0;
-                p_files[idx].size_header = 0;
-                p_files[idx].size_image = 0;
-                p_files[idx].hdr_nr_images = 0;
-            }
+    /* Not open yet or closed? then open */
+    if (ctx->files[idx].fp == NULL) {
+        ctx->files[idx].fp = p_fio_fopen(name, p_mode_str[mode], (mode==p_mode_write)?size:-1);
+
+        /* only if the fopen succeeds register the result! */
+        /* this will prevent a crash if the same file is
+           later opened again! */
+        if (ctx->files[idx].fp != NULL) {
+            strcpy(ctx->files[idx].name, name);
+            ctx->files[idx].mode = mode;
+            ctx->files[idx].timestamp = 0;
+            ctx->files[idx].no_of_images = 0;
+            ctx->files[idx].size_header = 0;
+            ctx->files[idx].size_image = 0;
+            ctx->files[idx].hdr_nr_images = 0;
+            ctx->files[idx].access_mode = ctx->file_access_mode;
+            ctx->files[idx].handle = NULL;
+            p_hash_insert(ctx, idx);
+            p_lru_append(ctx, idx);
+        } else {
+            ctx->files[idx].name_next = ctx->file_free;
+            ctx->file_free = idx;
+            p_mutex_unlock(&ctx->table_lock);
+            return(NULL);
         }
-        /*
-         * Set buffer size. Has only effect immediately after
-         * an open. It is placed here since the p_open_file()
-         * call cannot pass the buffer size. So when the file
-         * is opened via p_open_file(), then the buffer size
-         * is actually set at the first other file access
-         * call.
-         */
-        if (p_file_buffer_size_kb != 0) {
-            p_fio_bufsize(p_files[idx].fp, p_file_buffer_size_kb*1024);
+    }
+
+    /*
+     * Set buffer size. Has only effect immediately after
+     * an open. It is placed here since the p_open_file()
+     * call cannot pass the buffer size. So when the file
+     * is opened via p_open_file(), then the buffer size
+     * is actually set at the first other file access
+     * call. Not while other threads access the file.
+     */
+    if (ctx->files[idx].users == 0) {
+        if (ctx->file_buffer_size_kb != 0) {
+            p_fio_bufsize(ctx->files[idx].fp, ctx->file_buffer_size_kb*1024);
         }
+        if (ctx->files[idx].access_mode & ~P_FILE_ACCESS_MMAP) {
+            p_fio_access(ctx->files[idx].fp,
+                         ((ctx->files[idx].access_mode & P_FILE_ACCESS_URING)  ? FIO_ACCESS_URING  : 0) |
+                         ((ctx->files[idx].access_mode & P_FILE_ACCESS_DIRECT) ? FIO_ACCESS_DIRECT : 0) |
+                         ((ctx->files[idx].access_mode & P_FILE_ACCESS_THREAD) ? FIO_ACCESS_THREAD : 0) |
+                         ((ctx->files[idx].access_mode & P_FILE_ACCESS_STREAM) ? FIO_ACCESS_STREAM : 0));
+        }
+    }
 
-        /* Keep track of events on this file */
-        p_event_count++;
-        p_files[idx].timestamp = p_event_count;
-        fp = p_files[idx].fp;
-    } /* end of if (stdio) */
+    fp = ctx->files[idx].fp;
+    if (shared != NULL) {
+        *shared = p_acquire_idx(ctx, idx, *shared);
+    } else {
+        p_acquire_idx(ctx, idx, 0);
+    }
 
+    *file_idx = idx;
     return(fp);
 } /* end of p_get_file_pointer () */
 
 
 /*
- * Set the file length of the file pointer
+ * Get the file pointer of a handle, for the access required.
+ * On success, as p_get_file_pointer().
+ */
+static FILE *
+p_get_handle_pointer (pT_file *file, p_file_mode mode, int *file_idx, int *shared)
+{
+    pT_context *ctx = file->context;
+    FILE       *fp;
+    int        idx;
+
+    p_mutex_lock(&ctx->table_lock);
+    idx = file->idx;
+    if ((idx == -1) ||
+        ((mode != p_mode_read) && (ctx->files[idx].mode == p_mode_read))) {
+        p_mutex_unlock(&ctx->table_lock);
+        return(NULL);
+    }
+    fp = ctx->files[idx].fp;
+    if (shared != NULL) {
+        *shared = p_acquire_idx(ctx, idx, *shared);
+    } else {
+        p_acquire_idx(ctx, idx, 0);
+    }
+
+    *file_idx = idx;
+    return(fp);
+} /* end of p_get_handle_pointer () */
+
+
+/*
+ * Set the file length of the file
  * (in the administration only; will be written to disk
  * at file close).
  */
 static void
-p_set_file_length (FILE *fp, const long no_of_images)
+p_set_file_length (pT_context *ctx, const int idx, const long no_of_images)
 {
-    int  i;
-
-    for (i=0; i<p_file_count; i++) {
-        if (p_files[i].fp == fp) {
-            if (no_of_images > p_files[i].no_of_images) {
-                p_files[i].no_of_images = no_of_images;
-            }
-        }
+    if ((idx >= 0) && (no_of_images > ctx->files[idx].no_of_images)) {
+        ctx->files[idx].no_of_images = no_of_images;
     }
 } /* p_set_file_length () */
 
 
+/*
+ * Get the file access mode flags of the file
+ * (as they were at the time the file was opened).
+ */
+static int
+p_get_access_mode (pT_context *ctx, const int idx)
+{
+    return((idx >= 0) ? ctx->files[idx].access_mode : P_FILE_ACCESS_DEFAULT);
+} /* p_get_access_mode () */
+
+
 /*
  * Set the file header and image sizes
  * (in the administration only, will be used to adjest file
  * length when closing the file)
  */
 static void
-p_set_file_size_info (FILE *fp, const long size_header, const long size_image, const long hdr_nr_images)
+p_set_file_size_info (pT_context *ctx, const int idx, const long size_header, const long size_image, const long hdr_nr_images)
 {
-    int  i;
-
-    for (i=0; i<p_file_count; i++) {
-        if (p_files[i].fp == fp) {
-            p_files[i].size_header   = size_header;
-            p_files[i].size_image    = size_image;
-            p_files[i].hdr_nr_images = hdr_nr_images;
-        }
+    if (idx >= 0) {
+        ctx->files[idx].size_header   = size_header;
+        ctx->files[idx].size_image    = size_image;
+        ctx->files[idx].hdr_nr_images = hdr_nr_images;
     }
 } /* p_set_file_size_info () */
 
@@ -479,13 +953,15 @@ p_set_file_size_info (FILE *fp, const long size_header, const long size_image, c
 pT_status
 p_open_file (const char *filename, int write)
 {
+    pT_context *ctx = p_context_get();
     pT_status status;
     FILE      *fp;
+    int       file_idx;
     const int        stdio = !strcmp(filename, "-");
 
 
     status = P_OK;
-    fp = p_get_file_pointer(filename, stdio, (write) ? p_mode_write : p_mode_read, (fio_offset_t)-1);
+    fp = p_get_file_pointer(ctx, filename, stdio, (write) ? p_mode_write : p_mode_read, (fio_offset_t)-1, &file_idx, NULL);
 
     if (fp == NULL) {
         if (write) {
@@ -493,6 +969,8 @@ p_open_file (const char *filename, int write)
         } else {
             status = P_FILE_OPEN_FAILED;
         }
+    } else {
+        p_release_file(ctx, file_idx, 0);
     }
 
     return(status);
@@ -502,7 +980,7 @@ p_open_file (const char *filename, int write)
 pT_status
 p_set_file_buf_size (const int size_kb)
 {
-    p_file_buffer_size_kb = size_kb;
+    p_context_get()->file_buffer_size_kb = size_kb;
     return P_OK;
 } /* end of p_set_file_buf_size */
 
@@ -510,64 +988,292 @@ p_set_file_buf_size (const int size_kb)
 int
 p_get_file_buf_size (void)
 {
-    return(p_file_buffer_size_kb);
+    return(p_context_get()->file_buffer_size_kb);
 } /* end of p_get_file_buf_size */
 
 
-/******************************************************************************/
+pT_status
+p_set_parallel_conversion (const int enable)
+{
+    p_parallel_conversion = (enable != 0);
+    return(P_OK);
+} /* end of p_set_parallel_conversion */
 
-static void
-p_add_offset (unsigned long *offset_hi,
-              unsigned long *offset_lo,
-              long  value)
+
+int
+p_get_parallel_conversion (void)
 {
-    fio_offset_t  offset;
+    return(p_parallel_conversion);
+} /* end of p_get_parallel_conversion */
 
-#if FIO_LARGE_FILE_SUPPORTED
-    offset = ((fio_offset_t)(*offset_hi) << 32) + ((fio_offset_t)(*offset_lo) & 0xFFFFFFFF);
-#else
-    offset = (fio_offset_t)*offset_lo;
-#endif
 
-    offset += value;
+pT_status
+p_set_file_access_mode (const int mode)
+{
+    p_context_get()->file_access_mode = mode;
+    return P_OK;
+} /* end of p_set_file_access_mode */
 
-#if FIO_LARGE_FILE_SUPPORTED
-    (*offset_lo) = (unsigned long)(offset & 0xFFFFFFFF);
-    (*offset_hi) = (unsigned long)(offset >> 32);
-#else
-    (*offset_lo) = (unsigned long)offset;
-#endif
-} /* end of p_add_offset () */
 
+int
+p_get_file_access_mode (void)
+{
+    return(p_context_get()->file_access_mode);
+} /* end of p_get_file_access_mode */
 
-static pT_status
-p_write_data (FILE   *file_ptr,
-              int    stdio,
-              void   *buf,
-              size_t size)
+
+pT_status
+p_set_max_open_files (const int max_files)
 {
-    size_t    ret;
-    pT_status status = P_OK;
-    if (stdio) {
-        ret = fwrite(buf, (size_t)sizeof(char), size, file_ptr);
-        ret = size; /* Make writes to stdout appear succesful */
-    } else {
-        ret = p_fio_fwrite(buf, (size_t)sizeof(char), size, file_ptr);
-    }
+    pT_context *ctx = p_context_get();
+    pT_status  status = P_OK;
 
-    if (ret != size) {
-        status = P_WRITE_FAILED;
+    if (max_files < 1) {
+        return(P_ILLEGAL_MAX_OPEN_FILES);
+    }
+    p_mutex_lock(&ctx->table_lock);
+    if (ctx->files != NULL) {
+        /* The records move: wait until no file is in use */
+        p_wait_no_users(ctx);
+        /* Fewer records than in use: close all files first */
+        if (max_files < ctx->file_count) {
+            status = p_close_all(ctx);
+        }
+        if (p_alloc_file_admin(ctx, max_files) != P_OK) {
+            status = P_MALLOC_FAILED;
+        }
+    }
+    if (status != P_MALLOC_FAILED) {
+        ctx->max_open_files = max_files;
     }
+    p_mutex_unlock(&ctx->table_lock);
 
     return(status);
-} /* end of p_write_data () */
+} /* end of p_set_max_open_files */
 
 
-static pT_status
-p_read_data (FILE   *file_ptr,
-             int    stdio,
-             void   *buf,
-             size_t size)
+int
+p_get_max_open_files (void)
+{
+    return(p_context_get()->max_open_files);
+} /* end of p_get_max_open_files */
+
+
+pT_status
+p_file_open (const char *filename, int write, pT_file **file)
+{
+    pT_context *ctx = p_context_get();
+    pT_status  status;
+    pT_file    *handle;
+    int        idx = -1;
+
+    *file = NULL;
+    /* Standard i/o has no entry in the file administration */
+    if (!strcmp(filename, "-")) {
+        return(P_FILE_OPEN_FAILED);
+    }
+    handle = (pT_file *)malloc(sizeof(pT_file));
+    if (handle == NULL) {
+        return(P_MALLOC_FAILED);
+    }
+
+    status = p_read_header(filename, &handle->header);
+    if ((status == P_OK) &&
+        (p_get_file_pointer(ctx, filename, 0, (write) ? p_mode_update : p_mode_read, (fio_offset_t)-1, &idx, NULL) == NULL)) {
+        status = (write) ? P_FILE_MODIFY_FAILED : P_FILE_OPEN_FAILED;
+    }
+    if (status == P_OK) {
+        p_mutex_lock(&ctx->table_lock);
+        if (ctx->files[idx].handle != NULL) {
+            /* Only one handle per file */
+            status = P_FILE_OPEN_FAILED;
+        } else {
+            /* Keep the file open until p_file_close() */
+            strcpy(handle->name, filename);
+            handle->idx     = idx;
+            handle->context = ctx;
+            handle->data    = NULL;
+            ctx->files[idx].handle = handle;
+            p_lru_unlink(ctx, idx);
+            *file = handle;
+        }
+        p_mutex_unlock(&ctx->table_lock);
+        p_release_file(ctx, idx, 0);
+    }
+    if (status != P_OK) {
+        free(handle);
+    }
+
+    return(status);
+} /* end of p_file_open */
+
+
+pT_status
+p_file_close (pT_file *file)
+{
+    pT_context *ctx;
+    pT_status  status = P_OK;
+    int        idx;
+
+    if (file == NULL) {
+        return(status);
+    }
+    ctx = file->context;
+    p_mutex_lock(&ctx->table_lock);
+    /* Wait until the file is not in use */
+    while (((idx = file->idx) != -1) && (ctx->files[idx].users > 0)) {
+        p_cond_wait(&ctx->table_cond, &ctx->table_lock);
+    }
+    if (idx != -1) {
+        status = p_close_idx(ctx, idx);
+        ctx->files[idx].name_next = ctx->file_free;
+        ctx->file_free = idx;
+    }
+    p_mutex_unlock(&ctx->table_lock);
+    free(file);
+
+    return(status);
+} /* end of p_file_close */
+
+
+const pT_header *
+p_file_get_header (const pT_file *file)
+{
+    return(&file->header);
+} /* end of p_file_get_header */
+
+
+pT_status
+p_context_create (pT_context **context)
+{
+    pT_context *ctx;
+
+    *context = NULL;
+    ctx = (pT_context *)malloc(sizeof(pT_context));
+    if (ctx == NULL) {
+        return(P_MALLOC_FAILED);
+    }
+    ctx->files               = NULL;
+    ctx->max_open_files      = P_MAX_OPEN_FILES;
+    ctx->file_count          = 0;
+    ctx->file_free           = -1;
+    ctx->name_hash           = NULL;
+    ctx->hash_mask           = 0;
+    ctx->lru_first           = -1;
+    ctx->lru_last            = -1;
+    ctx->event_count         = 0;
+    ctx->file_buffer_size_kb = 0;
+    ctx->file_access_mode    = P_FILE_ACCESS_DEFAULT;
+    p_mutex_init(&ctx->table_lock);
+    p_cond_init(&ctx->table_cond);
+
+    p_mutex_lock(&p_contexts_lock);
+    ctx->next  = p_contexts;
+    p_contexts = ctx;
+    p_mutex_unlock(&p_contexts_lock);
+
+    *context = ctx;
+    return(P_OK);
+} /* end of p_context_create */
+
+
+pT_status
+p_context_destroy (pT_context *context)
+{
+    pT_context **link;
+    pT_status  status;
+
+    if ((context == NULL) || (context == &p_default_context)) {
+        return(P_OK);
+    }
+
+    p_mutex_lock(&p_contexts_lock);
+    for (link = &p_contexts; *link != context; link = &(*link)->next) {
+        assert(*link != NULL);
+    }
+    *link = context->next;
+    p_mutex_unlock(&p_contexts_lock);
+
+    status = p_close_context(context);
+    p_cond_destroy(&context->table_cond);
+    p_mutex_destroy(&context->table_lock);
+    free(context);
+
+    return(status);
+} /* end of p_context_destroy */
+
+
+pT_context *
+p_context_select (pT_context *context)
+{
+    pT_context *previous = p_current_context;
+
+    p_current_context = context;
+    return(previous);
+} /* end of p_context_select */
+
+
+pT_context *
+p_context_current (void)
+{
+    return(p_current_context);
+} /* end of p_context_current */
+
+
+/******************************************************************************/
+
+static void
+p_add_offset (unsigned long *offset_hi,
+              unsigned long *offset_lo,
+              long  value)
+{
+    fio_offset_t  offset;
+
+#if FIO_LARGE_FILE_SUPPORTED
+    offset = ((fio_offset_t)(*offset_hi) << 32) + ((fio_offset_t)(*offset_lo) & 0xFFFFFFFF);
+#else
+    offset = (fio_offset_t)*offset_lo;
+#endif
+
+    offset += value;
+
+#if FIO_LARGE_FILE_SUPPORTED
+    (*offset_lo) = (unsigned long)(offset & 0xFFFFFFFF);
+    (*offset_hi) = (unsigned long)(offset >> 32);
+#else
+    (*offset_lo) = (unsigned long)offset;
+#endif
+} /* end of p_add_offset () */
+
+
+static pT_status
+p_write_data (FILE   *file_ptr,
+              int    stdio,
+              void   *buf,
+              size_t size)
+{
+    size_t    ret;
+    pT_status status = P_OK;
+    if (stdio) {
+        ret = fwrite(buf, (size_t)sizeof(char), size, file_ptr);
+        ret = size; /* Make writes to stdout appear succesful */
+    } else {
+        ret = p_fio_fwrite(buf, (size_t)sizeof(char), size, file_ptr);
+    }
+
+    if (ret != size) {
+        status = P_WRITE_FAILED;
+    }
+
+    return(status);
+} /* end of p_write_data () */
+
+
+static pT_status
+p_read_data (FILE   *file_ptr,
+             int    stdio,
+             void   *buf,
+             size_t size)
 {
     size_t    ret;
     pT_status status;
@@ -587,6 +1293,50 @@ p_read_data (FILE   *file_ptr,
 } /* end of p_read_data () */
 
 
+/* Get file data in memory (see p_read_images()); NULL if not present */
+static const unsigned char *
+p_get_data_at (const pT_file *file,
+               size_t        size,
+               fio_offset_t  offset)
+{
+    if ((offset < file->data_offset) ||
+        (offset + (fio_offset_t)size > file->data_offset + (fio_offset_t)file->data_size)) {
+        return(NULL);
+    }
+    return(file->data + (size_t)(offset - file->data_offset));
+} /* end of p_get_data_at () */
+
+
+/*
+ * Read data at a file offset; the file position is not used.
+ * If file has data in memory, the data is taken from there.
+ */
+static pT_status
+p_read_data_at (FILE          *file_ptr,
+                const pT_file *file,
+                void          *buf,
+                size_t        size,
+                fio_offset_t  offset)
+{
+    pT_status            status;
+    const unsigned char *data;
+
+    status = P_OK;
+    if ((file != NULL) && (file->data != NULL)) {
+        data = p_get_data_at(file, size, offset);
+        if (data == NULL) {
+            status = P_READ_FAILED;
+        } else {
+            memcpy(buf, data, size);
+        }
+    } else if (p_fio_pread(file_ptr, buf, size, offset) != (long)size) {
+        status = P_READ_FAILED;
+    }
+
+    return(status);
+} /* end of p_read_data_at () */
+
+
 static int
 p_end_of_file (FILE   *file_ptr,
                int    stdio)
@@ -968,8 +1718,10 @@ p_read_hdr (const char *filename, pT_header *header,
     const int        stdio = !strcmp(filename, "-");
     fio_offset_t     new_offset;
     long             amount;
+    int              file_idx = -1;
+    pT_context      *ctx = p_context_get();
 
-    file_ptr = p_get_file_pointer(filename, stdio, p_mode_read, (fio_offset_t)-1);
+    file_ptr = p_get_file_pointer(ctx, filename, stdio, p_mode_read, (fio_offset_t)-1, &file_idx, NULL);
 
     if (file_ptr == NULL) {
         if (print_error) {
@@ -1298,7 +2050,8 @@ p_read_hdr (const char *filename, pT_header *header,
         } /* end of if (header->nr_compon > P_PFSPD_MAX_COMP) { */
 
         /* Cache header and image sizes */
-        p_set_file_size_info (file_ptr, p_get_size_header(header), p_get_size_image(header), header->nr_images);
+        p_set_file_size_info (ctx, file_idx, p_get_size_header(header), p_get_size_image(header), header->nr_images);
+        p_release_file(ctx, file_idx, 0);
     } /* end of if (file_ptr == NULL) { */
 
     return status;
@@ -1321,6 +2074,8 @@ p_write_hdr (const char *filename, pT_header *header,
     const int        stdio = !strcmp(filename, "-");
     fio_offset_t     new_offset;
     long             amount;
+    int              file_idx = -1;
+    pT_context      *ctx = p_context_get();
 
     buf = malloc ((size_t)(header->bytes_rec + 1));
     if (buf == NULL) {
@@ -1354,7 +2109,7 @@ p_write_hdr (const char *filename, pT_header *header,
              */
             new_offset = (fio_offset_t) p_get_size_header( header );
             new_offset += (fio_offset_t) header->nr_images * p_get_size_image( header );
-            file_ptr = p_get_file_pointer(filename, stdio, rewrite ? p_mode_update : p_mode_write, new_offset );
+            file_ptr = p_get_file_pointer(ctx, filename, stdio, rewrite ? p_mode_update : p_mode_write, new_offset, &file_idx, NULL);
         }
 
         if (file_ptr == NULL) {
@@ -1503,8 +2258,11 @@ p_write_hdr (const char *filename, pT_header *header,
         } /* end of for (i = 0; i < header->nr_compon; i++) { */
     } /* end of if (status == P_OK) */
 
-    /* Cache header and image sizes */
-    p_set_file_size_info (file_ptr, p_get_size_header(header), p_get_size_image(header), header->nr_images);
+    if (file_ptr != NULL) {
+        /* Cache header and image sizes */
+        p_set_file_size_info (ctx, file_idx, p_get_size_header(header), p_get_size_image(header), header->nr_images);
+        p_release_file(ctx, file_idx, 0);
+    }
 
     if (buf != NULL) {
         free (buf);
@@ -1514,44 +2272,204 @@ p_write_hdr (const char *filename, pT_header *header,
 } /* end of p_write_hdr () */
 
 
+/***************************************************************
+*                                                              *
+*       Sample conversion                                      *
+*                                                              *
+***************************************************************/
+
+/* minimum number of file bytes converted by one band */
+#define P_BAND_MIN_SIZE            (64 * 1024)
+
+/* size of one element in memory */
+static size_t
+p_mem_el_size (int mem_type)
+{
+    return((mem_type == P_UNSIGNED_SHORT) ? sizeof(unsigned short) : sizeof(unsigned char));
+} /* end of p_mem_el_size () */
+
+
+/* Convert one line of file samples into memory samples */
+static pT_status
+p_convert_line_in (const p_convert_t *cnv,
+                   const void        *file_buffer,
+                   void              *mem_buffer)
+{
+    int first;
+
+    if (cnv->line == NULL) {
+        return(P_UNKNOWN_FILE_TYPE);
+    }
+
+    /* the vector kernels convert the first samples, the specialized
+       conversion the remaining ones (see cpfspd_cnv.c) */
+    first = p_convert_in_vector(cnv, file_buffer, mem_buffer);
+    cnv->line(file_buffer, mem_buffer, first, cnv->width);
+
+    return(P_OK);
+} /* end of p_convert_line_in () */
+
+
+/* Convert one line of memory samples into file samples */
+static pT_status
+p_convert_line_out (const p_convert_t *cnv,
+                    const void        *mem_buffer,
+                    void              *file_buffer)
+{
+    int first;
+
+    if (cnv->line == NULL) {
+        return(P_UNKNOWN_FILE_TYPE);
+    }
+
+    /* the vector kernels convert the first samples, the specialized
+       conversion the remaining ones (see cpfspd_cnv.c) */
+    first = p_convert_out_vector(cnv, mem_buffer, file_buffer);
+    cnv->line(mem_buffer, file_buffer, first, cnv->width);
+
+    return(P_OK);
+} /* end of p_convert_line_out () */
+
+
+/* Conversion of an image in bands of lines */
+typedef struct {
+    const p_convert_t   *cnv;
+    int                 in;             /* bool: file to memory, or memory to file */
+    int                 copy;           /* bool: copy, no conversion needed */
+    const unsigned char *src;
+    size_t              src_stride;     /* in bytes */
+    size_t              src_field;      /* in bytes: offset of the second field
+                                           in src, 0 for a single image */
+    unsigned char       *dst;
+    size_t              dst_stride;     /* in bytes */
+    int                 height;
+    int                 band_lines;     /* lines per band */
+    p_atomic_t          status;         /* P_OK, or the error of a failing band */
+} p_bands_t;
+
+/* Convert one band; task of p_convert_bands() */
+static void
+p_convert_band (void *arg, int band)
+{
+    p_bands_t           *bands = (p_bands_t *)arg;
+    const int           last = MIN((band + 1) * bands->band_lines, bands->height);
+    const unsigned char *src;
+    pT_status           status = P_OK;
+    int                 y;
+
+    for (y = band * bands->band_lines; y < last; y++) {
+        if (bands->src_field != 0) {
+            /* weave: the lines of the fields alternate */
+            src = bands->src + (y & 1) * bands->src_field + (y >> 1) * bands->src_stride;
+        } else {
+            src = bands->src + y * bands->src_stride;
+        }
+        if (bands->copy) {
+            memcpy(bands->dst + y * bands->dst_stride, src,
+                   (size_t)bands->cnv->width * p_mem_el_size(bands->cnv->mem_type));
+        } else if (bands->in) {
+            status = p_convert_line_in(bands->cnv, src,
+                                       bands->dst + y * bands->dst_stride);
+        } else {
+            status = p_convert_line_out(bands->cnv, src,
+                                        bands->dst + y * bands->dst_stride);
+        }
+        if (status != P_OK) {
+            /* the remaining lines of the band fail alike */
+            p_atomic_set(&bands->status, (long)status);
+            return;
+        }
+    }
+} /* end of p_convert_band () */
+
+
+/*
+ * Convert the lines of bands->height lines. With parallel conversion,
+ * they are divided in bands of lines that are converted by the worker
+ * threads. A failing band stops and its error is returned.
+ */
+static pT_status
+p_convert_bands (p_bands_t *bands)
+{
+    const p_convert_t *cnv = bands->cnv;
+    size_t            line_size;
+    int               num_bands;
+
+    /* file type is checked once, not per band */
+    if ((cnv->file_type != P_UNSIGNED_CHAR) &&
+        (cnv->file_type != P_UNSIGNED_SHORT)) {
+        return(P_UNKNOWN_FILE_TYPE);
+    }
+
+    bands->band_lines = bands->height;
+    if (p_parallel_conversion && (bands->height > 1)) {
+        /* lines per band: all threads get work, but not too little */
+        line_size = (size_t)cnv->width * ((cnv->file_type == P_UNSIGNED_SHORT) ? 2 : 1);
+        num_bands = p_work_threads();
+        bands->band_lines = MAX((bands->height + num_bands - 1) / num_bands,
+                                (int)(P_BAND_MIN_SIZE / MAX(line_size, 1)));
+        bands->band_lines = MAX(bands->band_lines, 1);
+    }
+    num_bands = (bands->height + bands->band_lines - 1) / bands->band_lines;
+
+    p_atomic_set(&bands->status, (long)P_OK);
+    p_work_run(p_convert_band, (void *)bands, num_bands);
+
+    /* the error of a band, if any */
+    return((pT_status)p_atomic_get(&bands->status));
+} /* end of p_convert_bands () */
+
+
+/* Convert the lines of an image, see p_convert_bands() */
+static pT_status
+p_convert_image (const p_convert_t   *cnv,
+                 int                 in,
+                 const unsigned char *src,
+                 size_t              src_stride,
+                 unsigned char       *dst,
+                 size_t              dst_stride,
+                 int                 height)
+{
+    p_bands_t bands;
+
+    bands.cnv        = cnv;
+    bands.in         = in;
+    bands.copy       = 0;
+    bands.src        = src;
+    bands.src_stride = src_stride;
+    bands.src_field  = 0;
+    bands.dst        = dst;
+    bands.dst_stride = dst_stride;
+    bands.height     = height;
+
+    return(p_convert_bands(&bands));
+} /* end of p_convert_image () */
+
+
 /***************************************************************
 *                                                              *
 *       Read an image                                          *
 *                                                              *
 ***************************************************************/
-pT_status
-p_read_image (const char *filename, pT_header *header,
-              int nr, int comp_nr,
-              void *mem_buffer,
-              int mem_type,     /* unsigned char = 8, unsigned short = 16 */
-              int mem_data_fmt, /* see description in cpfspd.h            */
-              int width,
-              int height,
-              int stride,
-              FILE *stream_error, int print_error)
+/*
+ * Set up the conversion of the samples of a component of the file
+ * into the memory format: cnv, the size of a file sample, and whether
+ * the samples can be copied (skip_conversion)
+ */
+static pT_status
+p_init_convert_in (pT_header *header, int comp_nr,
+                   int mem_type, int mem_data_fmt, int local_width,
+                   p_convert_t *cnv, size_t *file_el_size, int *skip_conversion)
 {
     pT_status     status = P_OK;
-    fio_offset_t  offset;
-    int           i;
-    const int     stdio = !strcmp(filename, "-");
-    FILE         *file_ptr = NULL;
-    const int     local_width  = MIN(width, header->comp[comp_nr].pix_line);
-    const int     local_height = MIN(height, header->comp[comp_nr].lin_image);
     pT_data_fmt   file_data_fmt = P_UNKNOWN_DATA_FORMAT;
     int           file_no_bits;        /* no of bits per element in file     */
     int           mem_no_bits;         /* no of bits per element in memory   */
     int           file_type;           /* unsigned char=8, unsigned short=16 */
-    void         *file_buffer = NULL;  /* pointer to file buffer             */
-    size_t        file_el_size = 0ul;  /* size of one element in file buffer */
-    unsigned int  sample;
     int           shift_left_factor = 0;
     int           shift_right_factor = 0;
     unsigned int  pre_mask  = 0u;
     unsigned int  post_mask = 0u;
-    int           x;
-    int           y;
-    int           file_buffer_allocated = 0;
-    int           skip_conversion = 0;
 
     /* determine file data format of this component  */
     file_data_fmt = p_get_comp_data_format (header, comp_nr);
@@ -1563,7 +2481,7 @@ p_read_image (const char *filename, pT_header *header,
 
     if (status == P_OK) {
         /* determine size of one element in file buffer */
-        status = p_get_element_size (file_type, &file_el_size);
+        status = p_get_element_size (file_type, file_el_size);
 
         /* determine shift_left/right_factor, pre_mask & post_mask */
         shift_left_factor  = mem_no_bits - file_no_bits;
@@ -1613,16 +2531,79 @@ p_read_image (const char *filename, pT_header *header,
             (mem_no_bits == file_no_bits) &&
             (   (mem_no_bits == 8) ||
                 (p_system_is_little_endian() == header->little_endian) )) {
-            skip_conversion = 1;
+            *skip_conversion = 1;
+        }
+
+        cnv->file_type          = file_type;
+        cnv->mem_type           = mem_type;
+        cnv->little_endian      = header->little_endian;
+        cnv->pre_mask           = pre_mask;
+        cnv->post_mask          = post_mask;
+        cnv->shift_left_factor  = shift_left_factor;
+        cnv->shift_right_factor = shift_right_factor;
+        cnv->width              = local_width;
+        cnv->line               = p_convert_line(0, file_no_bits, header->little_endian,
+                                                 mem_type, mem_no_bits,
+                                                 mem_data_fmt == P_16_BIT_MEM_LSB);
+    } /* end of if (status == P_OK) */
+
+    return status;
+} /* end of p_init_convert_in () */
+
+
+pT_status
+p_read_image (const char *filename, pT_file *file, pT_header *header,
+              int nr, int comp_nr,
+              void *mem_buffer,
+              int mem_type,     /* unsigned char = 8, unsigned short = 16 */
+              int mem_data_fmt, /* see description in cpfspd.h            */
+              int width,
+              int height,
+              int stride,
+              FILE *stream_error, int print_error)
+{
+    pT_status     status = P_OK;
+    fio_offset_t  offset;
+    const int     stdio = !strcmp(filename, "-");
+    FILE         *file_ptr = NULL;
+    int           file_idx = -1;
+    pT_context   *ctx = (file != NULL) ? file->context : p_context_get();
+    const int     local_width  = MIN(width, header->comp[comp_nr].pix_line);
+    const int     local_height = MIN(height, header->comp[comp_nr].lin_image);
+    void         *file_buffer = NULL;  /* pointer to file buffer             */
+    size_t        file_el_size = 0ul;  /* size of one element in file buffer */
+    p_convert_t   cnv;                 /* conversion to memory format        */
+    int           y;
+    int           file_buffer_allocated = 0;
+    int           skip_conversion = 0;
+    int           shared = !stdio;     /* positional reads, shared access */
+    int           all_lines = 0;       /* read all lines in one transfer     */
+    int           in_bands = 0;        /* read at once, convert in bands     */
+    size_t        image_size = 0;      /* bytes of all lines in the file     */
+    const unsigned char *image_data = NULL;
+    const int     in_memory = (file != NULL) && (file->data != NULL);
+
+    status = p_init_convert_in (header, comp_nr, mem_type, mem_data_fmt, local_width,
+                                &cnv, &file_el_size, &skip_conversion);
+
+    if (status == P_OK) {
+        /* With parallel conversion, all lines are read with a single
+         * transfer and converted in bands by the worker threads.
+         */
+        if (!skip_conversion && (local_height > 1) &&
+            p_parallel_conversion && (p_work_threads() > 1)) {
+            in_bands   = 1;
+            image_size = (size_t)(local_height - 1) * header->comp[comp_nr].pix_line * file_el_size +
+                         (size_t)local_width * file_el_size;
         }
 
         if (skip_conversion) {
             /* to avoid memcpy, we assign mem_buffer to file_buffer */
             file_buffer = (void *) mem_buffer;
-        } else {
+        } else if (!in_memory) {
             if (status == P_OK) {
-                /* allocate file buffer (one line) */
-                file_buffer = malloc ((size_t)local_width * file_el_size);
+                /* allocate file buffer (one line, or all lines) */
+                file_buffer = malloc (in_bands ? image_size : (size_t)local_width * file_el_size);
                 if (file_buffer == NULL) {
                     status = P_MALLOC_FAILED;
                 } /* end of if (local_buffer == NULL) */
@@ -1632,9 +2613,16 @@ p_read_image (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        file_ptr = p_get_file_pointer(filename, stdio, p_mode_read, (fio_offset_t)-1);
+        if (in_memory) {
+            /* file data in memory: no file access */
+            shared = 1;
+        } else if (file != NULL) {
+            file_ptr = p_get_handle_pointer(file, p_mode_read, &file_idx, &shared);
+        } else {
+            file_ptr = p_get_file_pointer(ctx, filename, stdio, p_mode_read, (fio_offset_t)-1, &file_idx, &shared);
+        }
 
-        if (file_ptr == NULL) {
+        if ((file_ptr == NULL) && !in_memory) {
             if (print_error) {
                 fprintf (stream_error, "\nERROR: Unable to open file: %s\n",
                          filename);
@@ -1642,150 +2630,116 @@ p_read_image (const char *filename, pT_header *header,
             }
             status = P_FILE_OPEN_FAILED;
         } else {
-            /* skip header and previous images */
-            offset  = p_get_size_header(header);
-            offset += (nr - 1) * (fio_offset_t)p_get_size_image(header);
-            /* skip current image aux data */
-            offset += header->nr_aux_data_recs * header->bytes_rec;
-            /* skip previous components of current image */
-            for (i = 0; i < comp_nr; i++) {
-                offset += p_get_size_comp (header->comp[i].pix_line,
-                                           header->comp[i].lin_image,
-                                           header->comp[i].data_fmt);
+            offset = p_get_offset_comp(header, nr, comp_nr);
+
+            /* With shared access, the file position and the header
+             * are left untouched: each line is read at its offset.
+             * Lines that are adjacent both in the file and in
+             * memory are read in a single transfer.
+             */
+            if (shared) {
+                all_lines = skip_conversion &&
+                            (local_width == header->comp[comp_nr].pix_line) &&
+                            (stride == local_width);
             }
 
             /* go to new file offset */
-            if (status == P_OK) {
+            if ((status == P_OK) && !shared) {
                 status = p_position_pointer (file_ptr, stdio,
                                              &header->offset_hi,
                                              &header->offset_lo,
                                              offset, 0);
-            } /* end of if (status == P_OK) */
+            } /* end of if ((status == P_OK) && !shared) */
 
-            for (y = 0; y < local_height; y++) {
-                if (status == P_OK) {
-                    status = p_read_data(file_ptr, stdio, file_buffer, (size_t)local_width * file_el_size);
+            if (in_bands) {
+                if ((status == P_OK) && in_memory) {
+                    image_data = p_get_data_at(file, image_size, offset);
+                    if (image_data == NULL) {
+                        status = P_READ_FAILED;
+                    }
+                } else if ((status == P_OK) && shared) {
+                    status = p_read_data_at(file_ptr, NULL, file_buffer, image_size, offset);
+                    image_data = (const unsigned char *) file_buffer;
+                } else if (status == P_OK) {
+                    status = p_read_data(file_ptr, stdio, file_buffer, image_size);
+                    /* update current file pointer */
+                    p_add_offset(&header->offset_hi,
+                                 &header->offset_lo,
+                                 (long)image_size);
+                    image_data = (const unsigned char *) file_buffer;
                 }
-
-                /* update current file pointer */
-                p_add_offset(&header->offset_hi,
-                             &header->offset_lo,
-                             (long)((size_t)local_width * file_el_size));
-
-                /* new offset */
-                offset += header->comp[comp_nr].pix_line * (int)file_el_size;
-                /* go to new file offset */
                 if (status == P_OK) {
-                    status = p_position_pointer (file_ptr, stdio,
-                                                 &header->offset_hi,
-                                                 &header->offset_lo,
-                                                 offset, 0);
-                } /* end of if (status == P_OK) */
-
-                /* copy file_buffer to mem_buffer */
-                if (!skip_conversion) {
-                    /* convert file buffer types into samples
-                     * and store in mem buffers */
+                    status = p_convert_image(&cnv, 1,
+                                             image_data,
+                                             (size_t)header->comp[comp_nr].pix_line * file_el_size,
+                                             (unsigned char *) mem_buffer,
+                                             (size_t)stride * p_mem_el_size(mem_type),
+                                             local_height);
+                }
+            } else {
+                for (y = 0; y < local_height; y++) {
+                    if (status == P_OK) {
+                        if (!shared) {
+                            status = p_read_data(file_ptr, stdio, file_buffer, (size_t)local_width * file_el_size);
+                        } else if (in_memory && !skip_conversion) {
+                            /* convert directly from the data in memory */
+                            file_buffer = (void *) p_get_data_at(file, (size_t)local_width * file_el_size, offset);
+                            if (file_buffer == NULL) {
+                                status = P_READ_FAILED;
+                            }
+                        } else if (!all_lines || (y == 0)) {
+                            status = p_read_data_at(file_ptr, file, file_buffer,
+                                                    (size_t)local_width * file_el_size * (all_lines ? local_height : 1),
+                                                    offset);
+                        }
+                    }
 
-                    /* Note, there is a little bit duplicated code
-                       here for performance optimization. No switch/if
-                       statements in the inner loop. */
+                    if (!shared) {
+                        /* update current file pointer */
+                        p_add_offset(&header->offset_hi,
+                                     &header->offset_lo,
+                                     (long)((size_t)local_width * file_el_size));
+                    }
 
-                    switch (file_type) {
+                    /* new offset */
+                    offset += header->comp[comp_nr].pix_line * (int)file_el_size;
+                    /* go to new file offset */
+                    if ((status == P_OK) && !shared) {
+                        status = p_position_pointer (file_ptr, stdio,
+                                                     &header->offset_hi,
+                                                     &header->offset_lo,
+                                                     offset, 0);
+                    } /* end of if ((status == P_OK) && !shared) */
+
+                    /* copy file_buffer to mem_buffer */
+                    if ((status == P_OK) && !skip_conversion) {
+                        status = p_convert_line_in(&cnv, file_buffer, mem_buffer);
+                    } /* end of  if ((status == P_OK) && !skip_conversion) */
+
+                    /* advance pointer to buffer */
+                    switch (mem_type) {
                     case P_UNSIGNED_CHAR:
-                        if (mem_type == P_UNSIGNED_CHAR) {
-                            /* we normally shouldn't get here
-                             * no need to assert, just a bit slower */
-                            for (x = 0; x < local_width; x++) {
-                                ((unsigned char*)mem_buffer)[x] = ((unsigned char*)file_buffer)[x];
-                            }
-                        } else {
-                            for (x = 0; x < local_width; x++) {
-                                sample = (unsigned int) ((unsigned char*)file_buffer)[x];
-                                sample &= pre_mask;
-                                sample >>= shift_right_factor;  /* either shift left or */
-                                sample <<= shift_left_factor;   /* shift right is zero */
-                                sample &= post_mask;
-                                ((unsigned short*)mem_buffer)[x] = (unsigned short) sample;
-                            }
+                        mem_buffer = (void*)((unsigned char*)mem_buffer + stride);
+                        if (skip_conversion) {
+                            file_buffer = (void *) mem_buffer;
                         }
                         break;
                     case P_UNSIGNED_SHORT:
-                        if (header->little_endian) {
-                            /* little endian file format */
-                            if (mem_type == P_UNSIGNED_CHAR) {
-                                for (x = 0; x < local_width; x++) {
-                                    sample = ((unsigned int) ((unsigned char*)file_buffer)[2*x]) +
-                                             ((unsigned int) ((unsigned char*)file_buffer)[2*x+1] << 8);
-                                    sample &= pre_mask;
-                                    sample >>= shift_right_factor;  /* either shift left or */
-                                    sample <<= shift_left_factor;   /* shift right is zero */
-                                    sample &= post_mask;
-                                    ((unsigned char*)mem_buffer)[x] = (unsigned char) sample;
-                                }
-                            } else {
-                                for (x = 0; x < local_width; x++) {
-                                    sample = ((unsigned int) ((unsigned char*)file_buffer)[2*x]) +
-                                             ((unsigned int) ((unsigned char*)file_buffer)[2*x+1] << 8);
-                                    sample &= pre_mask;
-                                    sample >>= shift_right_factor;  /* either shift left or */
-                                    sample <<= shift_left_factor;   /* shift right is zero */
-                                    sample &= post_mask;
-                                    ((unsigned short*)mem_buffer)[x] = (unsigned short) sample;
-                                }
-                            }
-                        } else {
-                            /* big endian file format */
-                            if (mem_type == P_UNSIGNED_CHAR) {
-                                for (x = 0; x < local_width; x++) {
-                                    sample = ((unsigned int) ((unsigned char*)file_buffer)[2*x] << 8) +
-                                             ((unsigned int) ((unsigned char*)file_buffer)[2*x+1]);
-                                    sample &= pre_mask;
-                                    sample >>= shift_right_factor;  /* either shift left or */
-                                    sample <<= shift_left_factor;   /* shift right is zero */
-                                    sample &= post_mask;
-                                    ((unsigned char*)mem_buffer)[x] = (unsigned char) sample;
-                                }
-                            } else {
-                                for (x = 0; x < local_width; x++) {
-                                    sample = ((unsigned int) ((unsigned char*)file_buffer)[2*x] << 8) +
-                                             ((unsigned int) ((unsigned char*)file_buffer)[2*x+1]);
-                                    sample &= pre_mask;
-                                    sample >>= shift_right_factor;  /* either shift left or */
-                                    sample <<= shift_left_factor;   /* shift right is zero */
-                                    sample &= post_mask;
-                                    ((unsigned short*)mem_buffer)[x] = (unsigned short) sample;
-                                }
-                            }
+                        mem_buffer = (void*)((unsigned short*)mem_buffer + stride);
+                        if (skip_conversion) {
+                            file_buffer = (void *) mem_buffer;
                         }
                         break;
                     default:
-                        status = P_UNKNOWN_FILE_TYPE;
-                        sample = 0u;
+                        status = P_UNKNOWN_MEM_TYPE;
                         break;
-                    } /* end of switch (file_type) */
-                } /* end of  if (!skip_conversion) */
-
-                /* advance pointer to buffer */
-                switch (mem_type) {
-                case P_UNSIGNED_CHAR:
-                    mem_buffer = (void*)((unsigned char*)mem_buffer + stride);
-                    if (skip_conversion) {
-                        file_buffer = (void *) mem_buffer;
-                    }
-                    break;
-                case P_UNSIGNED_SHORT:
-                    mem_buffer = (void*)((unsigned short*)mem_buffer + stride);
-                    if (skip_conversion) {
-                        file_buffer = (void *) mem_buffer;
-                    }
-                    break;
-                default:
-                    status = P_UNKNOWN_MEM_TYPE;
-                    break;
-                } /* end of switch (mem_type) */
-            } /* end of for (y = 0;... */
-        } /* end of if (file_ptr == NULL) { */
+                    } /* end of switch (mem_type) */
+                } /* end of for (y = 0;... */
+            } /* end of if (in_bands) */
+            if (!in_memory) {
+                p_release_file(ctx, file_idx, shared);
+            }
+        } /* end of if ((file_ptr == NULL) && !in_memory) { */
     } /* end of if (status == P_OK) */
 
     if (file_buffer_allocated && ((file_buffer != NULL))) {
@@ -1796,13 +2750,353 @@ p_read_image (const char *filename, pT_header *header,
 } /* end of p_read_image () */
 
 
+/***************************************************************
+*                                                              *
+*       Read the fields of a frame                             *
+*                                                              *
+***************************************************************/
+/*
+ * Read the two fields of a frame of an interlaced file (images nr and
+ * nr+1) and weave them into the lines of mem_buffer. The lines of both
+ * fields are read with a single transfer, including the data in between
+ * if that is not larger than a field; else with one transfer per field.
+ * Both fields are then converted or copied in one pass (the lines of
+ * the fields alternate in mem_buffer, so they cannot be read there
+ * directly). height is the height of a field, stride the stride of
+ * the frame. Not for standard input: it can only be read in file order.
+ */
+pT_status
+p_read_fields (const char *filename, pT_file *file, pT_header *header,
+               int nr, int comp_nr,
+               void *mem_buffer,
+               int mem_type,     /* unsigned char = 8, unsigned short = 16 */
+               int mem_data_fmt, /* see description in cpfspd.h            */
+               int width,
+               int height,
+               int stride,
+               FILE *stream_error, int print_error)
+{
+    pT_status     status = P_OK;
+    FILE         *file_ptr = NULL;
+    int           file_idx = -1;
+    pT_context   *ctx = (file != NULL) ? file->context : p_context_get();
+    const int     local_width  = MIN(width, header->comp[comp_nr].pix_line);
+    const int     local_height = MIN(height, header->comp[comp_nr].lin_image);
+    size_t        file_el_size = 0ul;  /* size of one element in file buffer */
+    size_t        field_size = 0;      /* bytes of all lines of a field      */
+    unsigned char *file_buffer = NULL; /* both fields, one after the other   */
+    const unsigned char *field_data[2];
+    fio_offset_t  offset[2];           /* of the fields in the file          */
+    size_t        read_size[2];        /* per transfer; 0: no transfer       */
+    unsigned char *read_buf;
+    p_convert_t   cnv;                 /* conversion to memory format        */
+    p_bands_t     bands;
+    int           skip_conversion = 0;
+    int           shared = 1;          /* positional reads, shared access */
+    int           field;
+    const int     in_memory = (file != NULL) && (file->data != NULL);
+
+    status = p_init_convert_in (header, comp_nr, mem_type, mem_data_fmt, local_width,
+                                &cnv, &file_el_size, &skip_conversion);
+    if ((status != P_OK) || (local_height < 1) || (local_width < 1)) {
+        return status;
+    }
+    field_size = (size_t)(local_height - 1) * header->comp[comp_nr].pix_line * file_el_size +
+                 (size_t)local_width * file_el_size;
+    for (field = 0; field < 2; field++) {
+        offset[field] = p_get_offset_comp(header, nr + field, comp_nr);
+    }
+
+    if (in_memory) {
+        /* file data in memory: no file access */
+        for (field = 0; (field < 2) && (status == P_OK); field++) {
+            field_data[field] = p_get_data_at(file, field_size, offset[field]);
+            if (field_data[field] == NULL) {
+                status = P_READ_FAILED;
+            }
+        }
+    } else {
+        if (offset[1] - offset[0] <= 2 * (fio_offset_t)field_size) {
+            /* one transfer from the first field up to the end of the second */
+            read_size[0] = (size_t)(offset[1] - offset[0]) + field_size;
+            read_size[1] = 0;
+        } else {
+            read_size[0] = field_size;
+            read_size[1] = field_size;
+        }
+        file_buffer = (unsigned char *) malloc (read_size[0] + read_size[1]);
+        if (file_buffer == NULL) {
+            return P_MALLOC_FAILED;
+        }
+        field_data[0] = file_buffer;
+        field_data[1] = (read_size[1] != 0) ? file_buffer + field_size
+                                            : file_buffer + (size_t)(offset[1] - offset[0]);
+        if (file != NULL) {
+            file_ptr = p_get_handle_pointer(file, p_mode_read, &file_idx, &shared);
+        } else {
+            file_ptr = p_get_file_pointer(ctx, filename, 0, p_mode_read, (fio_offset_t)-1, &file_idx, &shared);
+        }
+
+        if (file_ptr == NULL) {
+            if (print_error) {
+                fprintf (stream_error, "\nERROR: Unable to open file: %s\n",
+                         filename);
+                fprintf (stream_error, "errno: %d\n", errno);
+            }
+            status = P_FILE_OPEN_FAILED;
+        } else {
+            read_buf = file_buffer;
+            for (field = 0; (field < 2) && (read_size[field] != 0) && (status == P_OK); field++) {
+                if (shared) {
+                    status = p_read_data_at(file_ptr, NULL, read_buf,
+                                            read_size[field], offset[field]);
+                } else {
+                    status = p_position_pointer (file_ptr, 0,
+                                                 &header->offset_hi,
+                                                 &header->offset_lo,
+                                                 offset[field], 0);
+                    if (status == P_OK) {
+                        status = p_read_data(file_ptr, 0, read_buf,
+                                             read_size[field]);
+                        /* update current file pointer */
+                        p_add_offset(&header->offset_hi,
+                                     &header->offset_lo,
+                                     (long)read_size[field]);
+                    }
+                }
+                read_buf += read_size[field];
+            } /* end of for (field = 0; ... */
+            p_release_file(ctx, file_idx, shared);
+        } /* end of if (file_ptr == NULL) */
+    } /* end of if (in_memory) */
+
+    /* weave the lines of both fields into the frame */
+    if (status == P_OK) {
+        bands.cnv        = &cnv;
+        bands.in         = 1;
+        bands.copy       = skip_conversion;
+        bands.src        = field_data[0];
+        bands.src_stride = (size_t)header->comp[comp_nr].pix_line * file_el_size;
+        bands.src_field  = (size_t)(field_data[1] - field_data[0]);
+        bands.dst        = (unsigned char *) mem_buffer;
+        bands.dst_stride = (size_t)stride * p_mem_el_size(mem_type);
+        bands.height     = 2 * local_height;
+        status = p_convert_bands(&bands);
+    }
+
+    free (file_buffer);
+
+    return status;
+} /* end of p_read_fields () */
+
+
+/***************************************************************
+*                                                              *
+*       Read images into memory                                *
+*                                                              *
+***************************************************************/
+/*
+ * Read the file data of images nr .. nr+num_images-1 with a single
+ * transfer. The data is allocated and assigned to file->data; the
+ * caller shall free it. p_read_image() with this file then takes
+ * the data from memory. If file is (a copy of) an open handle, the
+ * data is read via the handle, else via filename.
+ */
+pT_status
+p_read_images (const char *filename, pT_file *file, pT_header *header,
+               int nr, int num_images,
+               FILE *stream_error, int print_error)
+{
+    pT_status           status = P_OK;
+    const int           stdio = !strcmp(filename, "-");
+    const fio_offset_t  offset = p_get_size_header(header) +
+                                 (nr - 1) * (fio_offset_t)p_get_size_image(header);
+    const size_t        size = (size_t)num_images * p_get_size_image(header);
+    unsigned char      *data;
+    FILE               *file_ptr;
+    int                 file_idx = -1;
+    pT_context         *ctx = (file->idx >= 0) ? file->context : p_context_get();
+    int                 shared = !stdio;
+
+    file->data = NULL;
+    data = (unsigned char *)malloc(size);
+    if (data == NULL) {
+        return(P_MALLOC_FAILED);
+    }
+
+    if (file->idx >= 0) {
+        file_ptr = p_get_handle_pointer(file, p_mode_read, &file_idx, &shared);
+    } else {
+        file_ptr = p_get_file_pointer(ctx, filename, stdio, p_mode_read, (fio_offset_t)-1, &file_idx, &shared);
+    }
+    if (file_ptr == NULL) {
+        if (print_error) {
+            fprintf (stream_error, "\nERROR: Unable to open file: %s\n",
+                     filename);
+            fprintf (stream_error, "errno: %d\n", errno);
+        }
+        status = P_FILE_OPEN_FAILED;
+    } else {
+        if (shared) {
+            status = p_read_data_at(file_ptr, NULL, data, size, offset);
+        } else {
+            status = p_position_pointer (file_ptr, stdio,
+                                         &header->offset_hi,
+                                         &header->offset_lo,
+                                         offset, 0);
+            if (status == P_OK) {
+                status = p_read_data(file_ptr, stdio, data, size);
+            }
+            /* update current file pointer */
+            p_add_offset(&header->offset_hi,
+                         &header->offset_lo,
+                         (long)size);
+        }
+        p_release_file(ctx, file_idx, shared);
+    }
+
+    if (status == P_OK) {
+        file->data        = data;
+        file->data_offset = offset;
+        file->data_size   = size;
+    } else {
+        free(data);
+    }
+
+    return status;
+} /* end of p_read_images () */
+
+
+/*
+ * Returns whether the file can be read by several threads at once,
+ * i.e. with positional reads that do not use the file position in
+ * the header (see p_read_images()). Not for standard input.
+ */
+int
+p_read_shared (const char *filename)
+{
+    pT_context *ctx = p_context_get();
+    FILE       *file_ptr;
+    int        file_idx = -1;
+    int        shared = 1;
+
+    if (!strcmp(filename, "-")) {
+        return(0);
+    }
+    file_ptr = p_get_file_pointer(ctx, filename, 0, p_mode_read, (fio_offset_t)-1, &file_idx, &shared);
+    if (file_ptr == NULL) {
+        /* the error is reported by the read itself */
+        return(0);
+    }
+    p_release_file(ctx, file_idx, shared);
+
+    return(shared);
+} /* end of p_read_shared () */
+
+
+/***************************************************************
+*                                                              *
+*       Map an image (zero-copy access)                        *
+*                                                              *
+***************************************************************/
+pT_status
+p_map_image (const char *filename, pT_header *header,
+             int nr, int comp_nr,
+             void **mem_buffer,
+             int mem_type,     /* unsigned char = 8, unsigned short = 16 */
+             int *stride,
+             int write,
+             FILE *stream_error, int print_error)
+{
+    pT_status     status = P_OK;
+    fio_offset_t  offset;
+    const int     stdio = !strcmp(filename, "-");
+    FILE         *file_ptr = NULL;
+    int           file_idx = -1;
+    pT_context   *ctx = p_context_get();
+    pT_data_fmt   file_data_fmt = P_UNKNOWN_DATA_FORMAT;
+    int           file_no_bits;        /* no of bits per element in file     */
+    int           mem_no_bits;         /* no of bits per element in memory   */
+    int           file_type;           /* unsigned char=8, unsigned short=16 */
+    size_t        comp_size;
+    void         *data;
+
+    (*mem_buffer) = NULL;
+    (*stride)     = 0;
+
+    /* determine file data format of this component  */
+    file_data_fmt = p_get_comp_data_format (header, comp_nr);
+
+    /* determine word widths; data is presented as is in the file */
+    status = p_get_word_widths (file_data_fmt, P_AF_BIT_MEM,
+                                &file_no_bits, &mem_no_bits,
+                                &file_type);
+
+    if (status == P_OK) {
+        if ((mem_type != P_UNSIGNED_CHAR) &&
+            (mem_type != P_UNSIGNED_SHORT)) {
+            status = P_UNKNOWN_MEM_TYPE;
+        }
+    }
+
+    /* only possible where p_read_image() would skip the conversion */
+    if (status == P_OK) {
+        if (stdio ||
+            (mem_type != file_type) ||
+            (   (file_no_bits != 8) &&
+                (p_system_is_little_endian() != header->little_endian) )) {
+            status = P_MAP_NOT_SUPPORTED;
+        }
+    }
+
+    if (status == P_OK) {
+        file_ptr = p_get_file_pointer(ctx, filename, stdio, write ? p_mode_update : p_mode_read, (fio_offset_t)-1, &file_idx, NULL);
+
+        if (file_ptr == NULL) {
+            if (print_error) {
+                fprintf (stream_error, "\nERROR: Unable to %s file: %s\n",
+                         write ? "modify" : "open", filename);
+                fprintf (stream_error, "errno: %d\n", errno);
+            }
+            status = write ? P_FILE_MODIFY_FAILED : P_FILE_OPEN_FAILED;
+        } else {
+            offset    = p_get_offset_comp(header, nr, comp_nr);
+            comp_size = (size_t)p_get_size_comp (header->comp[comp_nr].pix_line,
+                                                 header->comp[comp_nr].lin_image,
+                                                 header->comp[comp_nr].data_fmt);
+
+            /* note: the file position (header->offset_hi/lo) is not affected */
+            data = p_fio_mmap(file_ptr, offset, comp_size, write);
+            if (data == NULL) {
+                if (print_error) {
+                    fprintf (stream_error, "\nERROR: Unable to map file: %s\n",
+                             filename);
+                    fprintf (stream_error, "errno: %d\n", errno);
+                }
+                status = P_MAP_FAILED;
+            } else {
+                (*mem_buffer) = data;
+                (*stride)     = header->comp[comp_nr].pix_line;
+                if (write) {
+                    /* The application writes the data: count the image as written */
+                    p_set_file_length (ctx, file_idx, nr);
+                }
+            }
+            p_release_file(ctx, file_idx, 0);
+        } /* end of if (file_ptr == NULL) { */
+    } /* end of if (status == P_OK) */
+
+    return status;
+} /* end of p_map_image () */
+
+
 /***************************************************************
 *                                                              *
 *       Write an image                                         *
 *                                                              *
 ***************************************************************/
 pT_status
-p_write_image (const char *filename, pT_header *header,
+p_write_image (const char *filename, pT_file *file, pT_header *header,
                int nr, int comp_nr,
                const void *mem_buffer,
                int mem_type,     /* unsigned char = 8, unsigned short = 16 */
@@ -1814,9 +3108,10 @@ p_write_image (const char *filename, pT_header *header,
 {
     pT_status     status = P_OK;
     fio_offset_t  offset;
-    int           i;
     const int     stdio = !strcmp(filename, "-");
     FILE         *file_ptr = NULL;
+    int           file_idx = -1;
+    pT_context   *ctx = (file != NULL) ? file->context : p_context_get();
     const int     local_width  = MIN(width, header->comp[comp_nr].pix_line);
     const int     local_height = MIN(height, header->comp[comp_nr].lin_image);
     pT_data_fmt   file_data_fmt = P_UNKNOWN_DATA_FORMAT;
@@ -1824,16 +3119,15 @@ p_write_image (const char *filename, pT_header *header,
     int           mem_no_bits;         /* no of bits per element in memory   */
     int           file_type;           /* unsigned char=8, unsigned short=16 */
     void         *file_buffer = NULL;  /* pointer to file buffer             */
-    void         *temp_conversion_buffer = NULL; /* pointer to temp conversion buffer from file_buffer */
     size_t        file_el_size = 0ul;  /* size of one element in file buffer */
-    unsigned int  sample;
     int           shift_left_factor = 0;
     int           shift_right_factor = 0;
     unsigned int  mask  = 0u;
-    int           x;
-    int           y;
+    p_convert_t   cnv;                 /* conversion to file format          */
     int           file_buffer_allocated = 0;
+    int           file_buffer_mapped = 0;
     int           skip_conversion = 0;
+    int           converted = 0;       /* converted before file access       */
     size_t		  comp_size = 0;	/* total bytes write */
     int			  file_stride = 0;
 
@@ -1884,6 +3178,23 @@ p_write_image (const char *filename, pT_header *header,
             skip_conversion = 1;
         }
 
+        /* parameter check */
+        if ((mem_type != P_UNSIGNED_CHAR) &&
+            (mem_type != P_UNSIGNED_SHORT)) {
+            status = P_UNKNOWN_MEM_TYPE;
+        }
+
+        cnv.file_type          = file_type;
+        cnv.mem_type           = mem_type;
+        cnv.little_endian      = header->little_endian;
+        cnv.pre_mask           = mask;
+        cnv.post_mask          = 0xffffu;
+        cnv.shift_left_factor  = shift_left_factor;
+        cnv.shift_right_factor = shift_right_factor;
+        cnv.width              = local_width;
+        cnv.line               = p_convert_line(1, file_no_bits, header->little_endian,
+                                                mem_type, mem_no_bits, 0);
+
 		comp_size = p_get_size_comp (header->comp[comp_nr].pix_line,
                                            header->comp[comp_nr].lin_image,
                                            header->comp[comp_nr].data_fmt);
@@ -1892,22 +3203,34 @@ p_write_image (const char *filename, pT_header *header,
         if (skip_conversion) {
             /* to avoid memcpy, we assign mem_buffer to file_buffer */
             file_buffer = (void *)((unsigned char*)mem_buffer);
-        } else {
+        } else if (stdio || !(ctx->file_access_mode & P_FILE_ACCESS_MMAP)) {
+            /* Convert before the file is acquired, so the conversion
+             * overlaps with writes of other threads to the same file.
+             */
+            file_buffer = malloc (comp_size);
+            if (file_buffer == NULL) {
+                status = P_MALLOC_FAILED;
+            } /* end of if (file_buffer == NULL) */
+            file_buffer_allocated = 1;
+            file_stride = local_width * file_el_size;
             if (status == P_OK) {
-                /* allocate file buffer (one component) */
-                file_buffer = malloc (comp_size);
-                if (file_buffer == NULL) {
-                    status = P_MALLOC_FAILED;
-                } /* end of if (local_buffer == NULL) */
-                file_buffer_allocated = 1;
-                temp_conversion_buffer = file_buffer;
-                file_stride = local_width * file_el_size;
-            } /* end of if (status == P_OK) */
+                status = p_convert_image(&cnv, 0,
+                                         (const unsigned char *)mem_buffer,
+                                         (size_t)stride * p_mem_el_size(mem_type),
+                                         (unsigned char *)file_buffer,
+                                         (size_t)file_stride,
+                                         local_height);
+            }
+            converted = 1;
         }
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        file_ptr = p_get_file_pointer(filename, stdio, p_mode_update, (fio_offset_t)-1);
+        if (file != NULL) {
+            file_ptr = p_get_handle_pointer(file, p_mode_update, &file_idx, NULL);
+        } else {
+            file_ptr = p_get_file_pointer(ctx, filename, stdio, p_mode_update, (fio_offset_t)-1, &file_idx, NULL);
+        }
 
         if (file_ptr == NULL) {
             if (print_error) {
@@ -1917,17 +3240,7 @@ p_write_image (const char *filename, pT_header *header,
             }
             status = P_FILE_MODIFY_FAILED;
         } else {
-            /* skip header and previous images */
-            offset  = p_get_size_header(header);
-            offset += (nr - 1) * (fio_offset_t)p_get_size_image(header);
-            /* skip current image aux data */
-            offset += header->nr_aux_data_recs * header->bytes_rec;
-            /* skip previous components of current image */
-            for (i = 0; i < comp_nr; i++) {
-                offset += p_get_size_comp (header->comp[i].pix_line,
-                                           header->comp[i].lin_image,
-                                           header->comp[i].data_fmt);
-            }
+            offset = p_get_offset_comp(header, nr, comp_nr);
 
 
             /* go to new file offset */
@@ -1938,104 +3251,40 @@ p_write_image (const char *filename, pT_header *header,
                                              offset, 1);
             }
 
+            if ((status == P_OK) && !skip_conversion && !converted) {
+                /* If requested, convert straight into a memory mapping
+                 * of the file. This is only possible if the file already
+                 * has its final size (known nr_images at p_write_hdr()).
+                 */
+                if (!stdio && (p_get_access_mode(ctx, file_idx) & P_FILE_ACCESS_MMAP)) {
+                    file_buffer = p_fio_mmap(file_ptr, offset, comp_size, 1);
+                }
+                if (file_buffer != NULL) {
+                    file_buffer_mapped = 1;
+                    file_stride = header->comp[comp_nr].pix_line * file_el_size;
+                } else {
+                    /* allocate file buffer (one component) */
+                    file_buffer = malloc (comp_size);
+                    if (file_buffer == NULL) {
+                        status = P_MALLOC_FAILED;
+                    } /* end of if (local_buffer == NULL) */
+                    file_buffer_allocated = 1;
+                    file_stride = local_width * file_el_size;
+                }
+            } /* end of if ((status == P_OK) && !skip_conversion && !converted) */
 
-            for (y = 0; y < local_height; y++) {
-
-                if (!skip_conversion) {
-                    /* convert memory buffer types to file buffer types */
+            /* convert memory buffer types to file buffer types */
+            if ((status == P_OK) && !skip_conversion && !converted) {
+                status = p_convert_image(&cnv, 0,
+                                         (const unsigned char *)mem_buffer,
+                                         (size_t)stride * p_mem_el_size(mem_type),
+                                         (unsigned char *)file_buffer,
+                                         (size_t)file_stride,
+                                         local_height);
+            } /* end of if ((status == P_OK) && !skip_conversion && !converted) */
 
-                    /* Note, there is a little bit duplicated code
-                       here for performance optimization. No switch/if
-                       statements in the inner loop. */
 
-                    switch (file_type) {
-                    case P_UNSIGNED_CHAR:
-                        if (mem_type == P_UNSIGNED_CHAR) {
-                            /* we normally shouldn't get here
-                             * no need to assert, just a bit slower */
-                            for (x = 0; x < local_width; x++) {
-                                ((unsigned char*)temp_conversion_buffer)[x] = ((unsigned char*)mem_buffer)[x];
-                            }
-                        } else {
-                            for (x = 0; x < local_width; x++) {
-                                sample = (unsigned int) ((unsigned short*)mem_buffer)[x];
-                                sample &= mask;
-                                sample >>= shift_right_factor;  /* either shift left or */
-                                sample <<= shift_left_factor;   /* shift right is zero */
-                                ((unsigned char*)temp_conversion_buffer)[x] = (unsigned char) sample;
-                            }
-                        }
-                        break;
-                    case P_UNSIGNED_SHORT:
-                        /* file endianness is forced equal to system endianness
-                         * (header->little_endian was set in p_write_hdr() )*/
-                        if (header->little_endian) {
-                            if (mem_type == P_UNSIGNED_CHAR) {
-                                for (x = 0; x < local_width; x++) {
-                                    sample = (unsigned int) ((unsigned char*)mem_buffer)[x];
-                                    sample &= mask;
-                                    sample >>= shift_right_factor;  /* either shift left or */
-                                    sample <<= shift_left_factor;   /* shift right is zero */
-                                    ((unsigned char*)temp_conversion_buffer)[2*x] = (unsigned char) sample;
-                                    ((unsigned char*)temp_conversion_buffer)[2*x+1] = (unsigned char) (sample >> 8);
-                                }
-                            } else {
-                                for (x = 0; x < local_width; x++) {
-                                    sample = (unsigned int) ((unsigned short*)mem_buffer)[x];
-                                    sample &= mask;
-                                    sample >>= shift_right_factor;  /* either shift left or */
-                                    sample <<= shift_left_factor;   /* shift right is zero */
-                                    ((unsigned char*)temp_conversion_buffer)[2*x] = (unsigned char) sample;
-                                    ((unsigned char*)temp_conversion_buffer)[2*x+1] = (unsigned char) (sample >> 8);
-                                }
-                            }
-                        } else {    /* big endian */
-                            if (mem_type == P_UNSIGNED_CHAR) {
-                                for (x = 0; x < local_width; x++) {
-                                    sample = (unsigned int) ((unsigned char*)mem_buffer)[x];
-                                    sample &= mask;
-                                    sample >>= shift_right_factor;  /* either shift left or */
-                                    sample <<= shift_left_factor;   /* shift right is zero */
-                                    ((unsigned char*)temp_conversion_buffer)[2*x] = (unsigned char) (sample >> 8);
-                                    ((unsigned char*)temp_conversion_buffer)[2*x+1] = (unsigned char) sample;
-                                }
-                            } else {
-                                for (x = 0; x < local_width; x++) {
-                                    sample = (unsigned int) ((unsigned short*)mem_buffer)[x];
-                                    sample &= mask;
-                                    sample >>= shift_right_factor;  /* either shift left or */
-                                    sample <<= shift_left_factor;   /* shift right is zero */
-                                    ((unsigned char*)temp_conversion_buffer)[2*x] = (unsigned char) (sample >> 8);
-                                    ((unsigned char*)temp_conversion_buffer)[2*x+1] = (unsigned char) sample;
-                                }
-                            }
-                        }
-                        break;
-                    default:
-                        status = P_UNKNOWN_FILE_TYPE;
-                        break;
-                    } /* end of switch (file_type) */
-                } /* end of  if (!skip_conversion) */
-
-                //Update temp_conversion_buffer position
-                temp_conversion_buffer = (void*)((unsigned char*)temp_conversion_buffer + file_stride);
-                /* advance pointer to buffer */
-                switch (mem_type) {
-                case P_UNSIGNED_CHAR:
-                    mem_buffer = (void*)((unsigned char*)mem_buffer + stride);
-                    break;
-                case P_UNSIGNED_SHORT:
-                    mem_buffer = (void*)((unsigned short*)mem_buffer + stride);
-                    break;
-                default:
-                    status = P_UNKNOWN_MEM_TYPE;
-                    break;
-                } /* end of switch (mem_type) */
-
-            } /* end of for (y = 0;... */
-
-
-			if (status == P_OK) {
+			if ((status == P_OK) && !file_buffer_mapped) {
                 status = p_write_data(file_ptr, stdio, file_buffer, comp_size);
             }
 
@@ -2048,7 +3297,8 @@ p_write_image (const char *filename, pT_header *header,
             /* Keep track of actual amount of images written to disk,
              * so actual amount of images can be written in header when we close the file.
              */
-            p_set_file_length (file_ptr, nr);
+            p_set_file_length (ctx, file_idx, nr);
+            p_release_file(ctx, file_idx, 0);
         } /* end of if (file_ptr == NULL) { */
     } /* end of if (status == P_OK) */
 
@@ -2075,9 +3325,11 @@ p_read_aux_data (
     int             pos = 0;
     fio_offset_t    offset;
     const int       stdio = !strcmp(filename, "-");
+    int             file_idx = -1;
+    pT_context     *ctx = p_context_get();
 
     *size = 0;
-    file_ptr = p_get_file_pointer(filename, stdio, p_mode_read, (fio_offset_t)-1);
+    file_ptr = p_get_file_pointer(ctx, filename, stdio, p_mode_read, (fio_offset_t)-1, &file_idx, NULL);
     if (file_ptr == NULL) {
         status = P_FILE_OPEN_FAILED;
     }
@@ -2104,6 +3356,7 @@ p_read_aux_data (
             status = p_read_data(file_ptr, stdio, buf, *size);
             p_add_offset(&header->offset_hi, &header->offset_lo, *size);
         }
+        p_release_file(ctx, file_idx, 0);
     } /* end of if (status == P_OK) */
     return status;
 } /* end of p_read_aux_data */
@@ -2123,8 +3376,10 @@ p_write_aux_data (
     char            temp[P_SDATA_LEN+1];
     fio_offset_t    offset;
     const int       stdio = !strcmp(filename, "-");
+    int             file_idx = -1;
+    pT_context     *ctx = p_context_get();
 
-    file_ptr = p_get_file_pointer(filename, stdio, p_mode_update, (fio_offset_t)-1);
+    file_ptr = p_get_file_pointer(ctx, filename, stdio, p_mode_update, (fio_offset_t)-1, &file_idx, NULL);
     if (file_ptr == NULL) {
         status = P_FILE_OPEN_FAILED;
     }
@@ -2149,6 +3404,7 @@ p_write_aux_data (
             status = p_write_data(file_ptr, stdio, buf, size);
             p_add_offset(&header->offset_hi, &header->offset_lo, size);
         }
+        p_release_file(ctx, file_idx, 0);
     } /* end of if (status == P_OK) */
     return status;
 } /* end of p_write_aux_data */
@@ -27,6 +27,8 @@
 #include <stdio.h>
 /* mandatory include of cpfspd.h; because of used typedefs */
 #include "cpfspd.h"
+/* mandatory include of cpfspd_fio.h; because of use of fio_offset_t */
+#include "cpfspd_fio.h"
 
 /* Auxiliary data records            */
 
@@ -37,6 +39,23 @@
 #define P_UNSIGNED_CHAR         8
 #define P_UNSIGNED_SHORT        16
 
+/*
+ * File handle, see p_file_open().
+ * Also used to read images from file data in memory, see p_read_images().
+ */
+struct pT_file_s {
+    int          idx;                    /* File admin record; -1 once the file is closed */
+    pT_context   *context;               /* Context of the file admin record */
+    char         name[P_FILENAME_MAX];   /* File name (for error messages) */
+    pT_header    header;                 /* Header, read at open */
+    const unsigned char *data;           /* File data in memory, or NULL */
+    fio_offset_t data_offset;            /* File offset of data[0] */
+    size_t       data_size;              /* Number of bytes of data */
+};
+
+extern long       p_get_size_image
+        (pT_header *header);
+
 extern pT_status  p_read_hdr 
         (const char *filename, pT_header *header, 
          FILE *stream_error, int print_error);
@@ -46,7 +65,9 @@ extern pT_status  p_write_hdr
          FILE *stream_error, int print_error, int rewrite);
 
 extern pT_status  p_read_image 
-        (const char *filename, pT_header *header, 
+        (const char *filename,
+         pT_file *file,       /* handle, or NULL to look up filename    */
+         pT_header *header, 
          int nr, int comp_nr, 
          void *mem_buffer,
          int mem_type,        /* unsigned char = 8, unsigned short = 16 */
@@ -56,8 +77,44 @@ extern pT_status  p_read_image
          int stride,          /*   store the data in                    */
          FILE *stream_error, int print_error);
 
+extern pT_status  p_read_fields
+        (const char *filename,
+         pT_file *file,       /* handle, or NULL to look up filename    */
+         pT_header *header,
+         int nr,              /* first field                            */
+         int comp_nr,
+         void *mem_buffer,    /* frame: the fields are woven            */
+         int mem_type,        /* unsigned char = 8, unsigned short = 16 */
+         int mem_data_fmt,    /* see description in cpfspd.h            */
+         int width,           /* width, field height & frame stride:    */
+         int height,          /*   define the buffer size to            */
+         int stride,          /*   store the data in                    */
+         FILE *stream_error, int print_error);
+
+extern pT_status  p_read_images
+        (const char *filename,
+         pT_file *file,       /* returns the data in memory             */
+         pT_header *header,
+         int nr,              /* first image                            */
+         int num_images,
+         FILE *stream_error, int print_error);
+
+extern int        p_read_shared
+        (const char *filename);
+
+extern pT_status  p_map_image
+        (const char *filename, pT_header *header,
+         int nr, int comp_nr,
+         void **mem_buffer,   /* returns pointer into the file mapping  */
+         int mem_type,        /* unsigned char = 8, unsigned short = 16 */
+         int *stride,         /* returns stride of the mapped data      */
+         int write,           /* bool: map for write access             */
+         FILE *stream_error, int print_error);
+
 extern pT_status  p_write_image 
-        (const char *filename, pT_header *header, 
+        (const char *filename,
+         pT_file *file,       /* handle, or NULL to look up filename    */
+         pT_header *header, 
          int nr, int comp_nr, 
          const void *mem_buffer, 
          int mem_type,        /* unsigned char = 8, unsigned short = 16 */
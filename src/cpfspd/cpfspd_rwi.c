@@ -48,19 +48,67 @@
  *                 - p_read_frame_comp_16()
  *                 - p_write_field_comp_16()
  *                 - p_write_frame_comp_16()
+ *                 - p_map_read_field_comp()
+ *                 - p_map_read_frame_comp()
+ *                 - p_map_read_field_comp_16()
+ *                 - p_map_read_frame_comp_16()
+ *                 - p_map_write_field_comp()
+ *                 - p_map_write_frame_comp()
+ *                 - p_map_write_field_comp_16()
+ *                 - p_map_write_frame_comp_16()
+ *                 - p_file_read_frame()
+ *                 - p_file_write_frame()
+ *                 - p_file_read_frame_16()
+ *                 - p_file_write_frame_16()
+ *                 - p_file_read_frame_planar()
+ *                 - p_file_write_frame_planar()
+ *                 - p_file_read_frame_planar_16()
+ *                 - p_file_write_frame_planar_16()
+ *                 - p_file_read_frame_comp()
+ *                 - p_file_write_frame_comp()
+ *                 - p_file_read_frame_comp_16()
+ *                 - p_file_write_frame_comp_16()
+ *                 - p_read_frames()
+ *                 - p_read_frames_16()
+ *                 - p_stream_open()
+ *                 - p_stream_open_16()
+ *                 - p_stream_next()
+ *                 - p_stream_next_16()
+ *                 - p_stream_release()
+ *                 - p_stream_close()
+ *                 - p_recorder_open()
+ *                 - p_recorder_open_16()
+ *                 - p_recorder_write()
+ *                 - p_recorder_write_16()
+ *                 - p_recorder_get_counts()
+ *                 - p_recorder_close()
+ *                 - p_read_frame_async()
+ *                 - p_read_frame_async_16()
+ *                 - p_write_frame_async()
+ *                 - p_write_frame_async_16()
+ *                 - p_async_done()
+ *                 - p_async_wait()
  *
  */
 
 /******************************************************************************/
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "cpfspd.h"
 #include "cpfspd_low.h"
+#include "cpfspd_thr.h"
+#include "cpfspd_wrk.h"
 
 /******************************************************************************/
 
 /* switch off debug & error printing */
 #define NOPRINT         0
 
+#define MIN(x,y)        ( ((x) < (y)) ? (x) : (y) )
+#define MAX(x,y)        ( ((x) > (y)) ? (x) : (y) )
+
 /* mask to extract component_mode from read_mode */
 #define P_COMPONENT_MODE_MASK   7u
 
@@ -70,22 +118,146 @@
 /* special value for comp parameter; can also hold the component no */
 #define P_NORMAL_COMP           (-1)
 
+/* maximum number of bytes read by one task of p_read_frames() */
+#define P_FRAMES_TASK_SIZE      (32l * 1024l * 1024l)
+
 /******************************************************************************/
 
 /*
  * Generic lowlevel read/write functions
  */
 
+/* the components of one image, read or written by p_access_comps() */
+typedef struct {
+    const char  *filename;
+    pT_file     *file;
+    pT_header   *header;
+    int         image_number;
+    int         write;          /* 0=read; 1=write */
+    int         fields;         /* read both fields of a frame, see p_read_fields() */
+    int         mem_type;
+    int         mem_data_fmt;
+    int         num_comps;
+    int         comp[3];
+    void        *buf[3];
+    int         width[3];
+    int         height[3];
+    int         stride[3];
+    pT_status   status[3];
+    pT_file     fused;          /* both fields in memory, see p_access_comps() */
+    pT_file     *src;           /* file or &fused, accessed by p_access_comp() */
+} p_comps_t;
+
+/* read or write one component; a task of p_access_comps() */
+static void
+p_access_comp (void *arg, int task)
+{
+    p_comps_t *comps = (p_comps_t *)arg;
+
+    if (comps->write) {
+        comps->status[task] = p_write_image (comps->filename, comps->src,
+                                             comps->header, comps->image_number,
+                                             comps->comp[task], comps->buf[task],
+                                             comps->mem_type, comps->mem_data_fmt,
+                                             comps->width[task], comps->height[task],
+                                             comps->stride[task],
+                                             stderr, NOPRINT);
+    } else if (comps->fields) {
+        comps->status[task] = p_read_fields (comps->filename, comps->src,
+                                             comps->header, comps->image_number,
+                                             comps->comp[task], comps->buf[task],
+                                             comps->mem_type, comps->mem_data_fmt,
+                                             comps->width[task], comps->height[task],
+                                             comps->stride[task],
+                                             stderr, NOPRINT);
+    } else {
+        comps->status[task] = p_read_image (comps->filename, comps->src,
+                                            comps->header, comps->image_number,
+                                            comps->comp[task], comps->buf[task],
+                                            comps->mem_type, comps->mem_data_fmt,
+                                            comps->width[task], comps->height[task],
+                                            comps->stride[task],
+                                            stderr, NOPRINT);
+    }
+} /* end of p_access_comp */
+
+/*
+ * Read or write the components of an image. The planes of the
+ * components are independent byte ranges of the file, so with
+ * parallel conversion they are accessed concurrently by the worker
+ * threads: the conversion of one component overlaps with the
+ * transfer of another one. Standard in/output is accessed in order.
+ * The components of both fields of a frame are read with a single
+ * transfer (p_read_images()), and then taken from memory.
+ */
+static pT_status
+p_access_comps (p_comps_t *comps)
+{
+    pT_status status = P_OK;
+    int       i;
+
+    comps->src = comps->file;
+    memset(&comps->fused, 0, sizeof(comps->fused));
+    if (comps->fields && (comps->num_comps > 1) &&
+        ((comps->file == NULL) || (comps->file->data == NULL))) {
+        if (comps->file != NULL) {
+            comps->fused = *comps->file;
+        } else {
+            comps->fused.idx = -1;
+        }
+        if (p_read_images (comps->filename, &comps->fused, comps->header,
+                           comps->image_number, 2, stderr, NOPRINT) == P_OK) {
+            comps->src = &comps->fused;
+        }
+        /* else: each component reports its own error */
+    } /* end of if (comps->fields && ... */
+
+    if ((comps->num_comps > 1) && strcmp(comps->filename, "-") &&
+        p_get_parallel_conversion()) {
+        p_work_run(p_access_comp, comps, comps->num_comps);
+        for (i = 0; (i < comps->num_comps) && (status == P_OK); i++) {
+            status = comps->status[i];
+        }
+    } else {
+        for (i = 0; (i < comps->num_comps) && (status == P_OK); i++) {
+            p_access_comp(comps, i);
+            status = comps->status[i];
+        }
+    }
+
+    if (comps->src == &comps->fused) {
+        free ((void *)comps->fused.data);
+    }
+    return status;
+} /* end of p_access_comps */
+
+/* add a component to comps */
+static void
+p_add_comp (p_comps_t *comps, int comp, void *buf,
+            int width, int height, int stride)
+{
+    const int i = comps->num_comps++;
+
+    comps->comp[i]   = comp;
+    comps->buf[i]    = buf;
+    comps->width[i]  = width;
+    comps->height[i] = height;
+    comps->stride[i] = stride;
+    comps->status[i] = P_OK;
+} /* end of p_add_comp */
+
 /* read an image */
 
 static pT_status
 p_read_buffers (const char *filename,
+                pT_file *file,
                 pT_header *header,
                 pT_color color_format,
                 int frame,
                 int field,
                 int comp,
-                int read_field, /* 0=read_frame; 1=read_field */
+                int read_field, /* 0=read_frame; 1=read_field;
+                                   2=read both fields of a frame */
                 void *buf_0,
                 void *buf_1,
                 void *buf_2,
@@ -112,6 +284,7 @@ p_read_buffers (const char *filename,
     int       height_1 = 0;
     int       height_2 = 0;
     int       image_number;
+    p_comps_t comps;
 
     /* extract component mode & mem_data_fmt from read_mode */
     component_mode = (int)((unsigned int)read_mode & P_COMPONENT_MODE_MASK);
@@ -267,30 +440,27 @@ p_read_buffers (const char *filename,
     } /* end of if (read_field) */
 
     /* read buffers */
-    if ((status == P_OK) && read_0) {
-        status = p_read_image (filename, header,
-                               image_number, comp_0,
-                               buf_0,
-                               mem_type, mem_data_fmt,
-                               width_0, height_0, stride_0,
-                               stderr, NOPRINT);
-    }  /* end of if ((status == P_OK) && read_0) */
-    if ((status == P_OK) && read_1) {
-        status = p_read_image (filename, header,
-                               image_number, 1,
-                               buf_1,
-                               mem_type, mem_data_fmt,
-                               width_1, height_1, stride_1,
-                               stderr, NOPRINT);
-    }  /* end of if ((status == P_OK) && read_1) */
-    if ((status == P_OK) && read_2) {
-        status = p_read_image (filename, header,
-                               image_number, 2,
-                               buf_2,
-                               mem_type, mem_data_fmt,
-                               width_2, height_2, stride_2,
-                               stderr, NOPRINT);
-    }  /* end of if ((status == P_OK) && read_2) */
+    comps.filename     = filename;
+    comps.file         = file;
+    comps.header       = header;
+    comps.image_number = image_number;
+    comps.write        = 0;
+    comps.fields       = (read_field == 2);
+    comps.mem_type     = mem_type;
+    comps.mem_data_fmt = mem_data_fmt;
+    comps.num_comps    = 0;
+    if (read_0) {
+        p_add_comp(&comps, comp_0, buf_0, width_0, height_0, stride_0);
+    }
+    if (read_1) {
+        p_add_comp(&comps, 1, buf_1, width_1, height_1, stride_1);
+    }
+    if (read_2) {
+        p_add_comp(&comps, 2, buf_2, width_2, height_2, stride_2);
+    }
+    if (status == P_OK) {
+        status = p_access_comps(&comps);
+    }
 
     return status;
 } /* end of p_read_buffers */
@@ -299,6 +469,7 @@ p_read_buffers (const char *filename,
 
 static pT_status
 p_write_buffers (const char *filename,
+                 pT_file *file,
                  pT_header *header,
                  pT_color color_format,
                  int frame,
@@ -330,6 +501,7 @@ p_write_buffers (const char *filename,
     int       height_1 = 0;
     int       height_2 = 0;
     int       image_number;
+    p_comps_t comps;
 
     /* extract mem_data_fmt from write_mode */
     mem_data_fmt = (int)((unsigned int)write_mode & P_MEM_DATA_FMT_MASK);
@@ -389,30 +561,27 @@ p_write_buffers (const char *filename,
     } /* end of if (write_field) */
 
     /* write buffers */
-    if ((status == P_OK) && write_0) {
-        status = p_write_image (filename, header,
-                               image_number, comp_0,
-                               buf_0,
-                               mem_type, mem_data_fmt,
-                               width_0, height_0, stride_0,
-                               stderr, NOPRINT);
-    }  /* end of if ((status == P_OK) && write_0) */
-    if ((status == P_OK) && write_1) {
-        status = p_write_image (filename, header,
-                               image_number, 1,
-                               buf_1,
-                               mem_type, mem_data_fmt,
-                               width_1, height_1, stride_1,
-                               stderr, NOPRINT);
-    }  /* end of if ((status == P_OK) && write_1) */
-    if ((status == P_OK) && write_2) {
-        status = p_write_image (filename, header,
-                               image_number, 2,
-                               buf_2,
-                               mem_type, mem_data_fmt,
-                               width_2, height_2, stride_2,
-                               stderr, NOPRINT);
-    }  /* end of if ((status == P_OK) && write_2) */
+    comps.filename     = filename;
+    comps.file         = file;
+    comps.header       = header;
+    comps.image_number = image_number;
+    comps.write        = 1;
+    comps.fields       = 0;
+    comps.mem_type     = mem_type;
+    comps.mem_data_fmt = mem_data_fmt;
+    comps.num_comps    = 0;
+    if (write_0) {
+        p_add_comp(&comps, comp_0, (void *)buf_0, width_0, height_0, stride_0);
+    }
+    if (write_1) {
+        p_add_comp(&comps, 1, (void *)buf_1, width_1, height_1, stride_1);
+    }
+    if (write_2) {
+        p_add_comp(&comps, 2, (void *)buf_2, width_2, height_2, stride_2);
+    }
+    if (status == P_OK) {
+        status = p_access_comps(&comps);
+    }
 
     return status;
 } /* end of p_write_buffers */
@@ -459,6 +628,52 @@ p_get_strides (pT_color color_format,
     return;
 } /* end of p_get_strides */
 
+/* get the sizes in bytes of the frame buffers of all components;
+   0 for components that are not in the file */
+static void
+p_get_frame_sizes (const pT_header *header,
+                   int mem_type,
+                   int frm_height,
+                   int stride,
+                   int uv_stride,
+                   size_t *sizes)
+{
+    const pT_color color_format = p_get_color_format (header);
+    int            num_comps;
+    int            strides[3];
+    int            c;
+
+    switch (color_format) {
+    case P_COLOR_422:
+    case P_COLOR_420:
+        num_comps = 2;
+        break;
+    case P_COLOR_444_PL:
+    case P_COLOR_422_PL:
+    case P_COLOR_420_PL:
+    case P_COLOR_RGB:
+    case P_COLOR_XYZ:
+        num_comps = 3;
+        break;
+    default:
+        num_comps = 1;
+        break;
+    } /* end of switch (color_format) */
+
+    p_get_strides (color_format, stride, uv_stride,
+                   &strides[0], &strides[1], &strides[2]);
+    for (c = 0; c < 3; c++) {
+        if (c < num_comps) {
+            sizes[c] = (size_t)strides[c] * (frm_height / header->comp[c].lin_sbsmpl) *
+                       (mem_type / 8);
+            sizes[c] = MAX(sizes[c], 1);
+        } else {
+            sizes[c] = 0;
+        }
+    } /* end of for (c = 0; ... */
+    return;
+} /* end of p_get_frame_sizes */
+
 /******************************************************************************/
 
 /*
@@ -469,6 +684,7 @@ p_get_strides (pT_color color_format,
 
 static pT_status
 p_read_field_all (const char *filename,
+                  pT_file *file,
                   pT_header *header,
                   pT_color color_format,
                   int frame,
@@ -499,7 +715,7 @@ p_read_field_all (const char *filename,
     } /* end of if (p_is_progressive (header)) */
 
     if (status == P_OK) {
-        status = p_read_buffers (filename, header, color_format,
+        status = p_read_buffers (filename, file, header, color_format,
                                  frame, field, comp, 1,
                                  buf_0, buf_1, buf_2,
                                  mem_type, read_mode,
@@ -514,6 +730,7 @@ p_read_field_all (const char *filename,
 
 static pT_status
 p_read_frame_all (const char *filename,
+                  pT_file *file,
                   pT_header *header,
                   pT_color color_format,
                   int frame,
@@ -540,10 +757,19 @@ p_read_frame_all (const char *filename,
     p_get_strides (color_format, stride, uv_stride,
                    &stride_0, &stride_1, &stride_2);
 
-    if (p_is_interlaced (header)) {
-        /* file is interlaced */
+    if (p_is_interlaced (header) && strcmp(filename, "-")) {
+        /* file is interlaced: read both fields of each component
+           and weave them in one pass */
+        status = p_read_buffers (filename, file, header, color_format,
+                                 frame, 1, comp, 2,
+                                 buf_0, buf_1, buf_2,
+                                 mem_type, read_mode,
+                                 width, frm_height/2,
+                                 stride_0, stride_1, stride_2);
+    } else if (p_is_interlaced (header)) {
+        /* standard input is read in file order: field by field */
         /* use p_read_buffers twice to access individual fields */
-        status = p_read_buffers (filename, header, color_format,
+        status = p_read_buffers (filename, file, header, color_format,
                                  frame, 1, comp, 1,
                                  buf_0, buf_1, buf_2,
                                  mem_type, read_mode,
@@ -570,7 +796,7 @@ p_read_frame_all (const char *filename,
             } /* end of switch (mem_type) */
             if (status == P_OK) {
                 status = p_read_buffers
-                        (filename, header, color_format,
+                        (filename, file, header, color_format,
                          frame, 2, comp, 1,
                          second_buf_0, second_buf_1, second_buf_2,
                          mem_type, read_mode,
@@ -580,7 +806,7 @@ p_read_frame_all (const char *filename,
         } /* end of if (status == P_OK) */
     } else {
         /* file is progressive */
-        status = p_read_buffers (filename, header, color_format,
+        status = p_read_buffers (filename, file, header, color_format,
                                  frame, 0, comp, 0,
                                  buf_0, buf_1, buf_2,
                                  mem_type, read_mode,
@@ -595,6 +821,7 @@ p_read_frame_all (const char *filename,
 
 static pT_status
 p_write_field_all (const char *filename,
+                   pT_file *file,
                    pT_header *header,
                    const pT_color color_format,
                    int frame,
@@ -625,7 +852,7 @@ p_write_field_all (const char *filename,
     } /* end of if (p_is_progressive (header)) */
 
     if (status == P_OK) {
-        status = p_write_buffers (filename, header, color_format,
+        status = p_write_buffers (filename, file, header, color_format,
                                   frame, field, comp, 1,
                                   buf_0, buf_1, buf_2,
                                   mem_type, write_mode,
@@ -640,6 +867,7 @@ p_write_field_all (const char *filename,
 
 static pT_status
 p_write_frame_all (const char *filename,
+                   pT_file *file,
                    pT_header *header,
                    pT_color color_format,
                    int frame,
@@ -669,7 +897,7 @@ p_write_frame_all (const char *filename,
     if (p_is_interlaced (header)) {
         /* file is interlaced */
         /* use p_write_buffers twice to access individual fields */
-        status = p_write_buffers (filename, header, color_format,
+        status = p_write_buffers (filename, file, header, color_format,
                                   frame, 1, comp, 1,
                                   buf_0, buf_1, buf_2,
                                   mem_type, write_mode,
@@ -702,7 +930,7 @@ p_write_frame_all (const char *filename,
             } /* end of switch (mem_type) */
             if (status == P_OK) {
                 status = p_write_buffers
-                        (filename, header, color_format,
+                        (filename, file, header, color_format,
                          frame, 2, comp, 1,
                          second_buf_0, second_buf_1, second_buf_2,
                          mem_type, write_mode,
@@ -712,7 +940,7 @@ p_write_frame_all (const char *filename,
         } /* end of if (status == P_OK) */
     } else {
         /* file is progressive */
-        status = p_write_buffers (filename, header, color_format,
+        status = p_write_buffers (filename, file, header, color_format,
                                   frame, 0, comp, 0,
                                   buf_0, buf_1, buf_2,
                                   mem_type, write_mode,
@@ -806,6 +1034,18 @@ p_check_comp (const pT_header *header, int comp, int reading)
     return status;
 } /* end of p_check_comp */
 
+/* check if a handle still refers to an open file */
+
+static pT_status
+p_check_handle (const pT_file *file)
+{
+    pT_status      status = P_OK;
+    if (file->idx == -1) {
+        status = P_FILE_HANDLE_CLOSED;
+    }
+    return status;
+} /* end of p_check_handle */
+
 /******************************************************************************/
 
 /*
@@ -848,7 +1088,7 @@ p_read_field (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_read_field_all (filename, header, color_format,
+        status = p_read_field_all (filename, NULL, header, color_format,
                                    frame, field, P_NORMAL_COMP,
                                    (void *)y_fld, (void *)uv_fld, NULL,
                                    P_UNSIGNED_CHAR, read_mode,
@@ -884,7 +1124,7 @@ p_read_frame (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_read_frame_all (filename, header, color_format,
+        status = p_read_frame_all (filename, NULL, header, color_format,
                                    frame, P_NORMAL_COMP,
                                    (void *)y_or_s_frm, (void *)uv_frm, NULL,
                                    P_UNSIGNED_CHAR, read_mode,
@@ -919,7 +1159,7 @@ p_write_field (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_write_field_all (filename, header, color_format,
+        status = p_write_field_all (filename, NULL, header, color_format,
                                     frame, field, P_NORMAL_COMP,
                                     (const void *)y_fld, (const void *)uv_fld, NULL,
                                     P_UNSIGNED_CHAR, P_8_BIT_MEM,
@@ -954,7 +1194,7 @@ p_write_frame (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_write_frame_all (filename, header, color_format,
+        status = p_write_frame_all (filename, NULL, header, color_format,
                                     frame, P_NORMAL_COMP,
                                     (const void *)y_or_s_frm, (const void *)uv_frm, NULL,
                                     P_UNSIGNED_CHAR, P_8_BIT_MEM,
@@ -990,7 +1230,7 @@ p_read_field_16 (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_read_field_all (filename, header, color_format,
+        status = p_read_field_all (filename, NULL, header, color_format,
                                    frame, field, P_NORMAL_COMP,
                                    (void *)y_fld, (void *)uv_fld, NULL,
                                    P_UNSIGNED_SHORT, read_mode,
@@ -1026,7 +1266,7 @@ p_read_frame_16 (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_read_frame_all (filename, header, color_format,
+        status = p_read_frame_all (filename, NULL, header, color_format,
                                    frame, P_NORMAL_COMP,
                                    (void *)y_or_s_frm, (void *)uv_frm, NULL,
                                    P_UNSIGNED_SHORT, read_mode,
@@ -1062,7 +1302,7 @@ p_write_field_16 (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_write_field_all (filename, header, color_format,
+        status = p_write_field_all (filename, NULL, header, color_format,
                                     frame, field, P_NORMAL_COMP,
                                     (const void *)y_fld, (const void *)uv_fld, NULL,
                                     P_UNSIGNED_SHORT, write_mode,
@@ -1098,7 +1338,7 @@ p_write_frame_16 (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_write_frame_all (filename, header, color_format,
+        status = p_write_frame_all (filename, NULL, header, color_format,
                                     frame, P_NORMAL_COMP,
                                     (const void *)y_or_s_frm, (const void *)uv_frm, NULL,
                                     P_UNSIGNED_SHORT, write_mode,
@@ -1146,7 +1386,7 @@ p_read_field_planar (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_read_field_all (filename, header, color_format,
+        status = p_read_field_all (filename, NULL, header, color_format,
                                    frame, field, P_NORMAL_COMP,
                                    (void *)y_or_r_fld,
                                    (void *)u_or_g_fld,
@@ -1185,7 +1425,7 @@ p_read_frame_planar (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_read_frame_all (filename, header, color_format,
+        status = p_read_frame_all (filename, NULL, header, color_format,
                                    frame, P_NORMAL_COMP,
                                    (void *)y_or_r_frm,
                                    (void *)u_or_g_frm,
@@ -1223,7 +1463,7 @@ p_write_field_planar (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_write_field_all (filename, header, color_format,
+        status = p_write_field_all (filename, NULL, header, color_format,
                                     frame, field, P_NORMAL_COMP,
                                     (const void *)y_or_r_fld,
                                     (const void *)u_or_g_fld,
@@ -1261,7 +1501,7 @@ p_write_frame_planar (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_write_frame_all (filename, header, color_format,
+        status = p_write_frame_all (filename, NULL, header, color_format,
                                     frame, P_NORMAL_COMP,
                                     (const void *)y_or_r_frm,
                                     (const void *)u_or_g_frm,
@@ -1300,7 +1540,7 @@ p_read_field_planar_16 (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_read_field_all (filename, header, color_format,
+        status = p_read_field_all (filename, NULL, header, color_format,
                                    frame, field, P_NORMAL_COMP,
                                    (void *)y_or_r_fld,
                                    (void *)u_or_g_fld,
@@ -1339,7 +1579,7 @@ p_read_frame_planar_16 (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_read_frame_all (filename, header, color_format,
+        status = p_read_frame_all (filename, NULL, header, color_format,
                                    frame, P_NORMAL_COMP,
                                    (void *)y_or_r_frm,
                                    (void *)u_or_g_frm,
@@ -1378,7 +1618,7 @@ p_write_field_planar_16 (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_write_field_all (filename, header, color_format,
+        status = p_write_field_all (filename, NULL, header, color_format,
                                     frame, field, P_NORMAL_COMP,
                                     (const void *)y_or_r_fld,
                                     (const void *)u_or_g_fld,
@@ -1417,7 +1657,7 @@ p_write_frame_planar_16 (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_write_frame_all (filename, header, color_format,
+        status = p_write_frame_all (filename, NULL, header, color_format,
                                     frame, P_NORMAL_COMP,
                                     (const void *)y_or_r_frm,
                                     (const void *)u_or_g_frm,
@@ -1455,7 +1695,7 @@ p_read_field_comp (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_read_field_all (filename, header, P_UNKNOWN_COLOR,
+        status = p_read_field_all (filename, NULL, header, P_UNKNOWN_COLOR,
                                    frame, field, comp,
                                    (void *)c_fld, NULL, NULL,
                                    P_UNSIGNED_CHAR, read_mode,
@@ -1484,7 +1724,7 @@ p_read_frame_comp (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_read_frame_all (filename, header, P_UNKNOWN_COLOR,
+        status = p_read_frame_all (filename, NULL, header, P_UNKNOWN_COLOR,
                                    frame, comp,
                                    (void *)c_frm, NULL, NULL,
                                    P_UNSIGNED_CHAR, read_mode,
@@ -1512,7 +1752,7 @@ p_write_field_comp (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_write_field_all (filename, header, P_UNKNOWN_COLOR,
+        status = p_write_field_all (filename, NULL, header, P_UNKNOWN_COLOR,
                                     frame, field, comp,
                                     (const void *)c_fld, NULL, NULL,
                                     P_UNSIGNED_CHAR, P_8_BIT_MEM,
@@ -1540,7 +1780,7 @@ p_write_frame_comp (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_write_frame_all (filename, header, P_UNKNOWN_COLOR,
+        status = p_write_frame_all (filename, NULL, header, P_UNKNOWN_COLOR,
                                     frame, comp,
                                     (const void *)c_frm, NULL, NULL,
                                     P_UNSIGNED_CHAR, P_8_BIT_MEM,
@@ -1569,7 +1809,7 @@ p_read_field_comp_16 (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_read_field_all (filename, header, P_UNKNOWN_COLOR,
+        status = p_read_field_all (filename, NULL, header, P_UNKNOWN_COLOR,
                                    frame, field, comp,
                                    (void *)c_fld, NULL, NULL,
                                    P_UNSIGNED_SHORT, read_mode,
@@ -1598,7 +1838,7 @@ p_read_frame_comp_16 (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_read_frame_all (filename, header, P_UNKNOWN_COLOR,
+        status = p_read_frame_all (filename, NULL, header, P_UNKNOWN_COLOR,
                                    frame, comp,
                                    (void *)c_frm, NULL, NULL,
                                    P_UNSIGNED_SHORT, read_mode,
@@ -1627,7 +1867,7 @@ p_write_field_comp_16 (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_write_field_all (filename, header, P_UNKNOWN_COLOR,
+        status = p_write_field_all (filename, NULL, header, P_UNKNOWN_COLOR,
                                     frame, field, comp,
                                     (const void *)c_fld, NULL, NULL,
                                     P_UNSIGNED_SHORT, write_mode,
@@ -1656,7 +1896,7 @@ p_write_frame_comp_16 (const char *filename, pT_header *header,
     } /* end of if (status == P_OK) */
 
     if (status == P_OK) {
-        status = p_write_frame_all (filename, header, P_UNKNOWN_COLOR,
+        status = p_write_frame_all (filename, NULL, header, P_UNKNOWN_COLOR,
                                     frame, comp,
                                     (const void *)c_frm, NULL, NULL,
                                     P_UNSIGNED_SHORT, write_mode,
@@ -1668,3 +1908,1827 @@ p_write_frame_comp_16 (const char *filename, pT_header *header,
 
 /******************************************************************************/
 
+/*
+ * Handle based read/write functions.
+ *
+ * The header was read and checked at p_file_open(), and the file
+ * is found via the handle instead of by its name.
+ *
+ */
+
+/* p_file_read_frame */
+pT_status
+p_file_read_frame (pT_file *file,
+                   int frame,
+                   unsigned char *y_or_s_frm,
+                   unsigned char *uv_frm,
+                   int read_mode,
+                   int width, int frm_height, int stride)
+{
+    pT_status      status = P_OK;
+    pT_header      *header = &file->header;
+    const pT_color color_format = p_get_color_format (header);
+
+    /* check if the handle is open */
+    status = p_check_handle (file);
+
+    /* check if file is in multiplexed or stream format */
+    if (status == P_OK) {
+        status = p_check_multi_or_stream (color_format);
+    } /* end of if (status == P_OK) */
+
+    if (status == P_OK) {
+        status = p_read_frame_all (file->name, file, header, color_format,
+                                   frame, P_NORMAL_COMP,
+                                   (void *)y_or_s_frm, (void *)uv_frm, NULL,
+                                   P_UNSIGNED_CHAR, read_mode,
+                                   width, frm_height, stride, 0);
+    } /* end of if (status == P_OK) */
+
+    return status;
+} /* end of p_file_read_frame */
+
+/* p_file_write_frame */
+pT_status
+p_file_write_frame (pT_file *file,
+                    int frame,
+                    const unsigned char *y_or_s_frm,
+                    const unsigned char *uv_frm,
+                    int width, int frm_height, int stride)
+{
+    pT_status      status = P_OK;
+    pT_header      *header = &file->header;
+    const pT_color color_format = p_get_color_format (header);
+
+    /* check if the handle is open */
+    status = p_check_handle (file);
+
+    /* check if file is in multiplexed format */
+    if (status == P_OK) {
+        status = p_check_multi_or_stream (color_format);
+    } /* end of if (status == P_OK) */
+
+    if (status == P_OK) {
+        status = p_write_frame_all (file->name, file, header, color_format,
+                                    frame, P_NORMAL_COMP,
+                                    (const void *)y_or_s_frm, (const void *)uv_frm, NULL,
+                                    P_UNSIGNED_CHAR, P_8_BIT_MEM,
+                                    width, frm_height, stride, 0);
+    } /* end of if (status == P_OK) */
+
+    return status;
+} /* end of p_file_write_frame */
+
+/* p_file_read_frame_16 */
+pT_status
+p_file_read_frame_16 (pT_file *file,
+                      int frame,
+                      unsigned short *y_or_s_frm,
+                      unsigned short *uv_frm,
+                      int read_mode,
+                      int width, int frm_height, int stride)
+{
+    pT_status      status = P_OK;
+    pT_header      *header = &file->header;
+    const pT_color color_format = p_get_color_format (header);
+
+    /* check if the handle is open */
+    status = p_check_handle (file);
+
+    /* check if file is in multiplexed or stream format */
+    if (status == P_OK) {
+        status = p_check_multi_or_stream (color_format);
+    } /* end of if (status == P_OK) */
+
+    if (status == P_OK) {
+        status = p_read_frame_all (file->name, file, header, color_format,
+                                   frame, P_NORMAL_COMP,
+                                   (void *)y_or_s_frm, (void *)uv_frm, NULL,
+                                   P_UNSIGNED_SHORT, read_mode,
+                                   width, frm_height, stride, 0);
+    } /* end of if (status == P_OK) */
+
+    return status;
+} /* end of p_file_read_frame_16 */
+
+/* p_file_write_frame_16 */
+pT_status
+p_file_write_frame_16 (pT_file *file,
+                       int frame,
+                       const unsigned short *y_or_s_frm,
+                       const unsigned short *uv_frm,
+                       int write_mode,
+                       int width, int frm_height, int stride)
+{
+    pT_status      status = P_OK;
+    pT_header      *header = &file->header;
+    const pT_color color_format = p_get_color_format (header);
+
+    /* check if the handle is open */
+    status = p_check_handle (file);
+
+    /* check if file is in multiplexed format */
+    if (status == P_OK) {
+        status = p_check_multi_or_stream (color_format);
+    } /* end of if (status == P_OK) */
+
+    if (status == P_OK) {
+        status = p_write_frame_all (file->name, file, header, color_format,
+                                    frame, P_NORMAL_COMP,
+                                    (const void *)y_or_s_frm, (const void *)uv_frm, NULL,
+                                    P_UNSIGNED_SHORT, write_mode,
+                                    width, frm_height, stride, 0);
+    } /* end of if (status == P_OK) */
+
+    return status;
+} /* end of p_file_write_frame_16 */
+
+/* p_file_read_frame_planar */
+pT_status
+p_file_read_frame_planar (pT_file *file,
+                          int frame,
+                          unsigned char *y_or_r_frm,
+                          unsigned char *u_or_g_frm,
+                          unsigned char *v_or_b_frm,
+                          int read_mode,
+                          int width, int frm_height, int stride, int uv_stride)
+{
+    pT_status      status = P_OK;
+    pT_header      *header = &file->header;
+    const pT_color color_format = p_get_color_format (header);
+
+    /* check if the handle is open */
+    status = p_check_handle (file);
+
+    /* check if file is in planar format */
+    if (status == P_OK) {
+        status = p_check_planar (color_format);
+    } /* end of if (status == P_OK) */
+
+    if (status == P_OK) {
+        status = p_read_frame_all (file->name, file, header, color_format,
+                                   frame, P_NORMAL_COMP,
+                                   (void *)y_or_r_frm,
+                                   (void *)u_or_g_frm,
+                                   (void *)v_or_b_frm,
+                                   P_UNSIGNED_CHAR, read_mode,
+                                   width, frm_height, stride, uv_stride);
+    } /* end of if (status == P_OK) */
+
+    return status;
+} /* end of p_file_read_frame_planar */
+
+/* p_file_write_frame_planar */
+pT_status
+p_file_write_frame_planar (pT_file *file,
+                           int frame,
+                           const unsigned char *y_or_r_frm,
+                           const unsigned char *u_or_g_frm,
+                           const unsigned char *v_or_b_frm,
+                           int width, int frm_height, int stride, int uv_stride)
+{
+    pT_status      status = P_OK;
+    pT_header      *header = &file->header;
+    const pT_color color_format = p_get_color_format (header);
+
+    /* check if the handle is open */
+    status = p_check_handle (file);
+
+    /* check if file is in planar format */
+    if (status == P_OK) {
+        status = p_check_planar (color_format);
+    } /* end of if (status == P_OK) */
+
+    if (status == P_OK) {
+        status = p_write_frame_all (file->name, file, header, color_format,
+                                    frame, P_NORMAL_COMP,
+                                    (const void *)y_or_r_frm,
+                                    (const void *)u_or_g_frm,
+                                    (const void *)v_or_b_frm,
+                                    P_UNSIGNED_CHAR, P_8_BIT_MEM,
+                                    width, frm_height, stride, uv_stride);
+    } /* end of if (status == P_OK) */
+
+    return status;
+} /* end of p_file_write_frame_planar */
+
+/* p_file_read_frame_planar_16 */
+pT_status
+p_file_read_frame_planar_16 (pT_file *file,
+                             int frame,
+                             unsigned short *y_or_r_frm,
+                             unsigned short *u_or_g_frm,
+                             unsigned short *v_or_b_frm,
+                             int read_mode,
+                             int width, int frm_height, int stride, int uv_stride)
+{
+    pT_status      status = P_OK;
+    pT_header      *header = &file->header;
+    const pT_color color_format = p_get_color_format (header);
+
+    /* check if the handle is open */
+    status = p_check_handle (file);
+
+    /* check if file is in planar format */
+    if (status == P_OK) {
+        status = p_check_planar (color_format);
+    } /* end of if (status == P_OK) */
+
+    if (status == P_OK) {
+        status = p_read_frame_all (file->name, file, header, color_format,
+                                   frame, P_NORMAL_COMP,
+                                   (void *)y_or_r_frm,
+                                   (void *)u_or_g_frm,
+                                   (void *)v_or_b_frm,
+                                   P_UNSIGNED_SHORT, read_mode,
+                                   width, frm_height, stride, uv_stride);
+    } /* end of if (status == P_OK) */
+
+    return status;
+} /* end of p_file_read_frame_planar_16 */
+
+/* p_file_write_frame_planar_16 */
+pT_status
+p_file_write_frame_planar_16 (pT_file *file,
+                              int frame,
+                              const unsigned short *y_or_r_frm,
+                              const unsigned short *u_or_g_frm,
+                              const unsigned short *v_or_b_frm,
+                              int write_mode,
+                              int width, int frm_height, int stride, int uv_stride)
+{
+    pT_status      status = P_OK;
+    pT_header      *header = &file->header;
+    const pT_color color_format = p_get_color_format (header);
+
+    /* check if the handle is open */
+    status = p_check_handle (file);
+
+    /* check if file is in planar format */
+    if (status == P_OK) {
+        status = p_check_planar (color_format);
+    } /* end of if (status == P_OK) */
+
+    if (status == P_OK) {
+        status = p_write_frame_all (file->name, file, header, color_format,
+                                    frame, P_NORMAL_COMP,
+                                    (const void *)y_or_r_frm,
+                                    (const void *)u_or_g_frm,
+                                    (const void *)v_or_b_frm,
+                                    P_UNSIGNED_SHORT, write_mode,
+                                    width, frm_height, stride, uv_stride);
+    } /* end of if (status == P_OK) */
+
+    return status;
+} /* end of p_file_write_frame_planar_16 */
+
+/* p_file_read_frame_comp */
+pT_status
+p_file_read_frame_comp (pT_file *file,
+                        int frame, int comp,
+                        unsigned char *c_frm,
+                        int read_mode,
+                        int width, int frm_height, int stride)
+{
+    pT_status      status = P_OK;
+    pT_header      *header = &file->header;
+
+    /* check if the handle is open */
+    status = p_check_handle (file);
+
+    /* check component */
+    if (status == P_OK) {
+        status = p_check_comp (header, comp, 1);
+    } /* end of if (status == P_OK) */
+
+    if (status == P_OK) {
+        status = p_read_frame_all (file->name, file, header, P_UNKNOWN_COLOR,
+                                   frame, comp,
+                                   (void *)c_frm, NULL, NULL,
+                                   P_UNSIGNED_CHAR, read_mode,
+                                   width, frm_height, stride, 0);
+    } /* end of if (status == P_OK) */
+
+    return status;
+} /* end of p_file_read_frame_comp */
+
+/* p_file_write_frame_comp */
+pT_status
+p_file_write_frame_comp (pT_file *file,
+                         int frame, int comp,
+                         const unsigned char *c_frm,
+                         int width, int frm_height, int stride)
+{
+    pT_status      status = P_OK;
+    pT_header      *header = &file->header;
+
+    /* check if the handle is open */
+    status = p_check_handle (file);
+
+    /* check component */
+    if (status == P_OK) {
+        status = p_check_comp (header, comp, 0);
+    } /* end of if (status == P_OK) */
+
+    if (status == P_OK) {
+        status = p_write_frame_all (file->name, file, header, P_UNKNOWN_COLOR,
+                                    frame, comp,
+                                    (const void *)c_frm, NULL, NULL,
+                                    P_UNSIGNED_CHAR, P_8_BIT_MEM,
+                                    width, frm_height, stride, 0);
+    } /* end of if (status == P_OK) */
+
+    return status;
+} /* end of p_file_write_frame_comp */
+
+/* p_file_read_frame_comp_16 */
+pT_status
+p_file_read_frame_comp_16 (pT_file *file,
+                           int frame, int comp,
+                           unsigned short *c_frm,
+                           int read_mode,
+                           int width, int frm_height, int stride)
+{
+    pT_status      status = P_OK;
+    pT_header      *header = &file->header;
+
+    /* check if the handle is open */
+    status = p_check_handle (file);
+
+    /* check component */
+    if (status == P_OK) {
+        status = p_check_comp (header, comp, 1);
+    } /* end of if (status == P_OK) */
+
+    if (status == P_OK) {
+        status = p_read_frame_all (file->name, file, header, P_UNKNOWN_COLOR,
+                                   frame, comp,
+                                   (void *)c_frm, NULL, NULL,
+                                   P_UNSIGNED_SHORT, read_mode,
+                                   width, frm_height, stride, 0);
+    } /* end of if (status == P_OK) */
+
+    return status;
+} /* end of p_file_read_frame_comp_16 */
+
+/* p_file_write_frame_comp_16 */
+pT_status
+p_file_write_frame_comp_16 (pT_file *file,
+                            int frame, int comp,
+                            const unsigned short *c_frm,
+                            int write_mode,
+                            int width, int frm_height, int stride)
+{
+    pT_status      status = P_OK;
+    pT_header      *header = &file->header;
+
+    /* check if the handle is open */
+    status = p_check_handle (file);
+
+    /* check component */
+    if (status == P_OK) {
+        status = p_check_comp (header, comp, 0);
+    } /* end of if (status == P_OK) */
+
+    if (status == P_OK) {
+        status = p_write_frame_all (file->name, file, header, P_UNKNOWN_COLOR,
+                                    frame, comp,
+                                    (const void *)c_frm, NULL, NULL,
+                                    P_UNSIGNED_SHORT, write_mode,
+                                    width, frm_height, stride, 0);
+    } /* end of if (status == P_OK) */
+
+    return status;
+} /* end of p_file_write_frame_comp_16 */
+
+/******************************************************************************/
+
+/*
+ * Reading multiple frames.
+ *
+ * The frames are divided into tasks for the worker threads: each task
+ * reads a run of consecutive frames into memory with one transfer
+ * (p_read_images), and then extracts the frames from there. If that
+ * fails, the task reads its frames one by one.
+ * Standard input, and files that do not support positional reads, are
+ * read by the tasks in order on the calling thread, continuing from the
+ * file position in the header.
+ *
+ */
+
+/* a p_read_frames() job */
+typedef struct {
+    const char *filename;
+    pT_header  *header;
+    pT_color   color_format;
+    int        first_frame;
+    const int  *frames;
+    const void *bufs_0;         /* arrays of frame buffers; unsigned char **  */
+    const void *bufs_1;         /*   or unsigned short ** (see mem_type)       */
+    const void *bufs_2;
+    int        mem_type;
+    int        read_mode;
+    int        width;
+    int        frm_height;
+    int        stride;
+    int        uv_stride;
+    int        serial;          /* bool: tasks in order, file position in header */
+    int        *task_start;     /* index of the first frame of each task      */
+    pT_status  *task_status;
+} p_frames_job_t;
+
+/* frame number of the i-th frame of a job */
+static int
+p_job_frame (const p_frames_job_t *job, int i)
+{
+    return (job->frames != NULL) ? job->frames[i] : job->first_frame + i;
+} /* end of p_job_frame */
+
+/* buffer of the i-th frame from an array of frame buffers */
+static void *
+p_job_buffer (const p_frames_job_t *job, const void *bufs, int i)
+{
+    if (bufs == NULL) {
+        return NULL;
+    }
+    if (job->mem_type == P_UNSIGNED_SHORT) {
+        return (void *)((unsigned short * const *)bufs)[i];
+    }
+    return (void *)((unsigned char * const *)bufs)[i];
+} /* end of p_job_buffer */
+
+/* read the frames of one task */
+static void
+p_read_frames_task (void *arg, int task)
+{
+    p_frames_job_t *job = (p_frames_job_t *)arg;
+    const int      first = job->task_start[task];
+    const int      num = job->task_start[task + 1] - first;
+    const int      images = p_is_interlaced (job->header) ? 2 : 1;
+    pT_file        data;
+    pT_file        *file;
+    pT_status      status = P_OK;
+    pT_status      frame_status;
+    int            i;
+
+    /* own copy of the header: it may be updated by the file access */
+    data.idx     = -1;
+    data.name[0] = '\0';
+    data.context = NULL;
+    data.header  = *job->header;
+    if (p_read_images (job->filename, &data, &data.header,
+                       images * (p_job_frame (job, first) - 1) + 1,
+                       images * num, stderr, NOPRINT) == P_OK) {
+        file = &data;
+    } else {
+        file = NULL;
+    } /* end of if (p_read_images (... */
+
+    for (i = first; i < first + num; i++) {
+        frame_status = p_read_frame_all (job->filename, file, &data.header,
+                                         job->color_format,
+                                         p_job_frame (job, i), P_NORMAL_COMP,
+                                         p_job_buffer (job, job->bufs_0, i),
+                                         p_job_buffer (job, job->bufs_1, i),
+                                         p_job_buffer (job, job->bufs_2, i),
+                                         job->mem_type, job->read_mode,
+                                         job->width, job->frm_height,
+                                         job->stride, job->uv_stride);
+        if (status == P_OK) {
+            status = frame_status;
+        }
+    } /* end of for (i = first; ... */
+
+    if (file != NULL) {
+        free ((void *)data.data);
+    }
+    if (job->serial) {
+        /* the next task continues from the advanced file position */
+        job->header->offset_hi = data.header.offset_hi;
+        job->header->offset_lo = data.header.offset_lo;
+    }
+    job->task_status[task] = status;
+} /* end of p_read_frames_task */
+
+/* read multiple frames */
+static pT_status
+p_read_frames_all (p_frames_job_t *job, int num_frames)
+{
+    pT_status status = P_OK;
+    long      frame_size;
+    int       per_task;
+    int       num_tasks;
+    int       i;
+
+    /* check if the file header is modified */
+    status = p_check_modified (job->header);
+
+    /* check if header is valid */
+    if (status == P_OK) {
+        status = p_check_header (job->header);
+    } /* end of if (status == P_OK) */
+
+    if ((status != P_OK) || (num_frames <= 0)) {
+        return status;
+    }
+
+    /* frames per task: limited by P_FRAMES_TASK_SIZE, and such
+       that all threads get work */
+    frame_size = p_get_size_image (job->header) * (p_is_interlaced (job->header) ? 2 : 1);
+    per_task   = (frame_size > 0) ? (int)(P_FRAMES_TASK_SIZE / frame_size) : num_frames;
+    per_task   = MIN(per_task, (num_frames + p_work_threads () - 1) / p_work_threads ());
+    per_task   = MAX(per_task, 1);
+
+    job->task_start  = (int *)malloc ((num_frames + 1) * sizeof(int));
+    job->task_status = (pT_status *)malloc (num_frames * sizeof(pT_status));
+    if ((job->task_start == NULL) || (job->task_status == NULL)) {
+        status = P_MALLOC_FAILED;
+    } else {
+        /* a task reads a run of consecutive frames */
+        num_tasks = 0;
+        for (i = 0; i < num_frames; i++) {
+            if ((i == 0) ||
+                (p_job_frame (job, i) != p_job_frame (job, i - 1) + 1) ||
+                (i - job->task_start[num_tasks - 1] == per_task)) {
+                job->task_start[num_tasks++] = i;
+            }
+        } /* end of for (i = 0; ... */
+        job->task_start[num_tasks] = num_frames;
+
+        job->serial = !p_read_shared (job->filename);
+        if (job->serial) {
+            /* standard input, or no positional reads: in order */
+            for (i = 0; i < num_tasks; i++) {
+                p_read_frames_task ((void *)job, i);
+            }
+        } else {
+            p_work_run (p_read_frames_task, (void *)job, num_tasks);
+        } /* end of if (job->serial) */
+
+        for (i = 0; (i < num_tasks) && (status == P_OK); i++) {
+            status = job->task_status[i];
+        }
+    } /* end of if ((job->task_start == NULL) || ... */
+
+    free (job->task_start);
+    free (job->task_status);
+
+    return status;
+} /* end of p_read_frames_all */
+
+/* p_read_frames */
+pT_status
+p_read_frames (const char *filename, pT_header *header,
+               int first_frame, int num_frames, const int *frames,
+               unsigned char **y_or_r_frms,
+               unsigned char **u_or_g_frms,
+               unsigned char **v_or_b_frms,
+               int read_mode,
+               int width, int frm_height, int stride, int uv_stride)
+{
+    p_frames_job_t job;
+
+    job.filename     = filename;
+    job.header       = header;
+    job.color_format = p_get_color_format (header);
+    job.first_frame  = first_frame;
+    job.frames       = frames;
+    job.bufs_0       = (const void *)y_or_r_frms;
+    job.bufs_1       = (const void *)u_or_g_frms;
+    job.bufs_2       = (const void *)v_or_b_frms;
+    job.mem_type     = P_UNSIGNED_CHAR;
+    job.read_mode    = read_mode;
+    job.width        = width;
+    job.frm_height   = frm_height;
+    job.stride       = stride;
+    job.uv_stride    = uv_stride;
+
+    return p_read_frames_all (&job, num_frames);
+} /* end of p_read_frames */
+
+/* p_read_frames_16 */
+pT_status
+p_read_frames_16 (const char *filename, pT_header *header,
+                  int first_frame, int num_frames, const int *frames,
+                  unsigned short **y_or_r_frms,
+                  unsigned short **u_or_g_frms,
+                  unsigned short **v_or_b_frms,
+                  int read_mode,
+                  int width, int frm_height, int stride, int uv_stride)
+{
+    p_frames_job_t job;
+
+    job.filename     = filename;
+    job.header       = header;
+    job.color_format = p_get_color_format (header);
+    job.first_frame  = first_frame;
+    job.frames       = frames;
+    job.bufs_0       = (const void *)y_or_r_frms;
+    job.bufs_1       = (const void *)u_or_g_frms;
+    job.bufs_2       = (const void *)v_or_b_frms;
+    job.mem_type     = P_UNSIGNED_SHORT;
+    job.read_mode    = read_mode;
+    job.width        = width;
+    job.frm_height   = frm_height;
+    job.stride       = stride;
+    job.uv_stride    = uv_stride;
+
+    return p_read_frames_all (&job, num_frames);
+} /* end of p_read_frames_16 */
+
+/******************************************************************************/
+
+/*
+ * Streaming reader.
+ *
+ * A stream reads a range of frames through three stages that run at
+ * the same time: the reader thread reads the file data of a frame
+ * (p_read_images), the conversion thread converts it into the frame
+ * buffers of the stream, and the application consumes the frames by
+ * p_stream_next() and p_stream_release().
+ *
+ * The frames are held in a ring of queue_size slots. Frame k uses
+ * slot k % queue_size; the reader waits until the frame that used the
+ * slot before has been released. The stages are administrated by
+ * counters, guarded by the lock of the stream.
+ *
+ */
+
+/* default number of frames in a stream */
+#define P_STREAM_QUEUE_SIZE     4
+
+/* a frame of a stream */
+typedef struct {
+    pT_file     data;           /* file data of the frame, and header copy    */
+    pT_status   read_status;    /* status of reading the file data            */
+    pT_status   status;         /* status of the frame                        */
+    void        *bufs[3];       /* frame buffers of the components            */
+} p_stream_slot_t;
+
+struct pT_stream_s {
+    char            *filename;
+    pT_context      *context;       /* context of the thread that opened it   */
+    pT_header       header;         /* header, used by the reader thread      */
+    pT_color        color_format;
+    int             first_frame;
+    int             num_frames;
+    int             mem_type;
+    int             read_mode;
+    int             width;
+    int             frm_height;
+    int             stride;
+    int             uv_stride;
+    int             queue_size;
+    p_stream_slot_t *slots;
+    int             num_read;       /* number of frames read                  */
+    int             num_converted;  /* number of frames converted             */
+    int             num_delivered;  /* number of frames delivered             */
+    int             num_released;   /* number of frames released              */
+    int             stop;           /* set by p_stream_close()                */
+    p_mutex_t       lock;
+    p_cond_t        cond;           /* signalled at every change of a counter */
+    p_thread_t      reader;
+    p_thread_t      converter;
+    int             num_threads;    /* number of threads started              */
+};
+
+/* wait until frame k may be read; returns 0 when the stream is stopped */
+static int
+p_stream_wait (pT_stream *stream, const int *counter, int k)
+{
+    int go;
+
+    p_mutex_lock (&stream->lock);
+    while (!stream->stop && (*counter <= k)) {
+        p_cond_wait (&stream->cond, &stream->lock);
+    }
+    go = !stream->stop;
+    p_mutex_unlock (&stream->lock);
+
+    return go;
+} /* end of p_stream_wait */
+
+/* increment a counter of the stream */
+static void
+p_stream_count (pT_stream *stream, int *counter)
+{
+    p_mutex_lock (&stream->lock);
+    (*counter)++;
+    p_cond_broadcast (&stream->cond);
+    p_mutex_unlock (&stream->lock);
+} /* end of p_stream_count */
+
+/* reader thread: reads the file data of the frames in order */
+static P_THREAD_FUNC(p_stream_reader, arg)
+{
+    pT_stream       *stream = (pT_stream *)arg;
+    const int       images = p_is_interlaced (&stream->header) ? 2 : 1;
+    p_stream_slot_t *slot;
+    int             k;
+
+    (void)p_context_select (stream->context);
+    for (k = 0; k < stream->num_frames; k++) {
+        /* wait until the previous frame of the slot is released */
+        if (!p_stream_wait (stream, &stream->num_released, k - stream->queue_size)) {
+            break;
+        }
+        slot = &stream->slots[k % stream->queue_size];
+        slot->data.header = stream->header;
+        slot->read_status = p_read_images (stream->filename, &slot->data, &stream->header,
+                                           images * (stream->first_frame + k - 1) + 1,
+                                           images, stderr, NOPRINT);
+        p_stream_count (stream, &stream->num_read);
+    } /* end of for (k = 0; ... */
+
+    P_THREAD_RETURN;
+} /* end of p_stream_reader */
+
+/* conversion thread: converts the file data into the frame buffers */
+static P_THREAD_FUNC(p_stream_converter, arg)
+{
+    pT_stream       *stream = (pT_stream *)arg;
+    p_stream_slot_t *slot;
+    pT_file         *file;
+    int             k;
+
+    (void)p_context_select (stream->context);
+    for (k = 0; k < stream->num_frames; k++) {
+        if (!p_stream_wait (stream, &stream->num_read, k)) {
+            break;
+        }
+        slot = &stream->slots[k % stream->queue_size];
+        if (slot->read_status == P_OK) {
+            file = &slot->data;
+        } else {
+            file = NULL;
+        } /* end of if (slot->read_status == P_OK) */
+
+        if ((file == NULL) && !strcmp (stream->filename, "-")) {
+            /* standard input: the data can not be read again */
+            slot->status = slot->read_status;
+        } else {
+            slot->status = p_read_frame_all (stream->filename, file, &slot->data.header,
+                                             stream->color_format,
+                                             stream->first_frame + k, P_NORMAL_COMP,
+                                             slot->bufs[0], slot->bufs[1], slot->bufs[2],
+                                             stream->mem_type, stream->read_mode,
+                                             stream->width, stream->frm_height,
+                                             stream->stride, stream->uv_stride);
+        } /* end of if ((file == NULL) && ... */
+
+        free ((void *)slot->data.data);
+        slot->data.data = NULL;
+        p_stream_count (stream, &stream->num_converted);
+    } /* end of for (k = 0; ... */
+
+    P_THREAD_RETURN;
+} /* end of p_stream_converter */
+
+/* release all resources of a stream */
+static void
+p_stream_free (pT_stream *stream)
+{
+    int i;
+    int c;
+
+    p_mutex_lock (&stream->lock);
+    stream->stop = 1;
+    p_cond_broadcast (&stream->cond);
+    p_mutex_unlock (&stream->lock);
+
+    if (stream->num_threads > 0) {
+        p_thread_join (stream->reader);
+    }
+    if (stream->num_threads > 1) {
+        p_thread_join (stream->converter);
+    }
+
+    if (stream->slots != NULL) {
+        for (i = 0; i < stream->queue_size; i++) {
+            free ((void *)stream->slots[i].data.data);
+            for (c = 0; c < 3; c++) {
+                free (stream->slots[i].bufs[c]);
+            }
+        }
+    }
+    free (stream->slots);
+    free (stream->filename);
+    p_cond_destroy (&stream->cond);
+    p_mutex_destroy (&stream->lock);
+    free (stream);
+} /* end of p_stream_free */
+
+/* open a stream */
+static pT_status
+p_stream_open_all (const char *filename,
+                   const pT_header *header,
+                   int first_frame,
+                   int num_frames,
+                   int mem_type,
+                   int read_mode,
+                   int width,
+                   int frm_height,
+                   int stride,
+                   int uv_stride,
+                   int queue_size,
+                   pT_stream **stream)
+{
+    pT_status      status = P_OK;
+    pT_stream      *new_stream;
+    size_t         sizes[3];
+    int            i;
+    int            c;
+
+    *stream = NULL;
+
+    /* check if the file header is modified */
+    status = p_check_modified (header);
+
+    /* check if header is valid */
+    if (status == P_OK) {
+        status = p_check_header (header);
+    } /* end of if (status == P_OK) */
+
+    if (status != P_OK) {
+        return status;
+    }
+
+    new_stream = (pT_stream *)calloc (1, sizeof(pT_stream));
+    if (new_stream == NULL) {
+        return P_MALLOC_FAILED;
+    }
+    p_mutex_init (&new_stream->lock);
+    p_cond_init (&new_stream->cond);
+    new_stream->context      = p_context_current ();
+    new_stream->header       = *header;
+    new_stream->color_format = p_get_color_format (header);
+    new_stream->first_frame  = first_frame;
+    new_stream->num_frames   = MAX(num_frames, 0);
+    new_stream->mem_type     = mem_type;
+    new_stream->read_mode    = read_mode;
+    new_stream->width        = width;
+    new_stream->frm_height   = frm_height;
+    new_stream->stride       = stride;
+    new_stream->uv_stride    = uv_stride;
+    new_stream->queue_size   = (queue_size > 0) ? queue_size : P_STREAM_QUEUE_SIZE;
+
+    new_stream->filename = (char *)malloc (strlen (filename) + 1);
+    new_stream->slots    = (p_stream_slot_t *)calloc (new_stream->queue_size,
+                                                      sizeof(p_stream_slot_t));
+    if ((new_stream->filename == NULL) || (new_stream->slots == NULL)) {
+        status = P_MALLOC_FAILED;
+    } else {
+        strcpy (new_stream->filename, filename);
+    } /* end of if ((new_stream->filename == NULL) || ... */
+
+    /* frame buffers of all components of the file */
+    p_get_frame_sizes (header, mem_type, frm_height, stride, uv_stride, sizes);
+    for (i = 0; (i < new_stream->queue_size) && (status == P_OK); i++) {
+        new_stream->slots[i].data.idx = -1;
+        new_stream->slots[i].data.name[0] = '\0';
+        for (c = 0; (c < 3) && (sizes[c] > 0) && (status == P_OK); c++) {
+            new_stream->slots[i].bufs[c] = malloc (sizes[c]);
+            if (new_stream->slots[i].bufs[c] == NULL) {
+                status = P_MALLOC_FAILED;
+            }
+        } /* end of for (c = 0; ... */
+    } /* end of for (i = 0; ... */
+
+    /* start the reader and conversion threads */
+    if ((status == P_OK) &&
+        p_thread_create (&new_stream->reader, p_stream_reader, new_stream)) {
+        new_stream->num_threads++;
+        if (p_thread_create (&new_stream->converter, p_stream_converter, new_stream)) {
+            new_stream->num_threads++;
+        }
+    }
+    if ((status == P_OK) && (new_stream->num_threads < 2)) {
+        status = P_THREAD_CREATE_FAILED;
+    }
+
+    if (status == P_OK) {
+        *stream = new_stream;
+    } else {
+        p_stream_free (new_stream);
+    }
+
+    return status;
+} /* end of p_stream_open_all */
+
+/* get the next frame of a stream */
+static pT_status
+p_stream_next_all (pT_stream *stream,
+                   int mem_type,
+                   int *frame,
+                   void **buf_0,
+                   void **buf_1,
+                   void **buf_2)
+{
+    p_stream_slot_t *slot;
+    const int       k = stream->num_delivered;
+
+    *frame = 0;
+    if (mem_type != stream->mem_type) {
+        return P_UNKNOWN_MEM_TYPE;
+    }
+    if (k == stream->num_frames) {
+        /* end of the stream */
+        return P_OK;
+    }
+    if (k - stream->num_released == stream->queue_size) {
+        /* all frames delivered; the next one would never be read */
+        return P_TOO_MANY_IMAGES;
+    }
+
+    /* wait until the frame is converted */
+    p_stream_wait (stream, &stream->num_converted, k);
+    slot = &stream->slots[k % stream->queue_size];
+
+    *frame = stream->first_frame + k;
+    if (buf_0 != NULL) {
+        *buf_0 = slot->bufs[0];
+    }
+    if (buf_1 != NULL) {
+        *buf_1 = slot->bufs[1];
+    }
+    if (buf_2 != NULL) {
+        *buf_2 = slot->bufs[2];
+    }
+    p_stream_count (stream, &stream->num_delivered);
+
+    return slot->status;
+} /* end of p_stream_next_all */
+
+/* p_stream_open */
+pT_status
+p_stream_open (const char *filename, const pT_header *header,
+               int first_frame, int num_frames,
+               int read_mode,
+               int width, int frm_height, int stride, int uv_stride,
+               int queue_size, pT_stream **stream)
+{
+    return p_stream_open_all (filename, header, first_frame, num_frames,
+                              P_UNSIGNED_CHAR, read_mode,
+                              width, frm_height, stride, uv_stride,
+                              queue_size, stream);
+} /* end of p_stream_open */
+
+/* p_stream_open_16 */
+pT_status
+p_stream_open_16 (const char *filename, const pT_header *header,
+                  int first_frame, int num_frames,
+                  int read_mode,
+                  int width, int frm_height, int stride, int uv_stride,
+                  int queue_size, pT_stream **stream)
+{
+    return p_stream_open_all (filename, header, first_frame, num_frames,
+                              P_UNSIGNED_SHORT, read_mode,
+                              width, frm_height, stride, uv_stride,
+                              queue_size, stream);
+} /* end of p_stream_open_16 */
+
+/* p_stream_next */
+pT_status
+p_stream_next (pT_stream *stream, int *frame,
+               unsigned char **y_or_r_frm,
+               unsigned char **u_or_g_frm,
+               unsigned char **v_or_b_frm)
+{
+    return p_stream_next_all (stream, P_UNSIGNED_CHAR, frame,
+                              (void **)y_or_r_frm,
+                              (void **)u_or_g_frm,
+                              (void **)v_or_b_frm);
+} /* end of p_stream_next */
+
+/* p_stream_next_16 */
+pT_status
+p_stream_next_16 (pT_stream *stream, int *frame,
+                  unsigned short **y_or_r_frm,
+                  unsigned short **u_or_g_frm,
+                  unsigned short **v_or_b_frm)
+{
+    return p_stream_next_all (stream, P_UNSIGNED_SHORT, frame,
+                              (void **)y_or_r_frm,
+                              (void **)u_or_g_frm,
+                              (void **)v_or_b_frm);
+} /* end of p_stream_next_16 */
+
+/* p_stream_release */
+pT_status
+p_stream_release (pT_stream *stream)
+{
+    if (stream->num_released < stream->num_delivered) {
+        p_stream_count (stream, &stream->num_released);
+    }
+    return P_OK;
+} /* end of p_stream_release */
+
+/* p_stream_close */
+pT_status
+p_stream_close (pT_stream *stream)
+{
+    if (stream != NULL) {
+        p_stream_free (stream);
+    }
+    return P_OK;
+} /* end of p_stream_close */
+
+/******************************************************************************/
+
+/*
+ * Recorder.
+ *
+ * The frames of the capture thread are copied into a ring of
+ * preallocated slots, from which the writer thread writes them to the
+ * file. The ring has a single producer (p_recorder_write) and a single
+ * consumer (the writer thread): the producer only advances head, the
+ * consumer only advances tail, so no lock is needed to pass a frame.
+ * A full ring drops the frame instead of waiting for the disk. A frame
+ * that fails to be written is dropped as well; it is counted by the
+ * writer thread in num_failed, as each counter has a single writer.
+ *
+ * The writer thread sleeps on the condition variable when the ring is
+ * empty. It announces this in writer_waiting before it checks head for
+ * the last time; the producer checks writer_waiting after it advanced
+ * head, and only then takes the lock to wake up the writer. So the
+ * producer only waits for the lock while the writer is idle.
+ *
+ */
+
+struct pT_recorder_s {
+    char        *filename;
+    pT_context  *context;       /* context of the thread that opened it       */
+    pT_header   header;         /* header, used by the writer thread          */
+    pT_color    color_format;
+    int         first_frame;
+    int         mem_type;
+    int         write_mode;
+    int         width;
+    int         frm_height;
+    int         stride;
+    int         uv_stride;
+    int         num_slots;
+    size_t      sizes[3];       /* sizes of the frame buffers                 */
+    unsigned char *data;        /* frame buffers of all slots                 */
+    p_atomic_t  head;           /* number of frames put in the ring           */
+    p_atomic_t  tail;           /* number of frames taken from the ring       */
+    p_atomic_t  num_written;    /* number of frames written                   */
+    p_atomic_t  num_dropped;    /* number of frames dropped: ring was full    */
+    p_atomic_t  num_failed;     /* number of frames dropped: write failed     */
+    p_atomic_t  status;         /* status of the first write that failed      */
+    p_atomic_t  writer_waiting;
+    p_atomic_t  stop;           /* set by p_recorder_close()                  */
+    p_mutex_t   lock;
+    p_cond_t    cond;           /* signalled when a frame is put, or stop     */
+    p_thread_t  writer;
+    int         writer_started;
+};
+
+/* frame buffer of component c of a slot */
+static unsigned char *
+p_recorder_buffer (const pT_recorder *recorder, long slot, int c)
+{
+    unsigned char *buf = recorder->data +
+                         slot * (recorder->sizes[0] + recorder->sizes[1] + recorder->sizes[2]);
+    int           i;
+
+    for (i = 0; i < c; i++) {
+        buf += recorder->sizes[i];
+    }
+    return buf;
+} /* end of p_recorder_buffer */
+
+/* wake up the writer thread, if it is waiting */
+static void
+p_recorder_wake (pT_recorder *recorder)
+{
+    if (p_atomic_get (&recorder->writer_waiting)) {
+        p_mutex_lock (&recorder->lock);
+        p_cond_broadcast (&recorder->cond);
+        p_mutex_unlock (&recorder->lock);
+    }
+} /* end of p_recorder_wake */
+
+/* writer thread: writes the frames of the ring to the file */
+static P_THREAD_FUNC(p_recorder_writer, arg)
+{
+    pT_recorder *recorder = (pT_recorder *)arg;
+    long        tail = 0;
+    int         frame = recorder->first_frame;
+    long        slot;
+    pT_status   status;
+
+    (void)p_context_select (recorder->context);
+    for (;;) {
+        if (tail == p_atomic_get (&recorder->head)) {
+            /* ring empty: stop, or wait for the next frame */
+            if (p_atomic_get (&recorder->stop)) {
+                break;
+            }
+            p_mutex_lock (&recorder->lock);
+            p_atomic_set (&recorder->writer_waiting, 1);
+            if ((tail == p_atomic_get (&recorder->head)) &&
+                !p_atomic_get (&recorder->stop)) {
+                p_cond_wait (&recorder->cond, &recorder->lock);
+            }
+            p_atomic_set (&recorder->writer_waiting, 0);
+            p_mutex_unlock (&recorder->lock);
+            continue;
+        } /* end of if (tail == ... */
+
+        slot   = tail % recorder->num_slots;
+        status = p_write_frame_all (recorder->filename, NULL, &recorder->header,
+                                    recorder->color_format,
+                                    frame, P_NORMAL_COMP,
+                                    (const void *)p_recorder_buffer (recorder, slot, 0),
+                                    (const void *)p_recorder_buffer (recorder, slot, 1),
+                                    (const void *)p_recorder_buffer (recorder, slot, 2),
+                                    recorder->mem_type, recorder->write_mode,
+                                    recorder->width, recorder->frm_height,
+                                    recorder->stride, recorder->uv_stride);
+        if (status == P_OK) {
+            frame++;
+            p_atomic_set (&recorder->num_written, p_atomic_get (&recorder->num_written) + 1);
+        } else {
+            /* the frame is lost: dropped, and the next one takes its place */
+            p_atomic_set (&recorder->num_failed, p_atomic_get (&recorder->num_failed) + 1);
+            if (p_atomic_get (&recorder->status) == P_OK) {
+                p_atomic_set (&recorder->status, status);
+            }
+        }
+        p_atomic_set (&recorder->tail, ++tail);
+    } /* end of for (;;) */
+
+    P_THREAD_RETURN;
+} /* end of p_recorder_writer */
+
+/* stop the writer thread, and release all resources of a recorder;
+   returns the status of the first write that failed */
+static pT_status
+p_recorder_free (pT_recorder *recorder)
+{
+    pT_status status;
+
+    if (recorder->writer_started) {
+        p_atomic_set (&recorder->stop, 1);
+        p_mutex_lock (&recorder->lock);
+        p_cond_broadcast (&recorder->cond);
+        p_mutex_unlock (&recorder->lock);
+        p_thread_join (recorder->writer);
+    }
+    status = (pT_status)p_atomic_get (&recorder->status);
+
+    free (recorder->data);
+    free (recorder->filename);
+    p_cond_destroy (&recorder->cond);
+    p_mutex_destroy (&recorder->lock);
+    free (recorder);
+
+    return status;
+} /* end of p_recorder_free */
+
+/* open a recorder */
+static pT_status
+p_recorder_open_all (const char *filename,
+                     const pT_header *header,
+                     int first_frame,
+                     int mem_type,
+                     int write_mode,
+                     int width,
+                     int frm_height,
+                     int stride,
+                     int uv_stride,
+                     int num_slots,
+                     pT_recorder **recorder)
+{
+    pT_status      status = P_OK;
+    pT_recorder    *new_recorder;
+
+    *recorder = NULL;
+
+    /* check if the file header is modified */
+    status = p_check_modified (header);
+
+    /* check if header is valid */
+    if (status == P_OK) {
+        status = p_check_header (header);
+    } /* end of if (status == P_OK) */
+
+    if (status != P_OK) {
+        return status;
+    }
+
+    new_recorder = (pT_recorder *)calloc (1, sizeof(pT_recorder));
+    if (new_recorder == NULL) {
+        return P_MALLOC_FAILED;
+    }
+    p_mutex_init (&new_recorder->lock);
+    p_cond_init (&new_recorder->cond);
+    new_recorder->context      = p_context_current ();
+    new_recorder->header       = *header;
+    new_recorder->color_format = p_get_color_format (header);
+    new_recorder->first_frame  = first_frame;
+    new_recorder->mem_type     = mem_type;
+    new_recorder->write_mode   = write_mode;
+    new_recorder->width        = width;
+    new_recorder->frm_height   = frm_height;
+    new_recorder->stride       = stride;
+    new_recorder->uv_stride    = uv_stride;
+    new_recorder->num_slots    = (num_slots > 0) ? num_slots : P_STREAM_QUEUE_SIZE;
+    p_atomic_set (&new_recorder->status, P_OK);
+    p_get_frame_sizes (header, mem_type, frm_height, stride, uv_stride,
+                       new_recorder->sizes);
+
+    /* all frame buffers are allocated at open */
+    new_recorder->filename = (char *)malloc (strlen (filename) + 1);
+    new_recorder->data     = (unsigned char *)malloc ((size_t)new_recorder->num_slots *
+                                                      (new_recorder->sizes[0] +
+                                                       new_recorder->sizes[1] +
+                                                       new_recorder->sizes[2]));
+    if ((new_recorder->filename == NULL) || (new_recorder->data == NULL)) {
+        status = P_MALLOC_FAILED;
+    } else {
+        strcpy (new_recorder->filename, filename);
+    } /* end of if ((new_recorder->filename == NULL) || ... */
+
+    /* start the writer thread */
+    if (status == P_OK) {
+        if (p_thread_create (&new_recorder->writer, p_recorder_writer, new_recorder)) {
+            new_recorder->writer_started = 1;
+        } else {
+            status = P_THREAD_CREATE_FAILED;
+        }
+    }
+
+    if (status == P_OK) {
+        *recorder = new_recorder;
+    } else {
+        (void)p_recorder_free (new_recorder);
+    }
+
+    return status;
+} /* end of p_recorder_open_all */
+
+/* put a frame in the ring of a recorder */
+static pT_status
+p_recorder_write_all (pT_recorder *recorder,
+                      int mem_type,
+                      const void *buf_0,
+                      const void *buf_1,
+                      const void *buf_2)
+{
+    const long     head = p_atomic_get (&recorder->head);
+    const void     *bufs[3];
+    long           slot;
+    pT_status      status;
+    int            c;
+
+    status = (pT_status)p_atomic_get (&recorder->status);
+    if (status != P_OK) {
+        return status;
+    }
+    if (mem_type != recorder->mem_type) {
+        return P_UNKNOWN_MEM_TYPE;
+    }
+    if (head - p_atomic_get (&recorder->tail) == recorder->num_slots) {
+        /* ring full: drop the frame */
+        p_atomic_set (&recorder->num_dropped, p_atomic_get (&recorder->num_dropped) + 1);
+        return P_RECORDER_OVERFLOW;
+    }
+
+    /* copy the frame into its slot */
+    bufs[0] = buf_0;
+    bufs[1] = buf_1;
+    bufs[2] = buf_2;
+    slot = head % recorder->num_slots;
+    for (c = 0; c < 3; c++) {
+        if ((recorder->sizes[c] > 0) && (bufs[c] != NULL)) {
+            memcpy (p_recorder_buffer (recorder, slot, c), bufs[c], recorder->sizes[c]);
+        }
+    }
+
+    p_atomic_set (&recorder->head, head + 1);
+    p_recorder_wake (recorder);
+
+    return P_OK;
+} /* end of p_recorder_write_all */
+
+/* p_recorder_open */
+pT_status
+p_recorder_open (const char *filename, const pT_header *header,
+                 int first_frame,
+                 int width, int frm_height, int stride, int uv_stride,
+                 int num_slots, pT_recorder **recorder)
+{
+    return p_recorder_open_all (filename, header, first_frame,
+                                P_UNSIGNED_CHAR, P_8_BIT_MEM,
+                                width, frm_height, stride, uv_stride,
+                                num_slots, recorder);
+} /* end of p_recorder_open */
+
+/* p_recorder_open_16 */
+pT_status
+p_recorder_open_16 (const char *filename, const pT_header *header,
+                    int first_frame,
+                    int write_mode,
+                    int width, int frm_height, int stride, int uv_stride,
+                    int num_slots, pT_recorder **recorder)
+{
+    return p_recorder_open_all (filename, header, first_frame,
+                                P_UNSIGNED_SHORT, write_mode,
+                                width, frm_height, stride, uv_stride,
+                                num_slots, recorder);
+} /* end of p_recorder_open_16 */
+
+/* p_recorder_write */
+pT_status
+p_recorder_write (pT_recorder *recorder,
+                  const unsigned char *y_or_r_frm,
+                  const unsigned char *u_or_g_frm,
+                  const unsigned char *v_or_b_frm)
+{
+    return p_recorder_write_all (recorder, P_UNSIGNED_CHAR,
+                                 (const void *)y_or_r_frm,
+                                 (const void *)u_or_g_frm,
+                                 (const void *)v_or_b_frm);
+} /* end of p_recorder_write */
+
+/* p_recorder_write_16 */
+pT_status
+p_recorder_write_16 (pT_recorder *recorder,
+                     const unsigned short *y_or_r_frm,
+                     const unsigned short *u_or_g_frm,
+                     const unsigned short *v_or_b_frm)
+{
+    return p_recorder_write_all (recorder, P_UNSIGNED_SHORT,
+                                 (const void *)y_or_r_frm,
+                                 (const void *)u_or_g_frm,
+                                 (const void *)v_or_b_frm);
+} /* end of p_recorder_write_16 */
+
+/* p_recorder_get_counts */
+void
+p_recorder_get_counts (pT_recorder *recorder,
+                       int *num_written, int *num_dropped)
+{
+    if (num_written != NULL) {
+        *num_written = (int)p_atomic_get (&recorder->num_written);
+    }
+    if (num_dropped != NULL) {
+        *num_dropped = (int)(p_atomic_get (&recorder->num_dropped) +
+                             p_atomic_get (&recorder->num_failed));
+    }
+} /* end of p_recorder_get_counts */
+
+/* p_recorder_close */
+pT_status
+p_recorder_close (pT_recorder *recorder)
+{
+    if (recorder == NULL) {
+        return P_OK;
+    }
+    /* the writer thread writes the frames in the ring, then stops */
+    return p_recorder_free (recorder);
+} /* end of p_recorder_close */
+
+/******************************************************************************/
+
+/*
+ * Asynchronous access.
+ *
+ * A request holds a copy of the parameters and the header; it is
+ * executed by a worker thread (p_work_post). A request on standard
+ * i/o is executed at once, and copies the advanced file position
+ * back to the caller's header. On completion, the
+ * callback is called, and the token is marked done. A request without
+ * token is released by the worker thread; otherwise, p_async_wait()
+ * releases it.
+ *
+ */
+
+struct pT_async_s {
+    char              *filename;
+    pT_header         header;
+    pT_header         *stdio_header; /* caller's header; for standard i/o */
+    pT_color          color_format;
+    int               write;        /* 0=read; 1=write */
+    int               frame;
+    void              *bufs[3];
+    int               mem_type;
+    int               mode;         /* read_mode or write_mode */
+    int               width;
+    int               frm_height;
+    int               stride;
+    int               uv_stride;
+    pT_async_callback callback;
+    void              *user_data;
+    int               has_token;    /* returned to the caller */
+    int               done;
+    pT_status         status;
+    p_mutex_t         lock;
+    p_cond_t          cond;         /* signalled when done */
+};
+
+/* release a request */
+static void
+p_async_free (pT_async *async)
+{
+    free (async->filename);
+    p_cond_destroy (&async->cond);
+    p_mutex_destroy (&async->lock);
+    free (async);
+} /* end of p_async_free */
+
+/* execute a request; a task of p_work_post() */
+static void
+p_async_task (void *arg, int task)
+{
+    pT_async  *async = (pT_async *)arg;
+    pT_status status;
+
+    (void)task;
+    if (async->write) {
+        status = p_write_frame_all (async->filename, NULL, &async->header,
+                                    async->color_format,
+                                    async->frame, P_NORMAL_COMP,
+                                    (const void *)async->bufs[0],
+                                    (const void *)async->bufs[1],
+                                    (const void *)async->bufs[2],
+                                    async->mem_type, async->mode,
+                                    async->width, async->frm_height,
+                                    async->stride, async->uv_stride);
+    } else {
+        status = p_read_frame_all (async->filename, NULL, &async->header,
+                                   async->color_format,
+                                   async->frame, P_NORMAL_COMP,
+                                   async->bufs[0], async->bufs[1], async->bufs[2],
+                                   async->mem_type, async->mode,
+                                   async->width, async->frm_height,
+                                   async->stride, async->uv_stride);
+    } /* end of if (async->write) */
+
+    if (async->stdio_header != NULL) {
+        /* the next access continues from the advanced file position */
+        async->stdio_header->offset_hi = async->header.offset_hi;
+        async->stdio_header->offset_lo = async->header.offset_lo;
+    }
+
+    if (async->callback != NULL) {
+        async->callback (status, async->user_data);
+    }
+
+    if (!async->has_token) {
+        p_async_free (async);
+    } else {
+        /* the request may be released as soon as it is done */
+        p_mutex_lock (&async->lock);
+        async->status = status;
+        async->done   = 1;
+        p_cond_broadcast (&async->cond);
+        p_mutex_unlock (&async->lock);
+    } /* end of if (!async->has_token) */
+} /* end of p_async_task */
+
+/* start a request */
+static pT_status
+p_async_start (const char *filename,
+               pT_header *header,
+               int write,
+               int frame,
+               const void *buf_0,
+               const void *buf_1,
+               const void *buf_2,
+               int mem_type,
+               int mode,
+               int width,
+               int frm_height,
+               int stride,
+               int uv_stride,
+               pT_async_callback callback,
+               void *user_data,
+               pT_async **async)
+{
+    pT_status status = P_OK;
+    pT_async  *new_async;
+
+    if (async != NULL) {
+        *async = NULL;
+    }
+
+    /* check if the file header is modified */
+    status = p_check_modified (header);
+
+    /* check if header is valid */
+    if (status == P_OK) {
+        status = p_check_header (header);
+    } /* end of if (status == P_OK) */
+
+    if (status != P_OK) {
+        return status;
+    }
+
+    new_async = (pT_async *)calloc (1, sizeof(pT_async));
+    if (new_async == NULL) {
+        return P_MALLOC_FAILED;
+    }
+    new_async->filename = (char *)malloc (strlen (filename) + 1);
+    if (new_async->filename == NULL) {
+        free (new_async);
+        return P_MALLOC_FAILED;
+    }
+    strcpy (new_async->filename, filename);
+    p_mutex_init (&new_async->lock);
+    p_cond_init (&new_async->cond);
+    new_async->header       = *header;
+    new_async->stdio_header = strcmp (filename, "-") ? NULL : header;
+    new_async->color_format = p_get_color_format (header);
+    new_async->write        = write;
+    new_async->frame        = frame;
+    new_async->bufs[0]      = (void *)buf_0;
+    new_async->bufs[1]      = (void *)buf_1;
+    new_async->bufs[2]      = (void *)buf_2;
+    new_async->mem_type     = mem_type;
+    new_async->mode         = mode;
+    new_async->width        = width;
+    new_async->frm_height   = frm_height;
+    new_async->stride       = stride;
+    new_async->uv_stride    = uv_stride;
+    new_async->callback     = callback;
+    new_async->user_data    = user_data;
+    new_async->has_token    = (async != NULL);
+    new_async->status       = P_OK;
+
+    if (async != NULL) {
+        *async = new_async;
+    }
+
+    if (!strcmp (filename, "-")) {
+        /* standard i/o: in order */
+        p_async_task ((void *)new_async, 0);
+    } else {
+        p_work_post (p_async_task, (void *)new_async);
+    } /* end of if (!strcmp (filename, "-")) */
+
+    return P_OK;
+} /* end of p_async_start */
+
+/* p_read_frame_async */
+pT_status
+p_read_frame_async (const char *filename, pT_header *header,
+                    int frame,
+                    unsigned char *y_or_r_frm,
+                    unsigned char *u_or_g_frm,
+                    unsigned char *v_or_b_frm,
+                    int read_mode,
+                    int width, int frm_height, int stride, int uv_stride,
+                    pT_async_callback callback, void *user_data,
+                    pT_async **async)
+{
+    return p_async_start (filename, header, 0, frame,
+                          (const void *)y_or_r_frm,
+                          (const void *)u_or_g_frm,
+                          (const void *)v_or_b_frm,
+                          P_UNSIGNED_CHAR, read_mode,
+                          width, frm_height, stride, uv_stride,
+                          callback, user_data, async);
+} /* end of p_read_frame_async */
+
+/* p_read_frame_async_16 */
+pT_status
+p_read_frame_async_16 (const char *filename, pT_header *header,
+                       int frame,
+                       unsigned short *y_or_r_frm,
+                       unsigned short *u_or_g_frm,
+                       unsigned short *v_or_b_frm,
+                       int read_mode,
+                       int width, int frm_height, int stride, int uv_stride,
+                       pT_async_callback callback, void *user_data,
+                       pT_async **async)
+{
+    return p_async_start (filename, header, 0, frame,
+                          (const void *)y_or_r_frm,
+                          (const void *)u_or_g_frm,
+                          (const void *)v_or_b_frm,
+                          P_UNSIGNED_SHORT, read_mode,
+                          width, frm_height, stride, uv_stride,
+                          callback, user_data, async);
+} /* end of p_read_frame_async_16 */
+
+/* p_write_frame_async */
+pT_status
+p_write_frame_async (const char *filename, pT_header *header,
+                     int frame,
+                     const unsigned char *y_or_r_frm,
+                     const unsigned char *u_or_g_frm,
+                     const unsigned char *v_or_b_frm,
+                     int width, int frm_height, int stride, int uv_stride,
+                     pT_async_callback callback, void *user_data,
+                     pT_async **async)
+{
+    return p_async_start (filename, header, 1, frame,
+                          (const void *)y_or_r_frm,
+                          (const void *)u_or_g_frm,
+                          (const void *)v_or_b_frm,
+                          P_UNSIGNED_CHAR, P_8_BIT_MEM,
+                          width, frm_height, stride, uv_stride,
+                          callback, user_data, async);
+} /* end of p_write_frame_async */
+
+/* p_write_frame_async_16 */
+pT_status
+p_write_frame_async_16 (const char *filename, pT_header *header,
+                        int frame,
+                        const unsigned short *y_or_r_frm,
+                        const unsigned short *u_or_g_frm,
+                        const unsigned short *v_or_b_frm,
+                        int write_mode,
+                        int width, int frm_height, int stride, int uv_stride,
+                        pT_async_callback callback, void *user_data,
+                        pT_async **async)
+{
+    return p_async_start (filename, header, 1, frame,
+                          (const void *)y_or_r_frm,
+                          (const void *)u_or_g_frm,
+                          (const void *)v_or_b_frm,
+                          P_UNSIGNED_SHORT, write_mode,
+                          width, frm_height, stride, uv_stride,
+                          callback, user_data, async);
+} /* end of p_write_frame_async_16 */
+
+/* p_async_done */
+int
+p_async_done (pT_async *async)
+{
+    int done;
+
+    p_mutex_lock (&async->lock);
+    done = async->done;
+    p_mutex_unlock (&async->lock);
+
+    return done;
+} /* end of p_async_done */
+
+/* p_async_wait */
+pT_status
+p_async_wait (pT_async *async)
+{
+    pT_status status;
+
+    p_mutex_lock (&async->lock);
+    while (!async->done) {
+        p_cond_wait (&async->cond, &async->lock);
+    }
+    status = async->status;
+    p_mutex_unlock (&async->lock);
+
+    p_async_free (async);
+
+    return status;
+} /* end of p_async_wait */
+
+/******************************************************************************/
+
+/*
+ * Memory mapped (zero-copy) access to single components.
+ */
+
+/* map a field or frame */
+
+static pT_status
+p_map_all (const char *filename,
+           pT_header *header,
+           int frame,
+           int field,      /* 0=frame; 1/2=field */
+           int comp,
+           void **c_buf,
+           int mem_type,
+           int *stride,
+           int write)
+{
+    pT_status      status = P_OK;
+    int            image_number;
+
+    /* check if the file header is modified */
+    status = p_check_modified (header);
+
+    /* check component */
+    if (status == P_OK) {
+        status = p_check_comp (header, comp, !write);
+    } /* end of if (status == P_OK) */
+
+    if (status == P_OK) {
+        if (field != 0) {
+            /* check if header is progressive */
+            if (p_is_progressive (header)) {
+                status = P_SHOULD_BE_INTERLACED;
+            }
+            image_number = 2 * (frame - 1) + field;
+        } else {
+            /* the fields of an interlaced frame are not adjacent in the file */
+            if (p_is_interlaced (header)) {
+                status = P_MAP_NOT_SUPPORTED;
+            }
+            image_number = frame;
+        } /* end of if (field != 0) */
+    } /* end of if (status == P_OK) */
+
+    if (status == P_OK) {
+        status = p_map_image (filename, header,
+                              image_number, comp,
+                              c_buf, mem_type, stride, write,
+                              stderr, NOPRINT);
+    } /* end of if (status == P_OK) */
+
+    return status;
+} /* end of p_map_all */
+
+/* p_map_read_field_comp */
+pT_status
+p_map_read_field_comp (const char *filename, pT_header *header,
+                       int frame, int field, int comp,
+                       const unsigned char **c_fld,
+                       int *stride)
+{
+    return p_map_all (filename, header, frame, field, comp,
+                      (void **)c_fld, P_UNSIGNED_CHAR, stride, 0);
+} /* end of p_map_read_field_comp */
+
+/* p_map_read_frame_comp */
+pT_status
+p_map_read_frame_comp (const char *filename, pT_header *header,
+                       int frame, int comp,
+                       const unsigned char **c_frm,
+                       int *stride)
+{
+    return p_map_all (filename, header, frame, 0, comp,
+                      (void **)c_frm, P_UNSIGNED_CHAR, stride, 0);
+} /* end of p_map_read_frame_comp */
+
+/* p_map_read_field_comp_16 */
+pT_status
+p_map_read_field_comp_16 (const char *filename, pT_header *header,
+                          int frame, int field, int comp,
+                          const unsigned short **c_fld,
+                          int *stride)
+{
+    return p_map_all (filename, header, frame, field, comp,
+                      (void **)c_fld, P_UNSIGNED_SHORT, stride, 0);
+} /* end of p_map_read_field_comp_16 */
+
+/* p_map_read_frame_comp_16 */
+pT_status
+p_map_read_frame_comp_16 (const char *filename, pT_header *header,
+                          int frame, int comp,
+                          const unsigned short **c_frm,
+                          int *stride)
+{
+    return p_map_all (filename, header, frame, 0, comp,
+                      (void **)c_frm, P_UNSIGNED_SHORT, stride, 0);
+} /* end of p_map_read_frame_comp_16 */
+
+/* p_map_write_field_comp */
+pT_status
+p_map_write_field_comp (const char *filename, pT_header *header,
+                        int frame, int field, int comp,
+                        unsigned char **c_fld,
+                        int *stride)
+{
+    return p_map_all (filename, header, frame, field, comp,
+                      (void **)c_fld, P_UNSIGNED_CHAR, stride, 1);
+} /* end of p_map_write_field_comp */
+
+/* p_map_write_frame_comp */
+pT_status
+p_map_write_frame_comp (const char *filename, pT_header *header,
+                        int frame, int comp,
+                        unsigned char **c_frm,
+                        int *stride)
+{
+    return p_map_all (filename, header, frame, 0, comp,
+                      (void **)c_frm, P_UNSIGNED_CHAR, stride, 1);
+} /* end of p_map_write_frame_comp */
+
+/* p_map_write_field_comp_16 */
+pT_status
+p_map_write_field_comp_16 (const char *filename, pT_header *header,
+                           int frame, int field, int comp,
+                           unsigned short **c_fld,
+                           int *stride)
+{
+    return p_map_all (filename, header, frame, field, comp,
+                      (void **)c_fld, P_UNSIGNED_SHORT, stride, 1);
+} /* end of p_map_write_field_comp_16 */
+
+/* p_map_write_frame_comp_16 */
+pT_status
+p_map_write_frame_comp_16 (const char *filename, pT_header *header,
+                           int frame, int comp,
+                           unsigned short **c_frm,
+                           int *stride)
+{
+    return p_map_all (filename, header, frame, 0, comp,
+                      (void **)c_frm, P_UNSIGNED_SHORT, stride, 1);
+} /* end of p_map_write_frame_comp_16 */
+
+/******************************************************************************/
+
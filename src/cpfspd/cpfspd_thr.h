@@ -0,0 +1,102 @@
+/*
+ *  All rights reserved.
+ *  For licensing and warranty information, see the file COPYING.LGPLv21.txt
+ *  in the root directory of this package.
+ *
+ *  Name        :  cpfspd_thr.h
+ *
+ *  Function    :  THReading primitives of cpfspd.
+ *                 ---
+ *
+ *  Description :  Threads, mutex and condition variable, mapped onto
+ *                 the native primitives: win32 threads and slim
+ *                 reader/writer locks on win32, pthreads on all other
+ *                 platforms. Mutex and condition variable can be
+ *                 initialized statically.
+ *
+ *                 An atomic counter (p_atomic_t) is read and written
+ *                 with sequentially consistent ordering by
+ *                 p_atomic_get() and p_atomic_set().
+ *
+ *                 A thread function is defined as
+ *                     static P_THREAD_FUNC(name, arg) { ...; P_THREAD_RETURN; }
+ *                 and thread local data as
+ *                     static P_THREAD_LOCAL type name;
+ */
+
+/******************************************************************************/
+
+#ifndef CPFSPD_THR_H
+#define CPFSPD_THR_H
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+typedef HANDLE              p_thread_t;
+typedef SRWLOCK             p_mutex_t;
+typedef CONDITION_VARIABLE  p_cond_t;
+
+#define P_THREAD_FUNC(f, a)     DWORD WINAPI f(LPVOID a)
+#define P_THREAD_LOCAL          __declspec(thread)
+#define P_THREAD_RETURN         return(0)
+
+#define P_MUTEX_INITIALIZER     SRWLOCK_INIT
+#define P_COND_INITIALIZER      CONDITION_VARIABLE_INIT
+
+#define p_mutex_init(m)         InitializeSRWLock(m)
+#define p_mutex_destroy(m)      ((void)(m))
+#define p_mutex_lock(m)         AcquireSRWLockExclusive(m)
+#define p_mutex_unlock(m)       ReleaseSRWLockExclusive(m)
+#define p_cond_init(c)          InitializeConditionVariable(c)
+#define p_cond_destroy(c)       ((void)(c))
+#define p_cond_wait(c, m)       ((void)SleepConditionVariableSRW((c), (m), INFINITE, 0))
+#define p_cond_broadcast(c)     WakeAllConditionVariable(c)
+
+/* p_thread_create() returns whether the thread was started */
+#define p_thread_create(t, f, a) ((*(t) = CreateThread(NULL, 0, (f), (a), 0, NULL)) != NULL)
+#define p_thread_join(t)        ((void)WaitForSingleObject((t), INFINITE), (void)CloseHandle(t))
+
+typedef volatile LONG       p_atomic_t;
+
+#define p_atomic_get(p)         InterlockedCompareExchange((p), 0, 0)
+#define p_atomic_set(p, v)      ((void)InterlockedExchange((p), (v)))
+
+#else /* _WIN32 */
+
+#include <pthread.h>
+
+typedef pthread_t           p_thread_t;
+typedef pthread_mutex_t     p_mutex_t;
+typedef pthread_cond_t      p_cond_t;
+
+#define P_THREAD_FUNC(f, a)     void *f(void *a)
+#define P_THREAD_LOCAL          __thread
+#define P_THREAD_RETURN         return(NULL)
+
+#define P_MUTEX_INITIALIZER     PTHREAD_MUTEX_INITIALIZER
+#define P_COND_INITIALIZER      PTHREAD_COND_INITIALIZER
+
+#define p_mutex_init(m)         ((void)pthread_mutex_init((m), NULL))
+#define p_mutex_destroy(m)      ((void)pthread_mutex_destroy(m))
+#define p_mutex_lock(m)         ((void)pthread_mutex_lock(m))
+#define p_mutex_unlock(m)       ((void)pthread_mutex_unlock(m))
+#define p_cond_init(c)          ((void)pthread_cond_init((c), NULL))
+#define p_cond_destroy(c)       ((void)pthread_cond_destroy(c))
+#define p_cond_wait(c, m)       ((void)pthread_cond_wait((c), (m)))
+#define p_cond_broadcast(c)     ((void)pthread_cond_broadcast(c))
+
+/* p_thread_create() returns whether the thread was started */
+#define p_thread_create(t, f, a) (pthread_create((t), NULL, (f), (a)) == 0)
+#define p_thread_join(t)        ((void)pthread_join((t), NULL))
+
+typedef long                p_atomic_t;
+
+#define p_atomic_get(p)         __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define p_atomic_set(p, v)      __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+
+#endif /* _WIN32 */
+
+#endif /* end of #ifndef CPFSPD_THR_H */
+
+/******************************************************************************/
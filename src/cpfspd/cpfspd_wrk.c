@@ -0,0 +1,416 @@
+/*
+ *  All rights reserved.
+ *  For licensing and warranty information, see the file COPYING.LGPLv21.txt
+ *  in the root directory of this package.
+ *
+ *  Name        :  cpfspd_wrk.c
+ *
+ *  Function    :  WoRKer threads of cpfspd.
+ *                   --
+ *
+ *  Description :  A job consists of a number of independent tasks.
+ *                 p_work_run() queues the job; the worker threads and
+ *                 the calling thread take its tasks one by one, until
+ *                 all are started. The caller then waits until the
+ *                 tasks taken by the workers are done.
+ *
+ *                 Since the caller takes part, a job always completes,
+ *                 even when all workers are busy. So a task may start
+ *                 a job itself (e.g. to convert the lines of an image
+ *                 in parallel while reading multiple frames).
+ *
+ *                 p_work_post() queues a single task that is executed
+ *                 by a worker while the caller continues (asynchronous
+ *                 access). Without workers, it is executed at once.
+ *
+ *                 The workers are started at the first job, and stopped
+ *                 by p_set_num_threads(). There is one set of workers
+ *                 for all threads of the application. A task is executed
+ *                 in the context (see p_context_select()) of the thread
+ *                 that queued its job.
+ *
+ *                 Exported functions:
+ *                 - p_set_num_threads()
+ *                 - p_get_num_threads()
+ *
+ *                 Functions only used internally in cpfspd:
+ *                 - p_work_run()
+ *                 - p_work_post()
+ *                 - p_work_threads()
+ */
+
+/*
+ * sysconf(_SC_NPROCESSORS_ONLN) is not part of ANSI-C.
+ * This must precede all includes.
+ */
+#ifndef _WIN32
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+#endif
+
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "cpfspd.h"
+#include "cpfspd_thr.h"
+#include "cpfspd_wrk.h"
+
+/******************************************************************************/
+
+#define MIN(x,y)        ( ((x) < (y)) ? (x) : (y) )
+
+/* Maximum number of threads */
+#define P_MAX_THREADS   256
+
+/* A queued job */
+typedef struct p_job_s {
+    p_work_func     func;
+    void            *arg;
+    int             num_tasks;
+    int             next_task;          /* Next task to start */
+    int             done_tasks;         /* Number of tasks completed */
+    int             posted;             /* Allocated by p_work_post() */
+    pT_context      *context;           /* Context of the caller */
+    struct p_job_s  *next;              /* Next job in the queue */
+} p_job_t;
+
+static p_mutex_t    p_work_lock = P_MUTEX_INITIALIZER;
+static p_cond_t     p_work_cond = P_COND_INITIALIZER;   /* Job queued, or stop */
+static p_cond_t     p_done_cond = P_COND_INITIALIZER;   /* Job completed */
+static p_mutex_t    p_set_lock  = P_MUTEX_INITIALIZER;  /* Serializes p_set_num_threads() */
+
+static p_job_t      *p_job_first = NULL;    /* Jobs with tasks to start */
+static p_job_t      *p_job_last  = NULL;
+static p_thread_t   *p_workers = NULL;
+static int          p_num_workers = 0;      /* Number of workers running */
+static int          p_num_threads = 0;      /* Setting; 0: number of processors */
+static int          p_work_stop = 0;
+
+/******************************************************************************/
+
+/* Number of processors of the system */
+static int
+p_num_processors (void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    return((int)info.dwNumberOfProcessors);
+#elif defined(_SC_NPROCESSORS_ONLN)
+    long num = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return((num > 0) ? (int)MIN(num, P_MAX_THREADS) : 1);
+#else
+    return(1);
+#endif
+} /* p_num_processors () */
+
+
+/* Number of threads for a job; called with p_work_lock held */
+static int
+p_threads_setting (void)
+{
+    return((p_num_threads != 0) ? p_num_threads : p_num_processors());
+} /* p_threads_setting () */
+
+
+/* Take the next task of a job; called with p_work_lock held */
+static int
+p_take_task (p_job_t *job)
+{
+    const int task = job->next_task++;
+
+    if (job->next_task == job->num_tasks) {
+        /* All tasks started: remove the job from the queue */
+        p_job_t *prev = NULL;
+        p_job_t *cur  = p_job_first;
+
+        while (cur != job) {
+            prev = cur;
+            cur  = cur->next;
+        }
+        if (prev != NULL) {
+            prev->next = job->next;
+        } else {
+            p_job_first = job->next;
+        }
+        if (p_job_last == job) {
+            p_job_last = prev;
+        }
+    }
+    return(task);
+} /* p_take_task () */
+
+
+/* Complete a task; called with p_work_lock held */
+static void
+p_task_done (p_job_t *job)
+{
+    job->done_tasks++;
+    if (job->done_tasks == job->num_tasks) {
+        p_cond_broadcast(&p_done_cond);
+    }
+} /* p_task_done () */
+
+
+/* Execute a task taken from the queue in the context of its job */
+static void
+p_queued_task_run (p_job_t *job, int task)
+{
+    pT_context *prev = p_context_select(job->context);
+
+    job->func(job->arg, task);
+    (void)p_context_select(prev);
+} /* p_queued_task_run () */
+
+
+/* Complete a task taken from the queue; called with p_work_lock held */
+static void
+p_queued_task_done (p_job_t *job)
+{
+    if (job->posted) {
+        /* Nobody waits for a posted job */
+        free(job);
+    } else {
+        p_task_done(job);
+    }
+} /* p_queued_task_done () */
+
+
+/* Execute the tasks of queued jobs until the queue is empty;
+   called with p_work_lock held */
+static void
+p_run_queued (void)
+{
+    p_job_t *job;
+    int     task;
+
+    while (p_job_first != NULL) {
+        job  = p_job_first;
+        task = p_take_task(job);
+        p_mutex_unlock(&p_work_lock);
+
+        p_queued_task_run(job, task);
+
+        p_mutex_lock(&p_work_lock);
+        p_queued_task_done(job);
+    }
+} /* p_run_queued () */
+
+
+static P_THREAD_FUNC(p_worker, arg)
+{
+    p_job_t *job;
+    int     task;
+
+    (void)arg;
+    p_mutex_lock(&p_work_lock);
+    while (!p_work_stop) {
+        if (p_job_first == NULL) {
+            p_cond_wait(&p_work_cond, &p_work_lock);
+            continue;
+        }
+        job  = p_job_first;
+        task = p_take_task(job);
+        p_mutex_unlock(&p_work_lock);
+
+        p_queued_task_run(job, task);
+
+        p_mutex_lock(&p_work_lock);
+        p_queued_task_done(job);
+    }
+    p_mutex_unlock(&p_work_lock);
+
+    P_THREAD_RETURN;
+} /* p_worker () */
+
+
+/* Start the workers, if not yet done; called with p_work_lock held */
+static void
+p_start_workers (void)
+{
+    int num;
+
+    if ((p_workers != NULL) || p_work_stop) {
+        return;
+    }
+    num = p_threads_setting() - 1;
+    if (num < 1) {
+        return;
+    }
+    p_workers = (p_thread_t *)malloc(num * sizeof(p_thread_t));
+    if (p_workers == NULL) {
+        return;
+    }
+    while ((p_num_workers < num) &&
+           p_thread_create(&p_workers[p_num_workers], p_worker, NULL)) {
+        p_num_workers++;
+    }
+} /* p_start_workers () */
+
+
+/******************************************************************************/
+
+void
+p_work_run (p_work_func func, void *arg, int num_tasks)
+{
+    p_job_t job;
+    int     task;
+
+    p_mutex_lock(&p_work_lock);
+    if (num_tasks > 1) {
+        p_start_workers();
+    }
+    if ((num_tasks <= 1) || (p_num_workers == 0)) {
+        p_mutex_unlock(&p_work_lock);
+        for (task = 0; task < num_tasks; task++) {
+            func(arg, task);
+        }
+        return;
+    }
+
+    job.func       = func;
+    job.arg        = arg;
+    job.num_tasks  = num_tasks;
+    job.next_task  = 0;
+    job.done_tasks = 0;
+    job.posted     = 0;
+    job.context    = p_context_current();
+    job.next       = NULL;
+    if (p_job_last != NULL) {
+        p_job_last->next = &job;
+    } else {
+        p_job_first = &job;
+    }
+    p_job_last = &job;
+    p_cond_broadcast(&p_work_cond);
+
+    /* Take part until all tasks are started */
+    while (job.next_task < job.num_tasks) {
+        task = p_take_task(&job);
+        p_mutex_unlock(&p_work_lock);
+
+        func(arg, task);
+
+        p_mutex_lock(&p_work_lock);
+        p_task_done(&job);
+    }
+    /* Wait for the tasks taken by the workers */
+    while (job.done_tasks < job.num_tasks) {
+        p_cond_wait(&p_done_cond, &p_work_lock);
+    }
+    p_mutex_unlock(&p_work_lock);
+} /* end of p_work_run */
+
+
+void
+p_work_post (p_work_func func, void *arg)
+{
+    p_job_t *job = (p_job_t *)malloc(sizeof(p_job_t));
+
+    p_mutex_lock(&p_work_lock);
+    p_start_workers();
+    if ((job == NULL) || (p_num_workers == 0)) {
+        p_mutex_unlock(&p_work_lock);
+        free(job);
+        func(arg, 0);
+        return;
+    }
+
+    job->func       = func;
+    job->arg        = arg;
+    job->num_tasks  = 1;
+    job->next_task  = 0;
+    job->done_tasks = 0;
+    job->posted     = 1;
+    job->context    = p_context_current();
+    job->next       = NULL;
+    if (p_job_last != NULL) {
+        p_job_last->next = job;
+    } else {
+        p_job_first = job;
+    }
+    p_job_last = job;
+    p_cond_broadcast(&p_work_cond);
+    p_mutex_unlock(&p_work_lock);
+} /* end of p_work_post */
+
+
+int
+p_work_threads (void)
+{
+    int num;
+
+    p_mutex_lock(&p_work_lock);
+    num = p_threads_setting();
+    p_mutex_unlock(&p_work_lock);
+
+    return(num);
+} /* end of p_work_threads */
+
+
+pT_status
+p_set_num_threads (const int num_threads)
+{
+    p_thread_t *workers;
+    int        num_workers;
+    int        i;
+
+    if ((num_threads < 0) || (num_threads > P_MAX_THREADS)) {
+        return(P_ILLEGAL_NUM_THREADS);
+    }
+
+    p_mutex_lock(&p_set_lock);
+
+    /* Stop the current workers; running jobs are completed by their callers */
+    p_mutex_lock(&p_work_lock);
+    workers     = p_workers;
+    num_workers = p_num_workers;
+    p_workers     = NULL;
+    p_num_workers = 0;
+    p_work_stop   = 1;
+    p_cond_broadcast(&p_work_cond);
+    p_mutex_unlock(&p_work_lock);
+
+    for (i = 0; i < num_workers; i++) {
+        p_thread_join(workers[i]);
+    }
+    free(workers);
+
+    /* New workers are started at the next job, or now for the
+       queued jobs; without workers, they are executed here */
+    p_mutex_lock(&p_work_lock);
+    p_work_stop   = 0;
+    p_num_threads = num_threads;
+    if (p_job_first != NULL) {
+        p_start_workers();
+        if (p_num_workers == 0) {
+            p_run_queued();
+        }
+    }
+    p_mutex_unlock(&p_work_lock);
+
+    p_mutex_unlock(&p_set_lock);
+
+    return(P_OK);
+} /* end of p_set_num_threads */
+
+
+int
+p_get_num_threads (void)
+{
+    int num;
+
+    p_mutex_lock(&p_work_lock);
+    num = p_num_threads;
+    p_mutex_unlock(&p_work_lock);
+
+    return(num);
+} /* end of p_get_num_threads */
+
+/******************************************************************************/
@@ -0,0 +1,40 @@
+/*
+ *  All rights reserved.
+ *  For licensing and warranty information, see the file COPYING.LGPLv21.txt
+ *  in the root directory of this package.
+ *
+ *  Name        :  cpfspd_wrk.h
+ *
+ *  Function    :  Header file for cpfspd_wrk.c
+ *
+ *  Description :  Worker threads that execute the tasks of a job
+ *                 in parallel.
+ */
+
+/******************************************************************************/
+
+#ifndef CPFSPD_WRK_H
+#define CPFSPD_WRK_H
+
+/* A task of a job: called with the job argument and the task number */
+typedef void (*p_work_func)(void *arg, int task);
+
+/*
+ * Execute func(arg, task) for task = 0 .. num_tasks-1, on the worker
+ * threads and the calling thread. Returns when all tasks are done.
+ * Tasks may start jobs themselves.
+ */
+extern void p_work_run(p_work_func func, void *arg, int num_tasks);
+
+/*
+ * Execute func(arg, 0) on a worker thread; returns at once. Without
+ * worker threads, func is executed before p_work_post() returns.
+ */
+extern void p_work_post(p_work_func func, void *arg);
+
+/* Number of threads that execute a job (the workers and the caller) */
+extern int p_work_threads(void);
+
+#endif /* end of #ifndef CPFSPD_WRK_H */
+
+/******************************************************************************/
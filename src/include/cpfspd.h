@@ -144,6 +144,14 @@ typedef enum {
     P_WRITE_BEYOND_EOF_STDOUT       = 115,
     P_REWRITE_ON_STDOUT             = 116,
     P_REWRITE_MODIFIED_HEADER       = 117,
+    P_MAP_FAILED                    = 120,
+    P_MAP_NOT_SUPPORTED             = 121,
+    P_ILLEGAL_MAX_OPEN_FILES        = 130,
+    P_FILE_HANDLE_CLOSED            = 131,
+    P_ILLEGAL_NUM_THREADS           = 132,
+    P_THREAD_CREATE_FAILED          = 133,
+    P_RECORDER_OVERFLOW             = 134,
+    P_ISA_NOT_SUPPORTED             = 135,
     P_TOO_MANY_IMAGES               = 199,
     P_TOO_MANY_COMPONENTS           = 200,
     P_INVALID_COMPONENT             = 201,
@@ -1479,6 +1487,88 @@ extern pT_status p_write_frame_comp_16
          int width, int frm_height, int stride);
 /** @} */
 
+/** \defgroup mapping Zero-copy access to single components
+ * \ingroup single_comp
+ * @{
+ * Memory mapped access per component.
+ *
+ * Instead of copying the data from or into an application buffer, these
+ * functions return a pointer directly into a memory mapping of the
+ * file. This avoids the data copy, which is significant when the same
+ * (large) sequences are analysed repeatedly, or when an application
+ * renders its output directly into the file.
+ *
+ * The data is presented exactly as it is stored in the file, as if
+ * read_mode = P_AF_BIT_MEM were used. Hence this is only possible when
+ * no conversion is required:
+ *   - 8 bit access: file data format P_8_BIT_FILE.
+ *   - 16 bit access: all other file data formats, provided that the
+ *     file endian mode equals that of the system.
+ *
+ * The returned view covers the whole component, i.e. the size
+ * returned by p_get_comp_buffer_size(). The \p stride is returned
+ * in elements (not in bytes).
+ * Frame access requires a progressive file, field access requires
+ * an interlaced file.
+ *
+ * The read data is read-only. The data remains valid until the file
+ * is closed: by p_close_file(), at program termination, or when the
+ * library closes the file implicitly (more open files than the
+ * maximum set by p_set_max_open_files(), 10 by default, or a
+ * switch between read and write access to this file).
+ *
+ * Write access is only possible to a file that already has its final
+ * size, i.e. the number of images was specified in the header when
+ * p_write_header() was called. The image is administrated as written
+ * at the moment the pointer is returned; the application shall fill
+ * in the data before the file is closed.
+ *
+ * Not supported on standard i/o and on platforms without memory
+ * mapped file access (P_MAP_NOT_SUPPORTED is returned). In that case,
+ * use the p_read_frame/field_comp() functions.
+ */
+extern pT_status p_map_read_field_comp
+        (const char *filename, pT_header *header,
+         int frame, int field, int comp,
+         const unsigned char **c_fld,
+         int *stride);
+extern pT_status p_map_read_frame_comp
+        (const char *filename, pT_header *header,
+         int frame, int comp,
+         const unsigned char **c_frm,
+         int *stride);
+extern pT_status p_map_read_field_comp_16
+        (const char *filename, pT_header *header,
+         int frame, int field, int comp,
+         const unsigned short **c_fld,
+         int *stride);
+extern pT_status p_map_read_frame_comp_16
+        (const char *filename, pT_header *header,
+         int frame, int comp,
+         const unsigned short **c_frm,
+         int *stride);
+extern pT_status p_map_write_field_comp
+        (const char *filename, pT_header *header,
+         int frame, int field, int comp,
+         unsigned char **c_fld,
+         int *stride);
+extern pT_status p_map_write_frame_comp
+        (const char *filename, pT_header *header,
+         int frame, int comp,
+         unsigned char **c_frm,
+         int *stride);
+extern pT_status p_map_write_field_comp_16
+        (const char *filename, pT_header *header,
+         int frame, int field, int comp,
+         unsigned short **c_fld,
+         int *stride);
+extern pT_status p_map_write_frame_comp_16
+        (const char *filename, pT_header *header,
+         int frame, int comp,
+         unsigned short **c_frm,
+         int *stride);
+/** @} */
+
 /** \defgroup comp_hdr Low level header functions on single components
  * \ingroup single_comp
  *  @{
@@ -1796,8 +1886,13 @@ extern pT_status p_write_aux (
 /** \defgroup openclose File open/close.
  * @{
  * Cpfspd opens a file at its first access. When the application
- * attempts to open more than 10 files simultaneously, the least recently
- * used one is closed. At program termination, all open files are closed.
+ * attempts to open more files simultaneously than the maximum set by
+ * p_set_max_open_files() (10 by default), the least recently used one
+ * is closed. The maximum can be raised, e.g. to a few thousand for
+ * applications that access many files alternately (the operating
+ * system limit on open files applies as well). Reducing the maximum
+ * below the number of files opened up till now closes all files.
+ * At program termination, all open files are closed.
  * Normally, this is all handled automatically and the application
  * does not need to take action.
  *
@@ -1805,23 +1900,23 @@ extern pT_status p_write_aux (
  * These functions allow more detailed control over the open files.
  *
  * The open file administration is kept inside the cpfspd library
- * and is stored in global data. Therefore, multithreading applications
- * need to take special precautions.
- *
- * In a multi threading application one of the following two approaches
- * must be followed:
- * 1) First open all files in a single thread, then start threads
- * to process the data from the opened files. More precise:
- * - all open and close operations shall be performed in a single thread
- * - a single file shall be accessed only within a single thread
- * - no more than 10 files shall be accessed
- * 2) Perform all accesses to a file in a single threat and
- * protect all file open and close operations as critical sections.
- * More precise:
- * - all open and close operations shall be sequentialized by putting
- *   them in a critical section (e.g. guarded by a single semaphore)
- * - a single file shall be accessed only within a single thread
- * - no more than 10 files shall be accessed
+ * in a context (see p_context_create()), which is protected against
+ * concurrent use. Multithreading applications may access files from
+ * any thread:
+ * - distinct files are read and written in parallel; accesses to the
+ *   same file are serialized, except reads of a file that is open for
+ *   reading only: these use positional i/o and proceed in parallel
+ *   (only with posix file i/o, not via standard i/o);
+ * - a file is only closed (explicitly, or implicitly to make room for
+ *   another file) when no other thread is accessing it. When more
+ *   threads access files simultaneously than the maximum number of
+ *   open files, the excess threads wait for a file to become available;
+ * - each thread shall use its own pT_header structure (the file
+ *   position is kept in it), or share it only with accesses to
+ *   the same file; parallel reads do not modify the header, so
+ *   threads may read frames of one file with a shared header;
+ * - the file buffer size and file access mode (see below) shall be
+ *   set before the threads start accessing files.
  *
  * File open: specify the filename and a flag indicating write access.
  * File close: if a filename is specified, only that file is closed
@@ -1829,14 +1924,436 @@ extern pT_status p_write_aux (
  */
 extern pT_status p_open_file (const char *filename, int write);
 extern pT_status p_close_file (const char *filename);
+extern pT_status p_set_max_open_files (const int max_files);
+extern int       p_get_max_open_files (void);
+/** @} */
+
+/** \defgroup handle File handles
+ * @{
+ * Access to an open file via a handle.
+ *
+ * The functions above find the file by its name at every call, and
+ * check the header that is passed. For applications that access
+ * a file very frequently (e.g. small images at a high rate), the
+ * file can instead be opened once with p_file_open(). This reads and
+ * checks the header, and keeps the file open until p_file_close():
+ * it does not count for the maximum number of open files and is never
+ * closed implicitly. The frame functions below take the handle instead
+ * of the filename and header; their other parameters are the same as
+ * those of the corresponding functions without "file_".
+ *
+ * The header of the file is obtained with p_file_get_header(); it
+ * remains valid until p_file_close(). Multiple threads can read
+ * different frames via one read-only handle at the same time.
+ * With write access, the file shall already exist with its header,
+ * i.e. open it after p_create_file() or p_write_header(). The header
+ * cannot be changed while a handle is open.
+ *
+ * A file can be open by at most one handle, and not via standard i/o.
+ * The filename based functions can still access the file, but can not
+ * write to it when the handle is open for reading only.
+ * When the file is closed by p_close_file() or p_set_max_open_files(),
+ * the handle functions return P_FILE_HANDLE_CLOSED; the handle shall
+ * then still be released with p_file_close().
+ */
+typedef struct pT_file_s pT_file;
+
+extern pT_status p_file_open (const char *filename, int write, pT_file **file);
+extern pT_status p_file_close (pT_file *file);
+extern const pT_header *p_file_get_header (const pT_file *file);
+
+extern pT_status p_file_read_frame
+        (pT_file *file, int frame,
+         unsigned char *y_or_s_frm,
+         unsigned char *uv_frm,
+         int read_mode,
+         int width, int frm_height, int stride);
+extern pT_status p_file_write_frame
+        (pT_file *file, int frame,
+         const unsigned char *y_or_s_frm,
+         const unsigned char *uv_frm,
+         int width, int frm_height, int stride);
+extern pT_status p_file_read_frame_16
+        (pT_file *file, int frame,
+         unsigned short *y_or_s_frm,
+         unsigned short *uv_frm,
+         int read_mode,
+         int width, int frm_height, int stride);
+extern pT_status p_file_write_frame_16
+        (pT_file *file, int frame,
+         const unsigned short *y_or_s_frm,
+         const unsigned short *uv_frm,
+         int write_mode,
+         int width, int frm_height, int stride);
+extern pT_status p_file_read_frame_planar
+        (pT_file *file, int frame,
+         unsigned char *y_or_r_frm,
+         unsigned char *u_or_g_frm,
+         unsigned char *v_or_b_frm,
+         int read_mode,
+         int width, int frm_height, int stride, int uv_stride);
+extern pT_status p_file_write_frame_planar
+        (pT_file *file, int frame,
+         const unsigned char *y_or_r_frm,
+         const unsigned char *u_or_g_frm,
+         const unsigned char *v_or_b_frm,
+         int width, int frm_height, int stride, int uv_stride);
+extern pT_status p_file_read_frame_planar_16
+        (pT_file *file, int frame,
+         unsigned short *y_or_r_frm,
+         unsigned short *u_or_g_frm,
+         unsigned short *v_or_b_frm,
+         int read_mode,
+         int width, int frm_height, int stride, int uv_stride);
+extern pT_status p_file_write_frame_planar_16
+        (pT_file *file, int frame,
+         const unsigned short *y_or_r_frm,
+         const unsigned short *u_or_g_frm,
+         const unsigned short *v_or_b_frm,
+         int write_mode,
+         int width, int frm_height, int stride, int uv_stride);
+extern pT_status p_file_read_frame_comp
+        (pT_file *file, int frame, int comp,
+         unsigned char *c_frm,
+         int read_mode,
+         int width, int frm_height, int stride);
+extern pT_status p_file_write_frame_comp
+        (pT_file *file, int frame, int comp,
+         const unsigned char *c_frm,
+         int width, int frm_height, int stride);
+extern pT_status p_file_read_frame_comp_16
+        (pT_file *file, int frame, int comp,
+         unsigned short *c_frm,
+         int read_mode,
+         int width, int frm_height, int stride);
+extern pT_status p_file_write_frame_comp_16
+        (pT_file *file, int frame, int comp,
+         const unsigned short *c_frm,
+         int write_mode,
+         int width, int frm_height, int stride);
+/** @} */
+
+/** \defgroup context Contexts
+ * @{
+ * A context holds the open file administration (see p_open_file()),
+ * the maximum number of open files, the file buffer size and the file
+ * access mode. By default, all threads use the default context.
+ * Independent parts of an application can each create their own
+ * context: their files are then administrated separately, so they
+ * do not close each other's files to make room, and they do not wait
+ * for each other's administration.
+ *
+ * p_context_select() selects the context of the calling thread for all
+ * subsequent functions that take a filename, and for p_file_open() and
+ * the settings above; NULL selects the default context. It returns the
+ * previously selected context. A handle keeps using the context in which
+ * it was opened. The worker threads of the library (see
+ * p_set_num_threads()) and the threads of streams and recorders use
+ * the context of the thread that started them.
+ *
+ * p_context_destroy() closes all files of the context and releases it;
+ * it shall no longer be selected in any thread, and its handles shall
+ * be closed before. Standard i/o, parallel conversion and the number of
+ * threads are shared by all contexts. The file name of an open file
+ * shall not be open in another context at the same time.
+ */
+typedef struct pT_context_s pT_context;
+
+extern pT_status   p_context_create (pT_context **context);
+extern pT_status   p_context_destroy (pT_context *context);
+extern pT_context *p_context_select (pT_context *context);
+extern pT_context *p_context_current (void);
+/** @} */
+
+/** \defgroup frames Reading multiple frames
+ * @{
+ * p_read_frames() reads a number of frames in one call: either the
+ * range first_frame .. first_frame+num_frames-1 (frames is NULL), or
+ * the list of frame numbers frames[0 .. num_frames-1].
+ * The frames are divided over the worker threads of the library.
+ * Consecutive frames are stored one after the other in the file, so
+ * a run of consecutive frames is read with a few large transfers.
+ *
+ * The buffer parameters are arrays of num_frames pointers: the buffers
+ * of each frame. The buffers of a frame are used as those of
+ * p_read_frame_planar() (for multiplexed YUV and stream files: as
+ * y_or_s_frm and uv_frm of p_read_frame(); v_or_b_frms is not used).
+ * An array may be NULL when read_mode does not read its component.
+ * The header is not modified, so multiple threads can use it at the
+ * same time; only for standard input, the file position in the header
+ * is updated (the frames are then read in order). When reading a frame fails, the other frames are still
+ * read; the status of the first frame that failed is returned.
+ *
+ * p_set_num_threads() sets the number of threads that read (or
+ * convert) in parallel, including the calling thread: 1 disables the
+ * worker threads, 0 selects the number of processors (the default).
+ */
+extern pT_status p_read_frames
+        (const char *filename, pT_header *header,
+         int first_frame, int num_frames, const int *frames,
+         unsigned char **y_or_r_frms,
+         unsigned char **u_or_g_frms,
+         unsigned char **v_or_b_frms,
+         int read_mode,
+         int width, int frm_height, int stride, int uv_stride);
+extern pT_status p_read_frames_16
+        (const char *filename, pT_header *header,
+         int first_frame, int num_frames, const int *frames,
+         unsigned short **y_or_r_frms,
+         unsigned short **u_or_g_frms,
+         unsigned short **v_or_b_frms,
+         int read_mode,
+         int width, int frm_height, int stride, int uv_stride);
+
+extern pT_status p_set_num_threads (const int num_threads);
+extern int       p_get_num_threads (void);
+/** @} */
+
+/** \defgroup stream Streaming reader
+ * @{
+ * A stream reads the frames first_frame .. first_frame+num_frames-1
+ * of a file in the background, for applications that process the
+ * frames one by one (e.g. playback). Reading the file data, converting
+ * it into the memory format and the processing by the application
+ * overlap: a reader thread reads the data of the next frames, and a
+ * conversion thread converts it into frame buffers that are owned by
+ * the stream.
+ *
+ * p_stream_next() waits for the next frame and returns its number and
+ * its buffers; the frame number is 0 at the end of the stream. The
+ * buffers are laid out as those of p_read_frame_planar() (for
+ * multiplexed YUV and stream files: as y_or_s_frm and uv_frm of
+ * p_read_frame()) with the width, frm_height, strides and read_mode of
+ * p_stream_open(). The status is the one of reading that frame.
+ * The buffers remain valid until the frame is returned to the stream by
+ * p_stream_release(), which releases the oldest frame delivered.
+ * At most queue_size frames are in the stream at the same time (0
+ * selects 4): read, converted or delivered, but not yet released.
+ * When the application holds queue_size frames, p_stream_next()
+ * returns P_TOO_MANY_IMAGES.
+ *
+ * Streams opened by p_stream_open() deliver 8 bit buffers, those
+ * opened by p_stream_open_16() 16 bit buffers; use p_stream_next() or
+ * p_stream_next_16() accordingly. The header is copied at open.
+ * A stream is used by one thread at a time. p_stream_close() stops the
+ * stream, also when not all frames have been delivered.
+ */
+typedef struct pT_stream_s pT_stream;
+
+extern pT_status p_stream_open
+        (const char *filename, const pT_header *header,
+         int first_frame, int num_frames,
+         int read_mode,
+         int width, int frm_height, int stride, int uv_stride,
+         int queue_size, pT_stream **stream);
+extern pT_status p_stream_open_16
+        (const char *filename, const pT_header *header,
+         int first_frame, int num_frames,
+         int read_mode,
+         int width, int frm_height, int stride, int uv_stride,
+         int queue_size, pT_stream **stream);
+extern pT_status p_stream_next
+        (pT_stream *stream, int *frame,
+         unsigned char **y_or_r_frm,
+         unsigned char **u_or_g_frm,
+         unsigned char **v_or_b_frm);
+extern pT_status p_stream_next_16
+        (pT_stream *stream, int *frame,
+         unsigned short **y_or_r_frm,
+         unsigned short **u_or_g_frm,
+         unsigned short **v_or_b_frm);
+extern pT_status p_stream_release (pT_stream *stream);
+extern pT_status p_stream_close (pT_stream *stream);
+/** @} */
+
+/** \defgroup recorder Recorder
+ * @{
+ * A recorder writes frames at real-time rates, e.g. from a capture
+ * thread. p_recorder_write() copies the frame into a ring of num_slots
+ * frame buffers (0 selects 4) that are allocated at open, and returns
+ * immediately; a writer thread writes the frames of the ring to the
+ * file. Passing a frame takes no lock, so the capture thread is not
+ * delayed by the disk. When the ring is full, the frame is dropped and
+ * P_RECORDER_OVERFLOW is returned.
+ *
+ * The frames are written as frames first_frame, first_frame+1, ...;
+ * dropped frames are skipped. A frame that fails to be written counts
+ * as dropped. The buffers are laid out as those of
+ * p_write_frame_planar() (for multiplexed YUV and stream files: as
+ * y_or_s_frm and uv_frm of p_write_frame()) with the width, frm_height
+ * and strides of p_recorder_open(). The file shall exist with its
+ * header, e.g. after p_create_file(); the header is copied at open.
+ *
+ * p_recorder_get_counts() returns the number of frames written and
+ * dropped so far. When writing a frame fails, p_recorder_write()
+ * returns the status of that write. p_recorder_close() waits until all
+ * frames in the ring are written and returns the same status; then
+ * close the file with p_close_file().
+ * p_recorder_write() shall be called by one thread at a time.
+ */
+typedef struct pT_recorder_s pT_recorder;
+
+extern pT_status p_recorder_open
+        (const char *filename, const pT_header *header,
+         int first_frame,
+         int width, int frm_height, int stride, int uv_stride,
+         int num_slots, pT_recorder **recorder);
+extern pT_status p_recorder_open_16
+        (const char *filename, const pT_header *header,
+         int first_frame,
+         int write_mode,
+         int width, int frm_height, int stride, int uv_stride,
+         int num_slots, pT_recorder **recorder);
+extern pT_status p_recorder_write
+        (pT_recorder *recorder,
+         const unsigned char *y_or_r_frm,
+         const unsigned char *u_or_g_frm,
+         const unsigned char *v_or_b_frm);
+extern pT_status p_recorder_write_16
+        (pT_recorder *recorder,
+         const unsigned short *y_or_r_frm,
+         const unsigned short *u_or_g_frm,
+         const unsigned short *v_or_b_frm);
+extern void      p_recorder_get_counts
+        (pT_recorder *recorder, int *num_written, int *num_dropped);
+extern pT_status p_recorder_close (pT_recorder *recorder);
+/** @} */
+
+/** \defgroup async Asynchronous access
+ * @{
+ * The asynchronous functions start reading or writing a frame and
+ * return at once; the access is executed by the worker threads of
+ * the library (see p_set_num_threads()), so many accesses can be in
+ * flight without a blocked thread for each of them. The buffers are
+ * laid out as those of p_read_frame_planar() and
+ * p_write_frame_planar() (for multiplexed YUV and stream files: as
+ * y_or_s_frm and uv_frm of p_read_frame() and p_write_frame()); they
+ * shall remain valid until the access is done. The header is copied;
+ * for standard i/o, the file position in the header is updated, so
+ * the next access continues from it (as with p_read_frame()).
+ *
+ * On completion, callback (if not NULL) is called with the status
+ * and user_data, on a worker thread. When async is not NULL, it
+ * receives a token: p_async_done() tells whether the access is done,
+ * and p_async_wait() waits for it and returns its status. Every token
+ * shall be released by p_async_wait().
+ * The return value of the functions is the status of starting the
+ * access; when it fails, callback is not called and no token is
+ * returned.
+ *
+ * Accesses to the same file may be executed in any order.
+ * Without worker threads, and for standard i/o, the access is
+ * executed before the function returns.
+ * Do not call p_set_num_threads() from a callback.
+ */
+typedef struct pT_async_s pT_async;
+typedef void (*pT_async_callback) (pT_status status, void *user_data);
+
+extern pT_status p_read_frame_async
+        (const char *filename, pT_header *header,
+         int frame,
+         unsigned char *y_or_r_frm,
+         unsigned char *u_or_g_frm,
+         unsigned char *v_or_b_frm,
+         int read_mode,
+         int width, int frm_height, int stride, int uv_stride,
+         pT_async_callback callback, void *user_data,
+         pT_async **async);
+extern pT_status p_read_frame_async_16
+        (const char *filename, pT_header *header,
+         int frame,
+         unsigned short *y_or_r_frm,
+         unsigned short *u_or_g_frm,
+         unsigned short *v_or_b_frm,
+         int read_mode,
+         int width, int frm_height, int stride, int uv_stride,
+         pT_async_callback callback, void *user_data,
+         pT_async **async);
+extern pT_status p_write_frame_async
+        (const char *filename, pT_header *header,
+         int frame,
+         const unsigned char *y_or_r_frm,
+         const unsigned char *u_or_g_frm,
+         const unsigned char *v_or_b_frm,
+         int width, int frm_height, int stride, int uv_stride,
+         pT_async_callback callback, void *user_data,
+         pT_async **async);
+extern pT_status p_write_frame_async_16
+        (const char *filename, pT_header *header,
+         int frame,
+         const unsigned short *y_or_r_frm,
+         const unsigned short *u_or_g_frm,
+         const unsigned short *v_or_b_frm,
+         int write_mode,
+         int width, int frm_height, int stride, int uv_stride,
+         pT_async_callback callback, void *user_data,
+         pT_async **async);
+extern int       p_async_done (pT_async *async);
+extern pT_status p_async_wait (pT_async *async);
+/** @} */
+
+/** \defgroup conversion Parallel conversion
+ * @{
+ * When the data format in memory differs from the one in the file
+ * (e.g. 16 bit memory buffers for a 10 bit file), the samples of
+ * each component are converted. This takes most of the time for
+ * large images on a fast disk system. With parallel conversion
+ * enabled, the lines of a component are read with a single transfer
+ * and converted in bands of lines by the worker threads (see
+ * p_set_num_threads()); for writing, the conversion into the file
+ * format is divided in the same way.
+ * This requires a buffer for the file data of the whole component
+ * when reading. Small components are not divided.
+ * In addition, the components of a frame or field (e.g. the three
+ * planes of planar 4:4:4 or RGB files) are read or written
+ * concurrently, so that the transfer of one component overlaps with
+ * the conversion of another. Standard in/output is always accessed
+ * in order.
+ * Disabled by default; shall be set before threads start accessing
+ * files.
+ */
+extern pT_status p_set_parallel_conversion (const int enable);
+extern int       p_get_parallel_conversion (void);
+/** @} */
+
+/** \defgroup isa Conversion instruction set
+ * @{
+ * The conversion of samples (see above) uses the vector instructions
+ * of the processor. By default, the best instruction set that the
+ * processor supports is detected at the first conversion.
+ * p_set_conversion_isa() selects another one, e.g. to compare
+ * performance or results: P_ISA_NONE converts without vector
+ * instructions, P_ISA_AUTO restores the detection. It returns
+ * P_ISA_NOT_SUPPORTED when the processor does not support the
+ * instruction set, or the library is not built with it (NEON is only
+ * available when the library is built for ARM with NEON).
+ * p_get_conversion_isa() returns the instruction set in use.
+ * The results are identical for all instruction sets.
+ */
+typedef enum {
+    P_ISA_AUTO   = -1,      /**< detect at the first conversion */
+    P_ISA_NONE   = 0,       /**< no vector instructions */
+    P_ISA_SSE2   = 1,
+    P_ISA_SSSE3  = 2,
+    P_ISA_AVX2   = 3,
+    P_ISA_AVX512 = 4,       /**< AVX-512 with byte and word instructions */
+    P_ISA_NEON   = 5
+} pT_isa;
+
+extern pT_status p_set_conversion_isa (const pT_isa isa);
+extern pT_isa    p_get_conversion_isa (void);
 /** @} */
 
 /** \defgroup bufsize File buffer size
  * @{ 
  * Set or retrieve buffer size in kbytes for file access buffer.
- * Only used on win32 platform. The value 0 indicates the default. The
- * value of this default may become platform platform dependent in the
- * future. For the win32 platform we chose 256 kbyte.
+ * Only used on win32 and Linux platforms. The value 0 indicates the
+ * default of 256 kbyte.
+ * On Linux, transfers smaller than the buffer size are collected in the
+ * buffer, larger ones are done directly. The buffer size is also the
+ * block size of the P_FILE_ACCESS_URING, _THREAD and _DIRECT access modes.
+ * Since written data may remain in the buffer, a write error may be
+ * reported by a later call, at the latest by p_close_file().
  * The buffer size is effected when a file is actually opened by
  * the library. At that time, the current buffer size is used.
  * Applications may set this value at initialization. It is used when
@@ -1855,6 +2372,70 @@ extern pT_status p_set_file_buf_size (const int size_kb);
 extern int       p_get_file_buf_size (void);
 /** @} */
 
+/** \defgroup accessmode File access mode
+ * @{
+ * Set or retrieve the file access mode: a combination (bitwise or)
+ * of the P_FILE_ACCESS_* flags below. The value P_FILE_ACCESS_DEFAULT
+ * selects the normal file access.
+ * Like the buffer size, the access mode is effected when a file is
+ * actually opened by the library. At that time, the current access
+ * mode is used for that file.
+ * Flags that are not supported on a platform are ignored.
+ *
+ * P_FILE_ACCESS_MMAP: image data that needs conversion is converted
+ * straight into a memory mapping of the file, instead of via an
+ * intermediate buffer. Only effective for files that already have
+ * their final size, i.e. the number of images was specified in the
+ * header when p_write_header() was called.
+ * Note that a write error that only shows up when the data is flushed
+ * from the mapping (e.g. disk full) terminates the program with a bus
+ * error signal, since it cannot be reported as a return status.
+ *
+ * P_FILE_ACCESS_URING: asynchronous I/O with Linux io_uring.
+ * Sequential reads are read ahead and writes are written behind
+ * in blocks of the file buffer size (default 256 kbyte), with up to
+ * 16 blocks in flight. So the disk transfers overlap with the data
+ * conversion of the application.
+ * Since data is written behind, a write error may be reported by a
+ * later call than the one that wrote the data, at the latest by
+ * p_close_file(). If io_uring is not available (e.g. older kernel),
+ * the normal synchronous file access is used.
+ *
+ * P_FILE_ACCESS_DIRECT: unbuffered I/O (Linux O_DIRECT), i.e. the data
+ * bypasses the page cache of the operating system. This avoids that
+ * recording or playing long sequences evicts all other cached data.
+ * Transfers are done in aligned blocks of the file buffer size; a block
+ * that is only partially written is first completed with the data in
+ * the file. Best combined with P_FILE_ACCESS_URING, since without the
+ * cache there is no read ahead by the operating system.
+ * Ignored for file systems that do not support O_DIRECT (e.g. tmpfs).
+ * Do not combine with P_FILE_ACCESS_MMAP.
+ *
+ * P_FILE_ACCESS_THREAD: like P_FILE_ACCESS_URING, but the disk transfers
+ * are performed by a background I/O thread per open file, with 4 blocks
+ * of the file buffer size. Available on all Linux kernels. When combined
+ * with P_FILE_ACCESS_URING, the thread is only used if io_uring is not
+ * available.
+ *
+ * P_FILE_ACCESS_STREAM: for one pass through a file. The file remains
+ * buffered by the operating system, which is told that the file is read
+ * sequentially. The cached data behind the current file position is
+ * released (in ranges of 8 Mbyte), so a transcode of a long sequence does
+ * not evict the cached data of other applications. Written data is
+ * handed to the disk before it is released; so writing may wait for the
+ * disk when it is slower than the application.
+ */
+#define P_FILE_ACCESS_DEFAULT   0x0000
+#define P_FILE_ACCESS_MMAP      0x0001
+#define P_FILE_ACCESS_URING     0x0002
+#define P_FILE_ACCESS_DIRECT    0x0004
+#define P_FILE_ACCESS_THREAD    0x0008
+#define P_FILE_ACCESS_STREAM    0x0010
+
+extern pT_status p_set_file_access_mode (const int mode);
+extern int       p_get_file_access_mode (void);
+/** @} */
+
 /** \defgroup error Error handling
  * @{
  */
@@ -21,6 +21,171 @@ TEST(PFSPD, standardFileRead)
     test_func.FileRead();
     EXPECT_EQ(test_func.IsTeskOk(), true);
 }
+
+TEST(PFSPD, mapFileRead)
+{
+    test_func.FileMapRead();
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, mapFileWrite)
+{
+    test_func.FileMapWrite();
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, bufferedFileWriteRead)
+{
+    test_func.FileAccessWriteRead(P_FILE_ACCESS_DEFAULT);
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, uringFileWriteRead)
+{
+    test_func.FileAccessWriteRead(P_FILE_ACCESS_URING);
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, directFileWriteRead)
+{
+    test_func.FileAccessWriteRead(P_FILE_ACCESS_DIRECT);
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+    test_func.FileAccessWriteRead(P_FILE_ACCESS_DIRECT | P_FILE_ACCESS_URING);
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, threadFileWriteRead)
+{
+    test_func.FileAccessWriteRead(P_FILE_ACCESS_THREAD);
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+    test_func.FileAccessWriteRead(P_FILE_ACCESS_THREAD | P_FILE_ACCESS_DIRECT);
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, streamFileWriteRead)
+{
+    test_func.FileAccessWriteRead(P_FILE_ACCESS_STREAM);
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+    test_func.FileAccessWriteRead(P_FILE_ACCESS_STREAM | P_FILE_ACCESS_THREAD);
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, preallocateFile)
+{
+    test_func.FilePreallocate();
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, manyOpenFiles)
+{
+    test_func.FileManyOpen(64);
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+    test_func.FileManyOpen(4);
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, fileHandle)
+{
+    test_func.FileHandle();
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, threadFileAccess)
+{
+    test_func.FileThreads(64);
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+    test_func.FileThreads(3);
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, concurrentFileRead)
+{
+    test_func.FileConcurrentRead();
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, readFrames)
+{
+    test_func.FileReadFrames(1);
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+    test_func.FileReadFrames(0);
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, readFramesStdin)
+{
+    test_func.FileReadFramesStdin(1);
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+    test_func.FileReadFramesStdin(0);
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, parallelConversion)
+{
+    test_func.FileParallelConversion();
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, parallelComponents)
+{
+    test_func.FileParallelComponents();
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, streamRead)
+{
+    test_func.FileStreamRead();
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, recorder)
+{
+    test_func.FileRecorder();
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, asyncAccess)
+{
+    test_func.FileAsyncAccess();
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, asyncStdin)
+{
+    test_func.FileAsyncStdin();
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, context)
+{
+    test_func.FileContext();
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, convertRead)
+{
+    test_func.FileConvertRead();
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, convertWrite)
+{
+    test_func.FileConvertWrite();
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, convertIsa)
+{
+    test_func.FileConvertIsa();
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
+TEST(PFSPD, interlacedRead)
+{
+    test_func.FileInterlacedRead();
+    EXPECT_EQ(test_func.IsTeskOk(), true);
+}
+
 int main(int argc, char *argv[])
 {
     ::testing::InitGoogleTest(&argc, argv);
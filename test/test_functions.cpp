@@ -1,9 +1,14 @@
 #include <iostream>
+#include <climits>
 #include <vector>
 #include <random>
 #include <algorithm>
 #include <functional>
 #include <chrono>
+#include <thread>
+#include <atomic>
+#include <cstring>
+#include <sys/stat.h>
 
 #include "test_functions.h"
 
@@ -124,4 +129,1528 @@ void TestFunction::FileRead()
     } catch (pT_status e) {
         m_is_test_ok = false;
     }
-}
\ No newline at end of file
+}
+void TestFunction::FileMapRead()
+{
+    try {
+        for (const auto& test_file : m_test_files) {
+            pT_header header;
+            CheckFatalErrors(p_read_header(test_file.file_name.c_str(), &header));
+            int y_w, y_h, uv_w, uv_h;
+            p_get_comp_buffer_size(&header, 0, &y_w, &y_h);
+            p_get_comp_buffer_size(&header, 1, &uv_w, &uv_h);
+            for (int32_t frm = 1; frm <= header.nr_images; frm++) {
+                const unsigned char *data_y;
+                const unsigned char *data_uv;
+                int y_stride, uv_stride;
+                CheckFatalErrors(p_map_read_frame_comp(test_file.file_name.c_str(), &header, frm, 0, &data_y, &y_stride));
+                CheckFatalErrors(p_map_read_frame_comp(test_file.file_name.c_str(), &header, frm, 1, &data_uv, &uv_stride));
+                if ((y_stride != y_w) || (uv_stride != uv_w)) {
+                    std::cout<<"Stride not matched:"<<frm<<std::endl;
+                    throw P_READ_FAILED;
+                }
+
+                FrmCrc32 frm_crc32;
+                frm_crc32.comp_0 = crc32c::Crc32c(data_y, y_w * y_h);
+                frm_crc32.comp_1 = crc32c::Crc32c(data_uv, uv_w * uv_h);
+
+                if ((test_file.frm_crc32[frm-1].comp_0 != frm_crc32.comp_0) || (test_file.frm_crc32[frm-1].comp_1 != frm_crc32.comp_1)) {
+                    std::cout<<"CRC32 not matched:"<<frm<<std::endl;
+                    throw P_READ_FAILED;
+                }
+            }
+        }
+    } catch (pT_status e) {
+        m_is_test_ok = false;
+    }
+}
+void TestFunction::FileMapWrite()
+{
+    try {
+        pT_header header;
+        int w, h, stride;
+        int frm_nums      = 4;
+        std::string fname = "map_write.pfspd";
+        p_set_file_access_mode(P_FILE_ACCESS_MMAP);
+        CheckFatalErrors(p_create_ext_header(&header, P_NO_COLOR, P_60HZ, P_HDp, 0, 1, P_4_3));
+        CheckFatalErrors(p_mod_num_frames(&header, frm_nums));
+        CheckFatalErrors(p_mod_file_data_format(&header, P_10_BIT_FILE));
+        CheckFatalErrors(p_write_header(fname.c_str(), &header));
+        p_get_comp_buffer_size(&header, 0, &w, &h);
+        RBE rbe;
+        std::vector<std::vector<unsigned char>> frames;
+        for (int32_t frm = 1; frm <= frm_nums; frm++) {
+            std::vector<unsigned char> data(w * h);
+            std::generate(begin(data), end(data), std::ref(rbe));
+            if (frm % 2) {
+                /* converted straight into the file mapping */
+                CheckFatalErrors(p_write_frame_comp(fname.c_str(), &header, frm, 0, data.data(), w, h, w));
+            } else {
+                /* rendered directly into the file */
+                unsigned short *dst;
+                CheckFatalErrors(p_map_write_frame_comp_16(fname.c_str(), &header, frm, 0, &dst, &stride));
+                for (int y = 0; y < h; y++) {
+                    for (int x = 0; x < w; x++) {
+                        dst[y * stride + x] = (unsigned short)(data[y * w + x] << 2);
+                    }
+                }
+            }
+            frames.push_back(data);
+        }
+        p_set_file_access_mode(P_FILE_ACCESS_DEFAULT);
+        CheckFatalErrors(p_close_file(fname.c_str()));
+
+        CheckFatalErrors(p_read_header(fname.c_str(), &header));
+        for (int32_t frm = 1; frm <= header.nr_images; frm++) {
+            std::vector<unsigned char> data(w * h);
+            CheckFatalErrors(p_read_frame_comp(fname.c_str(), &header, frm, 0, data.data(), P_8_BIT_MEM, w, h, w));
+            if (data != frames[frm - 1]) {
+                std::cout<<"Data not matched:"<<frm<<std::endl;
+                throw P_READ_FAILED;
+            }
+        }
+        if (header.nr_images != frm_nums) {
+            throw P_READ_FAILED;
+        }
+    } catch (pT_status e) {
+        m_is_test_ok = false;
+    }
+}
+void TestFunction::FileAccessWriteRead(int access_mode)
+{
+    try {
+        pT_header header;
+        int w, h;
+        int frm_nums      = 8;
+        std::string fname = "access_" + std::to_string(access_mode) + ".pfspd";
+        /* small blocks, so a frame spans multiple blocks in flight */
+        p_set_file_buf_size(64);
+        p_set_file_access_mode(access_mode);
+        CheckFatalErrors(p_create_ext_header(&header, P_NO_COLOR, P_60HZ, P_HDp, 0, 1, P_4_3));
+        CheckFatalErrors(p_mod_file_data_format(&header, P_10_BIT_FILE));
+        CheckFatalErrors(p_write_header(fname.c_str(), &header));
+        p_get_comp_buffer_size(&header, 0, &w, &h);
+        RBE rbe;
+        std::vector<std::vector<unsigned char>> frames;
+        for (int32_t frm = 1; frm <= frm_nums; frm++) {
+            std::vector<unsigned char> data(w * h);
+            std::generate(begin(data), end(data), std::ref(rbe));
+            CheckFatalErrors(p_write_frame_comp(fname.c_str(), &header, frm, 0, data.data(), w, h, w));
+            frames.push_back(data);
+        }
+        CheckFatalErrors(p_close_file(fname.c_str()));
+
+        CheckFatalErrors(p_read_header(fname.c_str(), &header));
+        if (header.nr_images != frm_nums) {
+            throw P_READ_FAILED;
+        }
+        /* sequential read ahead, followed by random access */
+        std::vector<int32_t> order;
+        for (int32_t frm = 1; frm <= frm_nums; frm++) {
+            order.push_back(frm);
+        }
+        order.push_back(3);
+        order.push_back(1);
+        order.push_back(frm_nums);
+        for (int32_t frm : order) {
+            std::vector<unsigned char> data(w * h);
+            CheckFatalErrors(p_read_frame_comp(fname.c_str(), &header, frm, 0, data.data(), P_8_BIT_MEM, w, h, w));
+            if (data != frames[frm - 1]) {
+                std::cout<<"Data not matched:"<<frm<<std::endl;
+                throw P_READ_FAILED;
+            }
+        }
+        CheckFatalErrors(p_close_file(fname.c_str()));
+        p_set_file_access_mode(P_FILE_ACCESS_DEFAULT);
+        p_set_file_buf_size(0);
+    } catch (pT_status e) {
+        p_set_file_access_mode(P_FILE_ACCESS_DEFAULT);
+        p_set_file_buf_size(0);
+        m_is_test_ok = false;
+    }
+}
+
+void TestFunction::FilePreallocate()
+{
+    try {
+        pT_header header;
+        struct stat st;
+        int w, h;
+        int frm_nums      = 8;
+        int frm_written   = 3;
+        std::string fname = "prealloc.pfspd";
+        CheckFatalErrors(p_create_ext_header(&header, P_NO_COLOR, P_60HZ, P_HDp, 0, 1, P_4_3));
+        CheckFatalErrors(p_mod_num_frames(&header, frm_nums));
+        CheckFatalErrors(p_write_header(fname.c_str(), &header));
+        p_get_comp_buffer_size(&header, 0, &w, &h);
+        /* disk space for all frames is allocated at once */
+        if (stat(fname.c_str(), &st) != 0) {
+            throw P_FILE_CREATE_FAILED;
+        }
+        int64_t size_planned = st.st_size;
+#ifdef __linux__
+        if ((int64_t)st.st_blocks * 512 < size_planned) {
+            std::cout<<"File is sparse"<<std::endl;
+            throw P_WRITE_FAILED;
+        }
+#endif
+        std::vector<unsigned char> data(w * h);
+        for (int32_t frm = 1; frm <= frm_written; frm++) {
+            CheckFatalErrors(p_write_frame_comp(fname.c_str(), &header, frm, 0, data.data(), w, h, w));
+        }
+        CheckFatalErrors(p_close_file(fname.c_str()));
+        /* unused space is released at close */
+        if (stat(fname.c_str(), &st) != 0) {
+            throw P_FILE_OPEN_FAILED;
+        }
+        if (size_planned - st.st_size != (int64_t)(frm_nums - frm_written) * w * h) {
+            std::cout<<"File not truncated: "<<st.st_size<<std::endl;
+            throw P_WRITE_FAILED;
+        }
+    } catch (pT_status e) {
+        m_is_test_ok = false;
+    }
+}
+
+void TestFunction::FileManyOpen(int max_files)
+{
+    try {
+        int num_files     = 24;
+        int frm_nums      = 3;
+        int w, h;
+        std::vector<std::string> fnames;
+        std::vector<pT_header> headers(num_files);
+        CheckFatalErrors(p_set_max_open_files(max_files));
+        if (p_get_max_open_files() != max_files) {
+            throw P_ILLEGAL_MAX_OPEN_FILES;
+        }
+        for (int i = 0; i < num_files; i++) {
+            fnames.push_back("many_" + std::to_string(i) + ".pfspd");
+            CheckFatalErrors(p_create_ext_header(&headers[i], P_NO_COLOR, P_50HZ, P_QCIF, 0, 1, P_4_3));
+            CheckFatalErrors(p_write_header(fnames[i].c_str(), &headers[i]));
+        }
+        p_get_comp_buffer_size(&headers[0], 0, &w, &h);
+        /* access the files alternately, frame by frame */
+        std::vector<unsigned char> data(w * h);
+        for (int32_t frm = 1; frm <= frm_nums; frm++) {
+            for (int i = 0; i < num_files; i++) {
+                std::fill(begin(data), end(data), (unsigned char)(i * 8 + frm));
+                CheckFatalErrors(p_write_frame_comp(fnames[i].c_str(), &headers[i], frm, 0, data.data(), w, h, w));
+            }
+        }
+        for (int i = 0; i < num_files; i++) {
+            CheckFatalErrors(p_close_file(fnames[i].c_str()));
+        }
+        for (int32_t frm = 1; frm <= frm_nums; frm++) {
+            for (int i = 0; i < num_files; i++) {
+                pT_header header;
+                CheckFatalErrors(p_read_header(fnames[i].c_str(), &header));
+                if (header.nr_images != frm_nums) {
+                    throw P_READ_FAILED;
+                }
+                CheckFatalErrors(p_read_frame_comp(fnames[i].c_str(), &header, frm, 0, data.data(), P_8_BIT_MEM, w, h, w));
+                if (std::count(begin(data), end(data), (unsigned char)(i * 8 + frm)) != (long)data.size()) {
+                    std::cout<<"Data not matched: "<<fnames[i]<<" "<<frm<<std::endl;
+                    throw P_READ_FAILED;
+                }
+            }
+        }
+        CheckFatalErrors(p_close_file(NULL));
+        CheckFatalErrors(p_set_max_open_files(10));
+    } catch (pT_status e) {
+        p_set_max_open_files(10);
+        m_is_test_ok = false;
+    }
+}
+
+void TestFunction::FileHandle()
+{
+    std::vector<pT_file *> files;
+    try {
+        int num_handles   = 3;
+        int num_names     = 4;
+        int frm_nums      = 4;
+        int w, h;
+        std::vector<std::string> fnames;
+        pT_header header;
+        /* fewer records than files: the named files are closed implicitly */
+        CheckFatalErrors(p_set_max_open_files(num_handles + 1));
+        CheckFatalErrors(p_create_ext_header(&header, P_NO_COLOR, P_50HZ, P_QCIF, 0, 1, P_4_3));
+        for (int i = 0; i < num_handles + num_names; i++) {
+            fnames.push_back("handle_" + std::to_string(i) + ".pfspd");
+            CheckFatalErrors(p_write_header(fnames[i].c_str(), &header));
+        }
+        p_get_comp_buffer_size(&header, 0, &w, &h);
+        for (int i = 0; i < num_handles; i++) {
+            files.push_back(NULL);
+            CheckFatalErrors(p_file_open(fnames[i].c_str(), 1, &files[i]));
+        }
+        std::vector<unsigned char> data(w * h);
+        for (int32_t frm = 1; frm <= frm_nums; frm++) {
+            for (int i = 0; i < num_handles + num_names; i++) {
+                std::fill(begin(data), end(data), (unsigned char)(i * 8 + frm));
+                if (i < num_handles) {
+                    CheckFatalErrors(p_file_write_frame_comp(files[i], frm, 0, data.data(), w, h, w));
+                } else {
+                    CheckFatalErrors(p_write_frame_comp(fnames[i].c_str(), &header, frm, 0, data.data(), w, h, w));
+                }
+            }
+        }
+        for (int i = 0; i < num_handles; i++) {
+            CheckFatalErrors(p_file_close(files[i]));
+            files[i] = NULL;
+        }
+        CheckFatalErrors(p_close_file(NULL));
+        for (int i = 0; i < num_handles + num_names; i++) {
+            pT_file *file = NULL;
+            CheckFatalErrors(p_file_open(fnames[i].c_str(), 0, &file));
+            files[i % num_handles] = file;
+            if (p_get_num_frames(p_file_get_header(file)) != frm_nums) {
+                throw P_READ_FAILED;
+            }
+            for (int32_t frm = frm_nums; frm >= 1; frm--) {
+                CheckFatalErrors(p_file_read_frame_comp(file, frm, 0, data.data(), P_8_BIT_MEM, w, h, w));
+                if (std::count(begin(data), end(data), (unsigned char)(i * 8 + frm)) != (long)data.size()) {
+                    std::cout<<"Data not matched: "<<fnames[i]<<" "<<frm<<std::endl;
+                    throw P_READ_FAILED;
+                }
+            }
+            /* no write access via a read handle */
+            if (p_file_write_frame_comp(file, 1, 0, data.data(), w, h, w) == P_OK) {
+                throw P_WRITE_FAILED;
+            }
+            /* closing the file by name invalidates the handle */
+            CheckFatalErrors(p_close_file(fnames[i].c_str()));
+            if (p_file_read_frame_comp(file, 1, 0, data.data(), P_8_BIT_MEM, w, h, w) != P_FILE_HANDLE_CLOSED) {
+                throw P_READ_FAILED;
+            }
+            CheckFatalErrors(p_file_close(file));
+            files[i % num_handles] = NULL;
+        }
+        CheckFatalErrors(p_set_max_open_files(10));
+    } catch (pT_status e) {
+        for (size_t i = 0; i < files.size(); i++) {
+            p_file_close(files[i]);
+        }
+        p_set_max_open_files(10);
+        m_is_test_ok = false;
+    }
+}
+
+void TestFunction::FileThreads(int max_files)
+{
+    try {
+        int num_threads   = 8;
+        int frm_nums      = 6;
+        int w, h;
+        pT_header header;
+        std::atomic<int> errors(0);
+        std::string shared = "thread_shared.pfspd";
+        CheckFatalErrors(p_set_max_open_files(max_files));
+        CheckFatalErrors(p_create_ext_header(&header, P_NO_COLOR, P_50HZ, P_QCIF, 0, 1, P_4_3));
+        CheckFatalErrors(p_mod_num_frames(&header, frm_nums));
+        p_get_comp_buffer_size(&header, 0, &w, &h);
+        /* a file read by all threads */
+        std::vector<unsigned char> data(w * h);
+        CheckFatalErrors(p_write_header(shared.c_str(), &header));
+        for (int32_t frm = 1; frm <= frm_nums; frm++) {
+            std::fill(begin(data), end(data), (unsigned char)frm);
+            CheckFatalErrors(p_write_frame_comp(shared.c_str(), &header, frm, 0, data.data(), w, h, w));
+        }
+        CheckFatalErrors(p_close_file(shared.c_str()));
+        /* each thread writes its own file, then reads it back */
+        auto worker = [&](int t) {
+            std::string fname = "thread_" + std::to_string(t) + ".pfspd";
+            pT_header own = header;
+            pT_header shared_header;
+            std::vector<unsigned char> buf(w * h);
+            pT_status status = p_write_header(fname.c_str(), &own);
+            for (int32_t frm = 1; (frm <= frm_nums) && (status == P_OK); frm++) {
+                std::fill(begin(buf), end(buf), (unsigned char)(t * 16 + frm));
+                status = p_write_frame_comp(fname.c_str(), &own, frm, 0, buf.data(), w, h, w);
+                if (status == P_OK) {
+                    status = p_read_header(shared.c_str(), &shared_header);
+                }
+                if (status == P_OK) {
+                    status = p_read_frame_comp(shared.c_str(), &shared_header, frm, 0, buf.data(), P_8_BIT_MEM, w, h, w);
+                }
+                if ((status == P_OK) && (std::count(begin(buf), end(buf), (unsigned char)frm) != (long)buf.size())) {
+                    status = P_READ_FAILED;
+                }
+            }
+            if (status == P_OK) {
+                status = p_read_header(fname.c_str(), &own);
+            }
+            for (int32_t frm = 1; (frm <= frm_nums) && (status == P_OK); frm++) {
+                status = p_read_frame_comp(fname.c_str(), &own, frm, 0, buf.data(), P_8_BIT_MEM, w, h, w);
+                if ((status == P_OK) && (std::count(begin(buf), end(buf), (unsigned char)(t * 16 + frm)) != (long)buf.size())) {
+                    status = P_READ_FAILED;
+                }
+            }
+            if (status != P_OK) {
+                fprintf(stderr, "Thread %d: %s\n", t, p_get_error_string(status));
+                errors++;
+            }
+        };
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; t++) {
+            threads.emplace_back(worker, t);
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        CheckFatalErrors(p_close_file(NULL));
+        CheckFatalErrors(p_set_max_open_files(10));
+        if (errors != 0) {
+            throw P_READ_FAILED;
+        }
+    } catch (pT_status e) {
+        p_set_max_open_files(10);
+        m_is_test_ok = false;
+    }
+}
+
+void TestFunction::FileConcurrentRead()
+{
+    pT_file *file = NULL;
+    try {
+        int num_threads   = 8;
+        int frm_nums      = 16;
+        int w, h;
+        pT_header header;
+        std::atomic<int> errors(0);
+        std::string fname = "concurrent.pfspd";
+        CheckFatalErrors(p_create_ext_header(&header, P_NO_COLOR, P_50HZ, P_QCIF, 0, 1, P_4_3));
+        CheckFatalErrors(p_mod_num_frames(&header, frm_nums));
+        p_get_comp_buffer_size(&header, 0, &w, &h);
+        std::vector<unsigned char> data(w * h);
+        CheckFatalErrors(p_write_header(fname.c_str(), &header));
+        for (int32_t frm = 1; frm <= frm_nums; frm++) {
+            std::fill(begin(data), end(data), (unsigned char)frm);
+            CheckFatalErrors(p_write_frame_comp(fname.c_str(), &header, frm, 0, data.data(), w, h, w));
+        }
+        CheckFatalErrors(p_close_file(fname.c_str()));
+        /* all threads share one header and one handle */
+        CheckFatalErrors(p_read_header(fname.c_str(), &header));
+        CheckFatalErrors(p_file_open(fname.c_str(), 0, &file));
+        pT_header before = header;
+        auto worker = [&](int t) {
+            std::vector<unsigned char> buf(w * h);
+            std::vector<unsigned short> buf16(w * 2 * h);
+            pT_status status = P_OK;
+            for (int i = 0; (i < frm_nums) && (status == P_OK); i++) {
+                int32_t frm = 1 + (t + i) % frm_nums;
+                if (t % 2) {
+                    status = p_file_read_frame_comp(file, frm, 0, buf.data(), P_8_BIT_MEM, w, h, w);
+                } else {
+                    status = p_read_frame_comp(fname.c_str(), &header, frm, 0, buf.data(), P_8_BIT_MEM, w, h, w);
+                }
+                if ((status == P_OK) && (std::count(begin(buf), end(buf), (unsigned char)frm) != (long)buf.size())) {
+                    status = P_READ_FAILED;
+                }
+                /* line by line, with conversion */
+                if (status == P_OK) {
+                    status = p_read_frame_comp_16(fname.c_str(), &header, frm, 0, buf16.data(), P_16_BIT_MEM, w, h, w * 2);
+                }
+                for (int y = 0; (y < h) && (status == P_OK); y++) {
+                    if (std::count(buf16.begin() + y * w * 2, buf16.begin() + y * w * 2 + w,
+                                   (unsigned short)(frm << 8)) != w) {
+                        status = P_READ_FAILED;
+                    }
+                }
+            }
+            if (status != P_OK) {
+                fprintf(stderr, "Thread %d: %s\n", t, p_get_error_string(status));
+                errors++;
+            }
+        };
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; t++) {
+            threads.emplace_back(worker, t);
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        CheckFatalErrors(p_file_close(file));
+        file = NULL;
+        CheckFatalErrors(p_close_file(NULL));
+        if (errors != 0) {
+            throw P_READ_FAILED;
+        }
+        /* reading did not modify the header */
+        if (memcmp(&before, &header, sizeof(header)) != 0) {
+            throw P_READ_FAILED;
+        }
+    } catch (pT_status e) {
+        p_file_close(file);
+        m_is_test_ok = false;
+    }
+}
+
+void TestFunction::FileReadFrames(int progressive)
+{
+    try {
+        int frm_nums      = 24;
+        int y_w, y_h, uv_w, uv_h;
+        pT_header header;
+        std::string fname = "frames_" + std::to_string(progressive) + ".pfspd";
+        CheckFatalErrors(p_create_ext_header(&header, P_COLOR_420_PL, P_50HZ, P_QCIF, 0, progressive, P_4_3));
+        CheckFatalErrors(p_mod_num_frames(&header, frm_nums));
+        p_get_y_buffer_size(&header, &y_w, &y_h);
+        p_get_uv_buffer_size(&header, &uv_w, &uv_h);
+        if (!progressive) {
+            /* field sizes */
+            y_h  *= 2;
+            uv_h *= 2;
+        }
+        const int w[3] = {y_w, uv_w, uv_w};
+        const int h[3] = {y_h, uv_h, uv_h};
+        /* every line has its own value */
+        auto value = [](int frm, int comp, int line) { return (unsigned char)(frm * 5 + comp * 80 + line); };
+        std::vector<unsigned char> data[3];
+        CheckFatalErrors(p_write_header(fname.c_str(), &header));
+        for (int32_t frm = 1; frm <= frm_nums; frm++) {
+            for (int c = 0; c < 3; c++) {
+                data[c].resize(w[c] * h[c]);
+                for (int y = 0; y < h[c]; y++) {
+                    std::fill(data[c].begin() + y * w[c], data[c].begin() + (y + 1) * w[c], value(frm, c, y));
+                }
+            }
+            if (progressive) {
+                CheckFatalErrors(p_write_frame_planar(fname.c_str(), &header, frm, data[0].data(), data[1].data(), data[2].data(),
+                                                      y_w, y_h, y_w, uv_w));
+            } else {
+                /* write field by field: lines 2*y+field-1 of the frame */
+                for (int field = 1; field <= 2; field++) {
+                    std::vector<unsigned char> fld[3];
+                    for (int c = 0; c < 3; c++) {
+                        for (int y = field - 1; y < h[c]; y += 2) {
+                            fld[c].insert(fld[c].end(), data[c].begin() + y * w[c], data[c].begin() + (y + 1) * w[c]);
+                        }
+                    }
+                    CheckFatalErrors(p_write_field_planar(fname.c_str(), &header, frm, field, fld[0].data(), fld[1].data(), fld[2].data(),
+                                                          y_w, y_h / 2, y_w, uv_w));
+                }
+            }
+        }
+        CheckFatalErrors(p_close_file(fname.c_str()));
+        CheckFatalErrors(p_read_header(fname.c_str(), &header));
+        pT_header before = header;
+
+        /* a range, and a list with runs, gaps and repeats */
+        std::vector<int> list = {3, 4, 5, 6, 9, 1, 2, 24, 24, 12, 13};
+        for (int threads : {1, 4}) {
+            CheckFatalErrors(p_set_num_threads(threads));
+            for (int use_list = 0; use_list < 2; use_list++) {
+                int num = use_list ? (int)list.size() : frm_nums - 2;
+                std::vector<std::vector<unsigned char>> bufs[3];
+                std::vector<std::vector<unsigned short>> bufs_16(num, std::vector<unsigned short>(y_w * y_h));
+                std::vector<unsigned char *> ptrs[3];
+                std::vector<unsigned short *> ptrs_16;
+                for (int c = 0; c < 3; c++) {
+                    bufs[c].assign(num, std::vector<unsigned char>(w[c] * h[c]));
+                    for (int i = 0; i < num; i++) {
+                        ptrs[c].push_back(bufs[c][i].data());
+                    }
+                }
+                for (int i = 0; i < num; i++) {
+                    ptrs_16.push_back(bufs_16[i].data());
+                }
+                CheckFatalErrors(p_read_frames(fname.c_str(), &header, 3, num, use_list ? list.data() : NULL,
+                                               ptrs[0].data(), ptrs[1].data(), ptrs[2].data(),
+                                               P_READ_ALL, y_w, y_h, y_w, uv_w));
+                /* luminance only, with conversion */
+                CheckFatalErrors(p_read_frames_16(fname.c_str(), &header, 3, num, use_list ? list.data() : NULL,
+                                                  ptrs_16.data(), NULL, NULL,
+                                                  P_READ_Y | P_16_BIT_MEM, y_w, y_h, y_w, 0));
+                for (int i = 0; i < num; i++) {
+                    int frm = use_list ? list[i] : 3 + i;
+                    for (int c = 0; c < 3; c++) {
+                        for (int y = 0; y < h[c]; y++) {
+                            if (std::count(bufs[c][i].begin() + y * w[c], bufs[c][i].begin() + (y + 1) * w[c],
+                                           value(frm, c, y)) != w[c]) {
+                                std::cout<<"Data not matched: frame "<<frm<<" comp "<<c<<" line "<<y<<std::endl;
+                                throw P_READ_FAILED;
+                            }
+                        }
+                    }
+                    for (int y = 0; y < y_h; y++) {
+                        if (std::count(bufs_16[i].begin() + y * y_w, bufs_16[i].begin() + (y + 1) * y_w,
+                                       (unsigned short)(value(frm, 0, y) << 8)) != y_w) {
+                            std::cout<<"Data not matched: frame "<<frm<<" line "<<y<<" (16 bit)"<<std::endl;
+                            throw P_READ_FAILED;
+                        }
+                    }
+                }
+            }
+        }
+        /* a frame beyond the end of the file fails, the others are read */
+        std::vector<int> beyond = {frm_nums, frm_nums + 1};
+        std::vector<unsigned char> last(y_w * y_h);
+        std::vector<unsigned char> dummy(y_w * y_h);
+        unsigned char *ptrs[2] = {last.data(), dummy.data()};
+        if (p_read_frames(fname.c_str(), &header, 0, 2, beyond.data(), ptrs, NULL, NULL,
+                          P_READ_Y, y_w, y_h, y_w, 0) == P_OK) {
+            throw P_READ_FAILED;
+        }
+        if (last[0] != value(frm_nums, 0, 0)) {
+            throw P_READ_FAILED;
+        }
+        /* reading did not modify the header */
+        if (memcmp(&before, &header, sizeof(header)) != 0) {
+            throw P_READ_FAILED;
+        }
+        CheckFatalErrors(p_close_file(NULL));
+        CheckFatalErrors(p_set_num_threads(0));
+    } catch (pT_status e) {
+        p_set_num_threads(0);
+        m_is_test_ok = false;
+    }
+}
+
+void TestFunction::FileReadFramesStdin(int progressive)
+{
+    try {
+        int frm_nums      = 24;
+        int w, h;
+        pT_header header;
+        std::string fname = "frames_stdin_" + std::to_string(progressive) + ".pfspd";
+        CheckFatalErrors(p_create_ext_header(&header, P_NO_COLOR, P_50HZ, P_QCIF, 0, progressive, P_4_3));
+        CheckFatalErrors(p_mod_num_frames(&header, frm_nums));
+        p_get_y_buffer_size(&header, &w, &h);
+        if (!progressive) {
+            /* frame size */
+            h *= 2;
+        }
+        /* every line has its own value */
+        auto value = [](int frm, int line) { return (unsigned char)(frm * 5 + line); };
+        std::vector<unsigned char> data(w * h);
+        CheckFatalErrors(p_write_header(fname.c_str(), &header));
+        for (int32_t frm = 1; frm <= frm_nums; frm++) {
+            for (int y = 0; y < h; y++) {
+                std::fill(data.begin() + y * w, data.begin() + (y + 1) * w, value(frm, y));
+            }
+            if (progressive) {
+                CheckFatalErrors(p_write_frame_comp(fname.c_str(), &header, frm, 0, data.data(), w, h, w));
+            } else {
+                /* write field by field: lines 2*y+field-1 of the frame */
+                for (int field = 1; field <= 2; field++) {
+                    std::vector<unsigned char> fld;
+                    for (int y = field - 1; y < h; y += 2) {
+                        fld.insert(fld.end(), data.begin() + y * w, data.begin() + (y + 1) * w);
+                    }
+                    CheckFatalErrors(p_write_field_comp(fname.c_str(), &header, frm, field, 0,
+                                                        fld.data(), w, h / 2, w));
+                }
+            }
+        }
+        CheckFatalErrors(p_close_file(fname.c_str()));
+
+        /* read the file from standard input, by several tasks */
+        if (freopen(fname.c_str(), "rb", stdin) == NULL) {
+            throw P_FILE_OPEN_FAILED;
+        }
+        CheckFatalErrors(p_set_num_threads(4));
+        CheckFatalErrors(p_read_header("-", &header));
+        /* two calls: the second one continues where the first one ended */
+        const int first[2] = {3, frm_nums - 1};
+        const int num[2]   = {frm_nums - 4, 2};
+        for (int call = 0; call < 2; call++) {
+            std::vector<std::vector<unsigned char>> bufs(num[call], std::vector<unsigned char>(w * h));
+            std::vector<unsigned char *> ptrs;
+            for (int i = 0; i < num[call]; i++) {
+                ptrs.push_back(bufs[i].data());
+            }
+            CheckFatalErrors(p_read_frames("-", &header, first[call], num[call], NULL, ptrs.data(), NULL, NULL,
+                                           P_READ_Y, w, h, w, 0));
+            for (int i = 0; i < num[call]; i++) {
+                for (int y = 0; y < h; y++) {
+                    if (std::count(bufs[i].begin() + y * w, bufs[i].begin() + (y + 1) * w,
+                                   value(first[call] + i, y)) != w) {
+                        std::cout<<"Data not matched: frame "<<first[call] + i<<" line "<<y<<std::endl;
+                        throw P_READ_FAILED;
+                    }
+                }
+            }
+        }
+        CheckFatalErrors(p_set_num_threads(0));
+    } catch (pT_status e) {
+        p_set_num_threads(0);
+        m_is_test_ok = false;
+    }
+}
+
+void TestFunction::FileParallelConversion()
+{
+    try {
+        pT_header header;
+        int w, h;
+        int frm_nums      = 4;
+        std::string fname = "conversion.pfspd";
+        CheckFatalErrors(p_set_num_threads(4));
+        CheckFatalErrors(p_set_parallel_conversion(1));
+        CheckFatalErrors(p_create_ext_header(&header, P_NO_COLOR, P_60HZ, P_HDp, 0, 1, P_4_3));
+        CheckFatalErrors(p_mod_file_data_format(&header, P_10_BIT_FILE));
+        CheckFatalErrors(p_write_header(fname.c_str(), &header));
+        p_get_comp_buffer_size(&header, 0, &w, &h);
+        RBE rbe;
+        std::vector<std::vector<unsigned short>> frames;
+        for (int32_t frm = 1; frm <= frm_nums; frm++) {
+            std::vector<unsigned short> data(w * h);
+            for (auto &sample : data) {
+                sample = (unsigned short)((rbe() << 2 | rbe() >> 6) & 0x03ff);
+            }
+            CheckFatalErrors(p_write_frame_comp_16(fname.c_str(), &header, frm, 0, data.data(), P_10_BIT_MEM, w, h, w));
+            frames.push_back(data);
+        }
+        CheckFatalErrors(p_close_file(fname.c_str()));
+        CheckFatalErrors(p_read_header(fname.c_str(), &header));
+
+        /* parallel and single threaded conversion give the same result */
+        for (int parallel = 1; parallel >= 0; parallel--) {
+            CheckFatalErrors(p_set_parallel_conversion(parallel));
+            for (int32_t frm = 1; frm <= frm_nums; frm++) {
+                /* 16 bit, with a stride larger than the width */
+                std::vector<unsigned short> data(w * 2 * h);
+                CheckFatalErrors(p_read_frame_comp_16(fname.c_str(), &header, frm, 0, data.data(), P_10_BIT_MEM, w, h, w * 2));
+                for (int y = 0; y < h; y++) {
+                    if (!std::equal(data.begin() + y * w * 2, data.begin() + y * w * 2 + w, frames[frm - 1].begin() + y * w)) {
+                        std::cout<<"Data not matched: frame "<<frm<<" line "<<y<<std::endl;
+                        throw P_READ_FAILED;
+                    }
+                }
+                /* 8 bit */
+                std::vector<unsigned char> data_8(w * h);
+                CheckFatalErrors(p_read_frame_comp(fname.c_str(), &header, frm, 0, data_8.data(), P_8_BIT_MEM, w, h, w));
+                for (int i = 0; i < w * h; i++) {
+                    if (data_8[i] != (unsigned char)(frames[frm - 1][i] >> 2)) {
+                        std::cout<<"Data not matched: frame "<<frm<<" sample "<<i<<" (8 bit)"<<std::endl;
+                        throw P_READ_FAILED;
+                    }
+                }
+            }
+        }
+        /* converting in bands while reading frames in parallel */
+        CheckFatalErrors(p_set_parallel_conversion(1));
+        std::vector<std::vector<unsigned short>> bufs(frm_nums, std::vector<unsigned short>(w * h));
+        std::vector<unsigned short *> ptrs;
+        for (int i = 0; i < frm_nums; i++) {
+            ptrs.push_back(bufs[i].data());
+        }
+        CheckFatalErrors(p_read_frames_16(fname.c_str(), &header, 1, frm_nums, NULL, ptrs.data(), NULL, NULL,
+                                          P_READ_Y | P_10_BIT_MEM, w, h, w, 0));
+        if (bufs != frames) {
+            throw P_READ_FAILED;
+        }
+        CheckFatalErrors(p_close_file(fname.c_str()));
+        CheckFatalErrors(p_set_parallel_conversion(0));
+        CheckFatalErrors(p_set_num_threads(0));
+    } catch (pT_status e) {
+        p_set_parallel_conversion(0);
+        p_set_num_threads(0);
+        m_is_test_ok = false;
+    }
+}
+
+void TestFunction::FileParallelComponents()
+{
+    try {
+        pT_header header;
+        int w, h;
+        int frm_nums      = 3;
+        std::string fname = "components.pfspd";
+        CheckFatalErrors(p_set_num_threads(4));
+        CheckFatalErrors(p_set_parallel_conversion(1));
+        CheckFatalErrors(p_create_ext_header(&header, P_COLOR_444_PL, P_60HZ, P_HDp, 0, 1, P_4_3));
+        CheckFatalErrors(p_mod_file_data_format(&header, P_10_BIT_FILE));
+        CheckFatalErrors(p_write_header(fname.c_str(), &header));
+        p_get_comp_buffer_size(&header, 0, &w, &h);
+        RBE rbe;
+        /* the three planes of each frame, written concurrently */
+        std::vector<std::vector<std::vector<unsigned short>>> frames;
+        for (int32_t frm = 1; frm <= frm_nums; frm++) {
+            std::vector<std::vector<unsigned short>> planes(3, std::vector<unsigned short>(w * h));
+            for (auto &plane : planes) {
+                for (auto &sample : plane) {
+                    sample = (unsigned short)((rbe() << 2 | rbe() >> 6) & 0x03ff);
+                }
+            }
+            CheckFatalErrors(p_write_frame_planar_16(fname.c_str(), &header, frm, planes[0].data(), planes[1].data(), planes[2].data(),
+                                                     P_10_BIT_MEM, w, h, w, w));
+            frames.push_back(planes);
+        }
+        CheckFatalErrors(p_close_file(fname.c_str()));
+        CheckFatalErrors(p_read_header(fname.c_str(), &header));
+
+        /* concurrent and sequential component reads give the same result */
+        for (int parallel = 1; parallel >= 0; parallel--) {
+            CheckFatalErrors(p_set_parallel_conversion(parallel));
+            for (int32_t frm = frm_nums; frm >= 1; frm--) {
+                std::vector<std::vector<unsigned short>> planes(3, std::vector<unsigned short>(w * h));
+                CheckFatalErrors(p_read_frame_planar_16(fname.c_str(), &header, frm, planes[0].data(), planes[1].data(), planes[2].data(),
+                                                        P_READ_ALL | P_10_BIT_MEM, w, h, w, w));
+                if (planes != frames[frm - 1]) {
+                    std::cout<<"Data not matched: frame "<<frm<<std::endl;
+                    throw P_READ_FAILED;
+                }
+            }
+        }
+        CheckFatalErrors(p_close_file(fname.c_str()));
+        CheckFatalErrors(p_set_num_threads(0));
+    } catch (pT_status e) {
+        p_set_parallel_conversion(0);
+        p_set_num_threads(0);
+        m_is_test_ok = false;
+    }
+}
+
+void TestFunction::FileStreamRead()
+{
+    try {
+        int frm_nums      = 16;
+        int y_w, y_h, uv_w, uv_h;
+        pT_header header;
+        std::string fname = "stream.pfspd";
+        CheckFatalErrors(p_create_ext_header(&header, P_COLOR_420_PL, P_50HZ, P_QCIF, 0, 1, P_4_3));
+        p_get_y_buffer_size(&header, &y_w, &y_h);
+        p_get_uv_buffer_size(&header, &uv_w, &uv_h);
+        const int w[3] = {y_w, uv_w, uv_w};
+        const int h[3] = {y_h, uv_h, uv_h};
+        /* every line has its own value */
+        auto value = [](int frm, int comp, int line) { return (unsigned char)(frm * 7 + comp * 60 + line); };
+        CheckFatalErrors(p_write_header(fname.c_str(), &header));
+        for (int32_t frm = 1; frm <= frm_nums; frm++) {
+            std::vector<unsigned char> data[3];
+            for (int c = 0; c < 3; c++) {
+                data[c].resize(w[c] * h[c]);
+                for (int y = 0; y < h[c]; y++) {
+                    std::fill(data[c].begin() + y * w[c], data[c].begin() + (y + 1) * w[c], value(frm, c, y));
+                }
+            }
+            CheckFatalErrors(p_write_frame_planar(fname.c_str(), &header, frm, data[0].data(), data[1].data(), data[2].data(),
+                                                  y_w, y_h, y_w, uv_w));
+        }
+        CheckFatalErrors(p_close_file(fname.c_str()));
+        CheckFatalErrors(p_read_header(fname.c_str(), &header));
+
+        /* 16 bit frames with conversion, strides larger than the widths */
+        pT_stream *stream;
+        CheckFatalErrors(p_stream_open_16(fname.c_str(), &header, 2, frm_nums - 1, P_READ_ALL | P_16_BIT_MEM,
+                                          y_w, y_h, y_w + 8, uv_w + 4, 3, &stream));
+        int expected = 2;
+        for (;;) {
+            int frm;
+            unsigned short *bufs[3];
+            CheckFatalErrors(p_stream_next_16(stream, &frm, &bufs[0], &bufs[1], &bufs[2]));
+            if (frm == 0) {
+                break;
+            }
+            if (frm != expected++) {
+                throw P_READ_FAILED;
+            }
+            for (int c = 0; c < 3; c++) {
+                const int stride = (c == 0) ? y_w + 8 : uv_w + 4;
+                for (int y = 0; y < h[c]; y++) {
+                    if (std::count(bufs[c] + y * stride, bufs[c] + y * stride + w[c],
+                                   (unsigned short)(value(frm, c, y) << 8)) != w[c]) {
+                        std::cout<<"Data not matched: frame "<<frm<<" comp "<<c<<" line "<<y<<std::endl;
+                        throw P_READ_FAILED;
+                    }
+                }
+            }
+            CheckFatalErrors(p_stream_release(stream));
+        }
+        if (expected != frm_nums + 1) {
+            throw P_READ_FAILED;
+        }
+        CheckFatalErrors(p_stream_close(stream));
+
+        /* holding all frames of the queue, and closing before the end */
+        CheckFatalErrors(p_stream_open(fname.c_str(), &header, 1, frm_nums, P_READ_Y,
+                                       y_w, y_h, y_w, 0, 2, &stream));
+        unsigned char *held[2];
+        int frm;
+        CheckFatalErrors(p_stream_next(stream, &frm, &held[0], NULL, NULL));
+        CheckFatalErrors(p_stream_next(stream, &frm, &held[1], NULL, NULL));
+        if ((frm != 2) || (held[0][0] != value(1, 0, 0)) || (held[1][0] != value(2, 0, 0))) {
+            throw P_READ_FAILED;
+        }
+        if (p_stream_next(stream, &frm, &held[0], NULL, NULL) != P_TOO_MANY_IMAGES) {
+            throw P_READ_FAILED;
+        }
+        CheckFatalErrors(p_stream_release(stream));
+        CheckFatalErrors(p_stream_next(stream, &frm, &held[0], NULL, NULL));
+        if ((frm != 3) || (held[0][y_w * 5] != value(3, 0, 5))) {
+            throw P_READ_FAILED;
+        }
+        CheckFatalErrors(p_stream_close(stream));
+        CheckFatalErrors(p_close_file(NULL));
+    } catch (pT_status e) {
+        m_is_test_ok = false;
+    }
+}
+
+void TestFunction::FileRecorder()
+{
+    try {
+        int frm_nums      = 40;
+        int y_w, y_h, uv_w, uv_h;
+        pT_header header;
+        std::string fname = "recorder.pfspd";
+        CheckFatalErrors(p_create_ext_header(&header, P_COLOR_420_PL, P_50HZ, P_QCIF, 0, 1, P_4_3));
+        CheckFatalErrors(p_mod_file_data_format(&header, P_10_BIT_FILE));
+        p_get_y_buffer_size(&header, &y_w, &y_h);
+        p_get_uv_buffer_size(&header, &uv_w, &uv_h);
+        CheckFatalErrors(p_write_header(fname.c_str(), &header));
+
+        /* capture as fast as possible: frames may be dropped */
+        pT_recorder *recorder;
+        CheckFatalErrors(p_recorder_open_16(fname.c_str(), &header, 1, P_10_BIT_MEM, y_w, y_h, y_w, uv_w, 3, &recorder));
+        std::vector<int> recorded;
+        int dropped = 0;
+        std::vector<unsigned short> y(y_w * y_h), u(uv_w * uv_h), v(uv_w * uv_h);
+        for (int frm = 1; frm <= frm_nums; frm++) {
+            std::fill(y.begin(), y.end(), (unsigned short)(frm * 20));
+            std::fill(u.begin(), u.end(), (unsigned short)(frm * 20 + 1));
+            std::fill(v.begin(), v.end(), (unsigned short)(frm * 20 + 2));
+            pT_status status = p_recorder_write_16(recorder, y.data(), u.data(), v.data());
+            if (status == P_OK) {
+                recorded.push_back(frm);
+            } else if (status == P_RECORDER_OVERFLOW) {
+                dropped++;
+            } else {
+                throw status;
+            }
+        }
+        int num_written, num_dropped;
+        p_recorder_get_counts(recorder, &num_written, &num_dropped);
+        if ((num_dropped != dropped) || (num_written > (int)recorded.size())) {
+            throw P_WRITE_FAILED;
+        }
+        CheckFatalErrors(p_recorder_close(recorder));
+        CheckFatalErrors(p_close_file(fname.c_str()));
+
+        /* the recorded frames are in the file, in order */
+        CheckFatalErrors(p_read_header(fname.c_str(), &header));
+        if (p_get_num_frames(&header) != (int)recorded.size()) {
+            throw P_READ_FAILED;
+        }
+        for (int i = 0; i < (int)recorded.size(); i++) {
+            CheckFatalErrors(p_read_frame_planar_16(fname.c_str(), &header, i + 1, y.data(), u.data(), v.data(),
+                                                    P_READ_ALL | P_10_BIT_MEM, y_w, y_h, y_w, uv_w));
+            if ((std::count(y.begin(), y.end(), (unsigned short)(recorded[i] * 20)) != y_w * y_h) ||
+                (std::count(u.begin(), u.end(), (unsigned short)(recorded[i] * 20 + 1)) != uv_w * uv_h) ||
+                (std::count(v.begin(), v.end(), (unsigned short)(recorded[i] * 20 + 2)) != uv_w * uv_h)) {
+                std::cout<<"Data not matched: frame "<<i + 1<<std::endl;
+                throw P_READ_FAILED;
+            }
+        }
+        CheckFatalErrors(p_close_file(fname.c_str()));
+
+        /* frames that fail to be written count as dropped */
+        CheckFatalErrors(p_recorder_open_16(fname.c_str(), &header, 0, P_10_BIT_MEM, y_w, y_h, y_w, uv_w, 3, &recorder));
+        int lost = 0;
+        for (int frm = 1; frm <= 3; frm++) {
+            pT_status status = p_recorder_write_16(recorder, y.data(), u.data(), v.data());
+            if ((status == P_OK) || (status == P_RECORDER_OVERFLOW)) {
+                lost++;
+            }
+        }
+        for (int wait = 0; wait < 1000; wait++) {
+            p_recorder_get_counts(recorder, &num_written, &num_dropped);
+            if (num_written + num_dropped >= lost) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if ((p_recorder_close(recorder) == P_OK) || (num_written != 0) || (num_dropped != lost)) {
+            std::cout<<"Recorder counts: "<<num_written<<" written, "<<num_dropped<<" dropped"<<std::endl;
+            throw P_WRITE_FAILED;
+        }
+        CheckFatalErrors(p_close_file(fname.c_str()));
+    } catch (pT_status e) {
+        m_is_test_ok = false;
+    }
+}
+
+void TestFunction::FileAsyncAccess()
+{
+    try {
+        int frm_nums      = 12;
+        int y_w, y_h, uv_w, uv_h;
+        pT_header header;
+        std::string fname = "async.pfspd";
+        CheckFatalErrors(p_set_num_threads(4));
+        CheckFatalErrors(p_create_ext_header(&header, P_COLOR_420_PL, P_50HZ, P_QCIF, 0, 1, P_4_3));
+        CheckFatalErrors(p_mod_num_frames(&header, frm_nums));
+        p_get_y_buffer_size(&header, &y_w, &y_h);
+        p_get_uv_buffer_size(&header, &uv_w, &uv_h);
+        CheckFatalErrors(p_write_header(fname.c_str(), &header));
+
+        /* completion callback: counts the accesses that succeeded */
+        struct Done {
+            std::atomic<int> ok{0};
+            std::atomic<int> failed{0};
+        } done;
+        auto callback = [](pT_status status, void *user_data) {
+            Done *d = (Done *)user_data;
+            if (status == P_OK) {
+                d->ok++;
+            } else {
+                d->failed++;
+            }
+        };
+
+        /* write all frames at once, in reverse order */
+        std::vector<std::vector<unsigned char>> data[3];
+        std::vector<pT_async *> tokens;
+        for (int frm = frm_nums; frm >= 1; frm--) {
+            for (int c = 0; c < 3; c++) {
+                data[c].push_back(std::vector<unsigned char>(c ? uv_w * uv_h : y_w * y_h, (unsigned char)(frm * 10 + c)));
+            }
+            pT_async *token;
+            CheckFatalErrors(p_write_frame_async(fname.c_str(), &header, frm,
+                                                 data[0].back().data(), data[1].back().data(), data[2].back().data(),
+                                                 y_w, y_h, y_w, uv_w, callback, &done, &token));
+            tokens.push_back(token);
+        }
+        for (auto token : tokens) {
+            CheckFatalErrors(p_async_wait(token));
+        }
+        CheckFatalErrors(p_close_file(fname.c_str()));
+        if ((done.ok != frm_nums) || (done.failed != 0)) {
+            throw P_WRITE_FAILED;
+        }
+
+        /* read with tokens, and with a callback only */
+        CheckFatalErrors(p_read_header(fname.c_str(), &header));
+        done.ok = 0;
+        std::vector<std::vector<unsigned short>> bufs_16(frm_nums, std::vector<unsigned short>(y_w * y_h));
+        std::vector<std::vector<unsigned char>> bufs(frm_nums, std::vector<unsigned char>(y_w * y_h));
+        tokens.clear();
+        for (int frm = 1; frm <= frm_nums; frm++) {
+            pT_async *token;
+            CheckFatalErrors(p_read_frame_async_16(fname.c_str(), &header, frm, bufs_16[frm - 1].data(), NULL, NULL,
+                                                   P_READ_Y | P_16_BIT_MEM, y_w, y_h, y_w, 0, NULL, NULL, &token));
+            tokens.push_back(token);
+            CheckFatalErrors(p_read_frame_async(fname.c_str(), &header, frm, bufs[frm - 1].data(), NULL, NULL,
+                                                P_READ_Y, y_w, y_h, y_w, 0, callback, &done, NULL));
+        }
+        for (auto token : tokens) {
+            while (!p_async_done(token)) {
+                std::this_thread::yield();
+            }
+            CheckFatalErrors(p_async_wait(token));
+        }
+        while (done.ok + done.failed < frm_nums) {
+            std::this_thread::yield();
+        }
+        if (done.failed != 0) {
+            throw P_READ_FAILED;
+        }
+        for (int frm = 1; frm <= frm_nums; frm++) {
+            if ((std::count(bufs[frm - 1].begin(), bufs[frm - 1].end(), (unsigned char)(frm * 10)) != y_w * y_h) ||
+                (std::count(bufs_16[frm - 1].begin(), bufs_16[frm - 1].end(), (unsigned short)(frm * 10 << 8)) != y_w * y_h)) {
+                std::cout<<"Data not matched: frame "<<frm<<std::endl;
+                throw P_READ_FAILED;
+            }
+        }
+
+        /* a failing access reports its status */
+        pT_async *token;
+        CheckFatalErrors(p_read_frame_async(fname.c_str(), &header, frm_nums + 1, bufs[0].data(), NULL, NULL,
+                                            P_READ_Y, y_w, y_h, y_w, 0, NULL, NULL, &token));
+        if (p_async_wait(token) == P_OK) {
+            throw P_READ_FAILED;
+        }
+        CheckFatalErrors(p_close_file(NULL));
+        CheckFatalErrors(p_set_num_threads(0));
+    } catch (pT_status e) {
+        p_set_num_threads(0);
+        m_is_test_ok = false;
+    }
+}
+
+void TestFunction::FileAsyncStdin()
+{
+    try {
+        int frm_nums      = 8;
+        int y_w, y_h, uv_w, uv_h;
+        pT_header header;
+        std::string fname = "async_stdin.pfspd";
+        CheckFatalErrors(p_create_ext_header(&header, P_COLOR_420_PL, P_50HZ, P_QCIF, 0, 1, P_4_3));
+        CheckFatalErrors(p_mod_num_frames(&header, frm_nums));
+        p_get_y_buffer_size(&header, &y_w, &y_h);
+        p_get_uv_buffer_size(&header, &uv_w, &uv_h);
+        CheckFatalErrors(p_write_header(fname.c_str(), &header));
+        for (int frm = 1; frm <= frm_nums; frm++) {
+            std::vector<unsigned char> y(y_w * y_h, (unsigned char)(frm * 10));
+            std::vector<unsigned char> uv(uv_w * uv_h, (unsigned char)(frm * 10 + 1));
+            CheckFatalErrors(p_write_frame_planar(fname.c_str(), &header, frm, y.data(), uv.data(), uv.data(),
+                                                  y_w, y_h, y_w, uv_w));
+        }
+        CheckFatalErrors(p_close_file(fname.c_str()));
+
+        /* read consecutive frames from standard input, skipping the first one */
+        if (freopen(fname.c_str(), "rb", stdin) == NULL) {
+            throw P_FILE_OPEN_FAILED;
+        }
+        CheckFatalErrors(p_set_num_threads(4));
+        CheckFatalErrors(p_read_header("-", &header));
+        std::vector<unsigned char> y(y_w * y_h);
+        std::vector<unsigned char> u(uv_w * uv_h);
+        std::vector<unsigned char> v(uv_w * uv_h);
+        for (int frm = 2; frm <= frm_nums; frm++) {
+            pT_async *token;
+            CheckFatalErrors(p_read_frame_async("-", &header, frm, y.data(), u.data(), v.data(),
+                                                P_READ_ALL, y_w, y_h, y_w, uv_w, NULL, NULL, &token));
+            CheckFatalErrors(p_async_wait(token));
+            if ((std::count(y.begin(), y.end(), (unsigned char)(frm * 10)) != y_w * y_h) ||
+                (std::count(u.begin(), u.end(), (unsigned char)(frm * 10 + 1)) != uv_w * uv_h) ||
+                (std::count(v.begin(), v.end(), (unsigned char)(frm * 10 + 1)) != uv_w * uv_h)) {
+                std::cout<<"Data not matched: frame "<<frm<<std::endl;
+                throw P_READ_FAILED;
+            }
+        }
+        CheckFatalErrors(p_set_num_threads(0));
+    } catch (pT_status e) {
+        p_set_num_threads(0);
+        m_is_test_ok = false;
+    }
+}
+
+void TestFunction::FileContext()
+{
+    pT_context *contexts[2] = {NULL, NULL};
+    try {
+        int num_contexts  = 2;
+        int frm_nums      = 8;
+        int w, h;
+        pT_header header;
+        CheckFatalErrors(p_set_num_threads(4));
+        CheckFatalErrors(p_create_ext_header(&header, P_NO_COLOR, P_50HZ, P_QCIF, 0, 1, P_4_3));
+        CheckFatalErrors(p_mod_num_frames(&header, frm_nums));
+        p_get_comp_buffer_size(&header, 0, &w, &h);
+
+        /* each context has its own settings */
+        for (int i = 0; i < num_contexts; i++) {
+            CheckFatalErrors(p_context_create(&contexts[i]));
+            if (p_context_select(contexts[i]) != (i ? contexts[i - 1] : NULL)) {
+                throw P_FILE_OPEN_FAILED;
+            }
+            CheckFatalErrors(p_set_max_open_files(2));
+        }
+        if ((p_context_current() != contexts[num_contexts - 1]) ||
+            (p_context_select(NULL) != contexts[num_contexts - 1]) ||
+            (p_get_max_open_files() != 10)) {
+            throw P_FILE_OPEN_FAILED;
+        }
+
+        /* each thread writes a handle and a named file in its own context;
+           the records of one context are not taken by another */
+        std::vector<std::thread> threads;
+        std::atomic<int> failed{0};
+        for (int i = 0; i < num_contexts; i++) {
+            threads.push_back(std::thread([&, i]() {
+                pT_file *file = NULL;
+                std::string hname = "context_h" + std::to_string(i) + ".pfspd";
+                std::string fname = "context_" + std::to_string(i) + ".pfspd";
+                std::vector<unsigned char> data(w * h);
+                pT_header local_header = header;
+                p_context_select(contexts[i]);
+                if ((p_write_header(hname.c_str(), &local_header) != P_OK) ||
+                    (p_write_header(fname.c_str(), &local_header) != P_OK) ||
+                    (p_file_open(hname.c_str(), 1, &file) != P_OK)) {
+                    failed++;
+                    return;
+                }
+                for (int frm = 1; frm <= frm_nums; frm++) {
+                    std::fill(begin(data), end(data), (unsigned char)(i * 16 + frm));
+                    if ((p_file_write_frame_comp(file, frm, 0, data.data(), w, h, w) != P_OK) ||
+                        (p_write_frame_comp(fname.c_str(), &local_header, frm, 0, data.data(), w, h, w) != P_OK)) {
+                        failed++;
+                    }
+                }
+                if (p_file_close(file) != P_OK) {
+                    failed++;
+                }
+                p_context_select(NULL);
+            }));
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        if (failed != 0) {
+            throw P_WRITE_FAILED;
+        }
+
+        /* the worker threads read in the context of the caller */
+        std::vector<unsigned char> frames(frm_nums * w * h);
+        std::vector<unsigned char *> ptrs;
+        for (int frm = 0; frm < frm_nums; frm++) {
+            ptrs.push_back(frames.data() + frm * w * h);
+        }
+        for (int i = 0; i < num_contexts; i++) {
+            std::string fname = "context_" + std::to_string(i) + ".pfspd";
+            p_context_select(contexts[i]);
+            CheckFatalErrors(p_read_header(fname.c_str(), &header));
+            CheckFatalErrors(p_read_frames(fname.c_str(), &header, 1, frm_nums, NULL, ptrs.data(), NULL, NULL,
+                                           P_READ_Y, w, h, w, 0));
+            for (int frm = 1; frm <= frm_nums; frm++) {
+                if (std::count(frames.begin() + (frm - 1) * w * h, frames.begin() + frm * w * h,
+                               (unsigned char)(i * 16 + frm)) != w * h) {
+                    std::cout<<"Data not matched: "<<fname<<" "<<frm<<std::endl;
+                    throw P_READ_FAILED;
+                }
+            }
+            /* destroying the context closes its files */
+            p_context_select(NULL);
+            CheckFatalErrors(p_context_destroy(contexts[i]));
+            contexts[i] = NULL;
+            CheckFatalErrors(p_read_header(fname.c_str(), &header));
+            if (p_get_num_frames(&header) != frm_nums) {
+                throw P_READ_FAILED;
+            }
+        }
+        CheckFatalErrors(p_close_file(NULL));
+        CheckFatalErrors(p_set_num_threads(0));
+    } catch (pT_status e) {
+        p_context_select(NULL);
+        for (int i = 0; i < 2; i++) {
+            p_context_destroy(contexts[i]);
+        }
+        p_set_num_threads(0);
+        m_is_test_ok = false;
+    }
+}
+
+void TestFunction::FileConvertRead()
+{
+    try {
+        const pT_data_fmt file_fmts[] = {P_8_BIT_FILE, P_10_BIT_FILE, P_12_BIT_FILE, P_14_BIT_FILE, P_16_BIT_FILE};
+        const int file_bits[]         = {8, 10, 12, 14, 16};
+        const int mem_fmts[]          = {P_8_BIT_MEM, P_10_BIT_MEM, P_12_BIT_MEM, P_14_BIT_MEM, P_16_BIT_MEM, P_16_BIT_MEM_LSB};
+        const int mem_bits[]          = {8, 10, 12, 14, 16, 16};
+        std::string fname = "convert.pfspd";
+        int w, h;
+        RBE rbe;
+        for (int f = 0; f < 5; f++) {
+            for (int big_endian = 0; big_endian <= (file_bits[f] > 8); big_endian++) {
+                pT_header header;
+                CheckFatalErrors(p_create_ext_header(&header, P_NO_COLOR, P_50HZ, P_QCIF, 0, 1, P_4_3));
+                CheckFatalErrors(p_mod_file_data_format(&header, file_fmts[f]));
+                p_get_comp_buffer_size(&header, 0, &w, &h);
+                std::vector<unsigned short> frame(w * h);
+                CheckFatalErrors(p_write_header(fname.c_str(), &header));
+                CheckFatalErrors(p_write_frame_comp_16(fname.c_str(), &header, 1, 0, frame.data(), P_16_BIT_MEM, w, h, w));
+                CheckFatalErrors(p_close_file(fname.c_str()));
+
+                /* file samples with all bits in use, in either byte order */
+                const size_t el_size = (file_bits[f] > 8) ? 2 : 1;
+                std::vector<unsigned char> data(w * h * el_size);
+                for (size_t i = 0; i < frame.size(); i++) {
+                    frame[i] = (unsigned short)((rbe() << 8 | rbe()) & ((el_size == 2) ? 0xffff : 0xff));
+                    if (el_size == 1) {
+                        data[i] = (unsigned char)frame[i];
+                    } else {
+                        data[2 * i + big_endian]     = (unsigned char)frame[i];
+                        data[2 * i + 1 - big_endian] = (unsigned char)(frame[i] >> 8);
+                    }
+                }
+                FILE *fp = fopen(fname.c_str(), "rb+");
+                if (fp == NULL) {
+                    throw P_FILE_OPEN_FAILED;
+                }
+                fseek(fp, -(long)data.size(), SEEK_END);
+                fwrite(data.data(), 1, data.size(), fp);
+                if (big_endian) {
+                    fseek(fp, P_SNR_IMAGES + P_SNR_COMPON + P_SNR_FD_RECS + P_SNR_AUXDAT_RECS + P_SAPPL_TYPE + P_SBYTES_REC, SEEK_SET);
+                    fputc('A', fp);
+                }
+                fclose(fp);
+                CheckFatalErrors(p_read_header(fname.c_str(), &header));
+
+                /* widths that leave a part of a vector for the scalar code */
+                for (int width = w - 21; width <= w; width += 21) {
+                    for (int m = 0; m < 6; m++) {
+                        std::vector<unsigned char> buf_8(w * h);
+                        std::vector<unsigned short> buf_16(w * h);
+                        CheckFatalErrors(p_read_frame_comp(fname.c_str(), &header, 1, 0, buf_8.data(), mem_fmts[m], width, h, w));
+                        CheckFatalErrors(p_read_frame_comp_16(fname.c_str(), &header, 1, 0, buf_16.data(), mem_fmts[m], width, h, w));
+                        for (int y = 0; y < h; y++) {
+                            for (int x = 0; x < width; x++) {
+                                unsigned int sample = frame[y * w + x] & ((1u << file_bits[f]) - 1);
+                                if (mem_bits[m] > file_bits[f]) {
+                                    sample <<= mem_bits[m] - file_bits[f];
+                                } else {
+                                    sample >>= file_bits[f] - mem_bits[m];
+                                }
+                                sample &= (mem_fmts[m] == P_16_BIT_MEM_LSB) ? 0x00ff : 0xffff;
+                                /* 8 bit file samples are copied into 8 bit memory */
+                                /* and 16 bit samples in the system byte order of the same width */
+                                const bool copied_16 = (file_bits[f] > 8) && (file_bits[f] == mem_bits[m]) && !big_endian;
+                                if ((buf_8[y * w + x] != ((file_bits[f] == 8) ? frame[y * w + x] : (unsigned char)sample)) ||
+                                    (buf_16[y * w + x] != (copied_16 ? frame[y * w + x] : (unsigned short)sample))) {
+                                    std::cout<<"Data not matched: file bits "<<file_bits[f]<<" mem bits "<<mem_bits[m]
+                                             <<" big endian "<<big_endian<<" x "<<x<<std::endl;
+                                    throw P_READ_FAILED;
+                                }
+                            }
+                        }
+                    }
+                }
+                CheckFatalErrors(p_close_file(fname.c_str()));
+            }
+        }
+    } catch (pT_status e) {
+        m_is_test_ok = false;
+    }
+}
+
+void TestFunction::FileConvertWrite()
+{
+    try {
+        const pT_data_fmt file_fmts[] = {P_8_BIT_FILE, P_10_BIT_FILE, P_12_BIT_FILE, P_14_BIT_FILE, P_16_BIT_FILE};
+        const int file_bits[]         = {8, 10, 12, 14, 16};
+        const int mem_fmts[]          = {P_8_BIT_MEM, P_10_BIT_MEM, P_12_BIT_MEM, P_14_BIT_MEM, P_16_BIT_MEM};
+        const int mem_bits[]          = {8, 10, 12, 14, 16};
+        std::string fname = "convert.pfspd";
+        int w, h;
+        RBE rbe;
+        for (int f = 0; f < 5; f++) {
+            for (int big_endian = 0; big_endian <= (file_bits[f] > 8); big_endian++) {
+                pT_header header;
+                /* a line width that leaves a part of a vector for the scalar code */
+                CheckFatalErrors(p_create_ext_header(&header, P_NO_COLOR, P_50HZ, P_QCIF, 0, 1, P_4_3));
+                CheckFatalErrors(p_mod_image_size(&header, 171, 144));
+                CheckFatalErrors(p_mod_file_data_format(&header, file_fmts[f]));
+                p_get_comp_buffer_size(&header, 0, &w, &h);
+                const size_t el_size = (file_bits[f] > 8) ? 2 : 1;
+                std::vector<unsigned char> data(w * h * el_size);
+                CheckFatalErrors(p_write_header(fname.c_str(), &header));
+                CheckFatalErrors(p_write_frame_comp(fname.c_str(), &header, 1, 0, data.data(), w, h, w));
+                CheckFatalErrors(p_close_file(fname.c_str()));
+                if (big_endian) {
+                    /* existing big endian files are written in their own byte order */
+                    FILE *fp = fopen(fname.c_str(), "rb+");
+                    if (fp == NULL) {
+                        throw P_FILE_OPEN_FAILED;
+                    }
+                    fseek(fp, P_SNR_IMAGES + P_SNR_COMPON + P_SNR_FD_RECS + P_SNR_AUXDAT_RECS + P_SAPPL_TYPE + P_SBYTES_REC, SEEK_SET);
+                    fputc('A', fp);
+                    fclose(fp);
+                }
+                CheckFatalErrors(p_read_header(fname.c_str(), &header));
+
+                /* memory samples with all bits in use */
+                const int width = w;
+                for (int m = -1; m < 5; m++) {
+                    std::vector<unsigned char> frame_8(w * h);
+                    std::vector<unsigned short> frame_16(w * h);
+                    for (size_t i = 0; i < frame_16.size(); i++) {
+                        frame_8[i]  = rbe();
+                        frame_16[i] = (unsigned short)(rbe() << 8 | rbe());
+                    }
+                    if (m < 0) {
+                        CheckFatalErrors(p_write_frame_comp(fname.c_str(), &header, 1, 0, frame_8.data(), width, h, w));
+                    } else {
+                        CheckFatalErrors(p_write_frame_comp_16(fname.c_str(), &header, 1, 0, frame_16.data(), mem_fmts[m], width, h, w));
+                    }
+                    CheckFatalErrors(p_close_file(fname.c_str()));
+
+                    FILE *fp = fopen(fname.c_str(), "rb");
+                    if (fp == NULL) {
+                        throw P_FILE_OPEN_FAILED;
+                    }
+                    fseek(fp, -(long)data.size(), SEEK_END);
+                    if (fread(data.data(), 1, data.size(), fp) != data.size()) {
+                        fclose(fp);
+                        throw P_READ_FAILED;
+                    }
+                    fclose(fp);
+
+                    const int bits = (m < 0) ? 8 : mem_bits[m];
+                    for (int y = 0; y < h; y++) {
+                        for (int x = 0; x < width; x++) {
+                            const unsigned int mem_sample = (m < 0) ? frame_8[y * w + x] : frame_16[y * w + x];
+                            unsigned int sample = mem_sample & ((1u << bits) - 1);
+                            unsigned int file_sample;
+                            if (file_bits[f] > bits) {
+                                sample <<= file_bits[f] - bits;
+                            } else {
+                                sample >>= bits - file_bits[f];
+                            }
+                            /* samples of the same width in the system byte order are copied */
+                            if ((file_bits[f] == bits) && !big_endian && ((m < 0) == (el_size == 1))) {
+                                sample = mem_sample;
+                            }
+                            if (el_size == 1) {
+                                file_sample = data[y * w + x];
+                                sample &= 0xff;
+                            } else {
+                                file_sample = data[2 * (y * w + x) + big_endian] |
+                                              data[2 * (y * w + x) + 1 - big_endian] << 8;
+                                sample &= 0xffff;
+                            }
+                            if (file_sample != sample) {
+                                std::cout<<"Data not matched: file bits "<<file_bits[f]<<" mem bits "<<bits
+                                         <<" big endian "<<big_endian<<" x "<<x<<std::endl;
+                                throw P_WRITE_FAILED;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    } catch (pT_status e) {
+        m_is_test_ok = false;
+    }
+}
+
+void TestFunction::FileConvertIsa()
+{
+    try {
+        const pT_isa detected = p_get_conversion_isa();
+        if ((detected == P_ISA_AUTO) || (p_set_conversion_isa(detected) != P_OK)) {
+            throw P_ISA_NOT_SUPPORTED;
+        }
+        /* every instruction set gives the results of the scalar code */
+        for (int i = P_ISA_NONE; i <= P_ISA_NEON; i++) {
+            const pT_isa isa = (pT_isa)i;
+            if (p_set_conversion_isa(isa) != P_OK) {
+                continue;
+            }
+            if (p_get_conversion_isa() != isa) {
+                throw P_ISA_NOT_SUPPORTED;
+            }
+            FileConvertRead();
+            if (m_is_test_ok) {
+                FileConvertWrite();
+            }
+            if (!m_is_test_ok) {
+                std::cout<<"Conversion failed for instruction set "<<i<<std::endl;
+                throw P_READ_FAILED;
+            }
+        }
+        CheckFatalErrors(p_set_conversion_isa(P_ISA_AUTO));
+        if (p_get_conversion_isa() != detected) {
+            throw P_ISA_NOT_SUPPORTED;
+        }
+    } catch (pT_status e) {
+        (void)p_set_conversion_isa(P_ISA_AUTO);
+        m_is_test_ok = false;
+    }
+}
+
+void TestFunction::FileInterlacedRead()
+{
+    try {
+        pT_header header;
+        int frm_nums      = 2;
+        std::string fname = "interlaced.pfspd";
+        CheckFatalErrors(p_set_num_threads(4));
+        CheckFatalErrors(p_create_ext_header(&header, P_COLOR_420_PL, P_50HZ, P_QCIF, 0, 0, P_4_3));
+        CheckFatalErrors(p_mod_file_data_format(&header, P_10_BIT_FILE));
+        CheckFatalErrors(p_write_header(fname.c_str(), &header));
+        const int w[3]  = {p_get_frame_width(&header), p_get_frame_width(&header) / 2, p_get_frame_width(&header) / 2};
+        const int fh[3] = {p_get_frame_height(&header) / 2, p_get_frame_height(&header) / 4, p_get_frame_height(&header) / 4};
+        /* strides larger than the width */
+        const int stride    = w[0] + 8;
+        const int uv_stride = w[1] + 4;
+        const int strides[3] = {stride, uv_stride, uv_stride};
+        RBE rbe;
+        /* fields[frame][field][comp], stored with the width as stride */
+        std::vector<unsigned short> fields[2][2][3];
+        for (int frm = 1; frm <= frm_nums; frm++) {
+            for (int fld = 1; fld <= 2; fld++) {
+                for (int c = 0; c < 3; c++) {
+                    fields[frm - 1][fld - 1][c].resize(w[c] * fh[c]);
+                    for (auto &sample : fields[frm - 1][fld - 1][c]) {
+                        sample = (unsigned short)((rbe() << 2 | rbe() >> 6) & 0x03ff);
+                    }
+                }
+                CheckFatalErrors(p_write_field_planar_16(fname.c_str(), &header, frm, fld,
+                                                         fields[frm - 1][fld - 1][0].data(),
+                                                         fields[frm - 1][fld - 1][1].data(),
+                                                         fields[frm - 1][fld - 1][2].data(),
+                                                         P_10_BIT_MEM, w[0], fh[0], w[0], w[1]));
+            }
+        }
+        CheckFatalErrors(p_close_file(fname.c_str()));
+        CheckFatalErrors(p_read_header(fname.c_str(), &header));
+
+        /* the lines of the frame alternate between the fields */
+        auto check = [&](int frm, int c, const void *buf, int el_size, int shift) {
+            for (int y = 0; y < 2 * fh[c]; y++) {
+                const std::vector<unsigned short> &field = fields[frm - 1][y & 1][c];
+                for (int x = 0; x < w[c]; x++) {
+                    const unsigned int expected = (shift >= 0) ? field[(y >> 1) * w[c] + x] << shift
+                                                               : field[(y >> 1) * w[c] + x] >> -shift;
+                    const unsigned int sample = (el_size == 1) ? ((const unsigned char *)buf)[y * strides[c] + x]
+                                                               : ((const unsigned short *)buf)[y * strides[c] + x];
+                    if (sample != (expected & ((el_size == 1) ? 0xff : 0xffff))) {
+                        std::cout<<"Data not matched: frame "<<frm<<" comp "<<c<<" line "<<y<<" x "<<x<<std::endl;
+                        throw P_READ_FAILED;
+                    }
+                }
+            }
+        };
+        for (int parallel = 0; parallel <= 1; parallel++) {
+            CheckFatalErrors(p_set_parallel_conversion(parallel));
+            for (int frm = 1; frm <= frm_nums; frm++) {
+                std::vector<unsigned short> frame_16[3];
+                std::vector<unsigned char> frame_8[3];
+                for (int c = 0; c < 3; c++) {
+                    frame_16[c].assign(strides[c] * 2 * fh[c], 0);
+                    frame_8[c].assign(strides[c] * 2 * fh[c], 0);
+                }
+                /* copied, converted to 16 bits and to 8 bits */
+                CheckFatalErrors(p_read_frame_planar_16(fname.c_str(), &header, frm,
+                                                        frame_16[0].data(), frame_16[1].data(), frame_16[2].data(),
+                                                        P_READ_ALL | P_10_BIT_MEM, w[0], 2 * fh[0], stride, uv_stride));
+                for (int c = 0; c < 3; c++) {
+                    check(frm, c, frame_16[c].data(), 2, 0);
+                }
+                CheckFatalErrors(p_read_frame_planar_16(fname.c_str(), &header, frm,
+                                                        frame_16[0].data(), frame_16[1].data(), frame_16[2].data(),
+                                                        P_READ_ALL | P_16_BIT_MEM, w[0], 2 * fh[0], stride, uv_stride));
+                for (int c = 0; c < 3; c++) {
+                    check(frm, c, frame_16[c].data(), 2, 6);
+                }
+                CheckFatalErrors(p_read_frame_planar(fname.c_str(), &header, frm,
+                                                     frame_8[0].data(), frame_8[1].data(), frame_8[2].data(),
+                                                     P_READ_ALL, w[0], 2 * fh[0], stride, uv_stride));
+                for (int c = 0; c < 3; c++) {
+                    check(frm, c, frame_8[c].data(), 1, -2);
+                }
+            }
+        }
+        CheckFatalErrors(p_close_file(fname.c_str()));
+
+        /* through a handle, and from file data in memory */
+        pT_file *file;
+        CheckFatalErrors(p_file_open(fname.c_str(), 0, &file));
+        std::vector<unsigned short> frame_16(stride * 2 * fh[0]);
+        CheckFatalErrors(p_file_read_frame_planar_16(file, 2, frame_16.data(), NULL, NULL, P_READ_Y | P_16_BIT_MEM,
+                                                     w[0], 2 * fh[0], stride, 0));
+        check(2, 0, frame_16.data(), 2, 6);
+        CheckFatalErrors(p_file_close(file));
+        std::vector<std::vector<unsigned short>> bufs(frm_nums, std::vector<unsigned short>(stride * 2 * fh[0]));
+        std::vector<unsigned short *> ptrs;
+        for (int i = 0; i < frm_nums; i++) {
+            ptrs.push_back(bufs[i].data());
+        }
+        CheckFatalErrors(p_read_frames_16(fname.c_str(), &header, 1, frm_nums, NULL, ptrs.data(), NULL, NULL,
+                                          P_READ_Y | P_10_BIT_MEM, w[0], 2 * fh[0], stride, 0));
+        for (int frm = 1; frm <= frm_nums; frm++) {
+            check(frm, 0, bufs[frm - 1].data(), 2, 0);
+        }
+        CheckFatalErrors(p_close_file(fname.c_str()));
+        CheckFatalErrors(p_set_parallel_conversion(0));
+        CheckFatalErrors(p_set_num_threads(0));
+    } catch (pT_status e) {
+        p_set_parallel_conversion(0);
+        p_set_num_threads(0);
+        m_is_test_ok = false;
+    }
+}
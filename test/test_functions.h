@@ -26,6 +26,27 @@ class TestFunction
     ~TestFunction();
     void FileWrite();
     void FileRead();
+    void FileMapRead();
+    void FileMapWrite();
+    void FileAccessWriteRead(int access_mode);
+    void FilePreallocate();
+    void FileManyOpen(int max_files);
+    void FileHandle();
+    void FileThreads(int max_files);
+    void FileConcurrentRead();
+    void FileReadFrames(int progressive);
+    void FileReadFramesStdin(int progressive);
+    void FileParallelConversion();
+    void FileParallelComponents();
+    void FileStreamRead();
+    void FileRecorder();
+    void FileAsyncAccess();
+    void FileAsyncStdin();
+    void FileContext();
+    void FileConvertRead();
+    void FileConvertWrite();
+    void FileConvertIsa();
+    void FileInterlacedRead();
     bool IsTeskOk(){return m_is_test_ok;}
 
     private: